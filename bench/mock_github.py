@@ -0,0 +1,417 @@
+#!/usr/bin/env python3
+"""本地模拟的 GitHub Releases API，用于离线测试 manage 的吞吐和重试行为。
+
+实现 manage 用到的接口：
+  GET    /repos/{owner}/{repo}/releases              （分页，带 Link 头）
+  GET    /repos/{owner}/{repo}/releases/tags/{tag}
+  GET    /repos/{owner}/{repo}/releases/{id}
+  POST   /repos/{owner}/{repo}/releases
+  POST   /repos/{owner}/{repo}/releases/{id}/assets?name=...   （上传，upload_url 指向本服务）
+  GET    /repos/{owner}/{repo}/releases/assets/{id}     （Accept 为 application/octet-stream 时重定向到下载地址）
+  PATCH  /repos/{owner}/{repo}/releases/assets/{id}
+  DELETE /repos/{owner}/{repo}/releases/assets/{id}
+  GET    /download/{id}/{name}                         （browser_download_url，返回上传的内容）
+以及测试用的 GET /_stats（请求数、注入的错误数、收发的字节数）。
+
+不超过 --keep-data 的资产在内存中保留内容供下载；更大的资产只计算 SHA-256 后丢弃，
+可以用来模拟 GB 级文件的上传，但不能下载。
+
+示例：
+  python3 bench/mock_github.py --port 0 --port-file /tmp/port --latency-ms 20 --bandwidth 50M --error-rate 0.1
+"""
+
+import argparse
+import hashlib
+import json
+import random
+import re
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, quote, unquote, urlparse
+
+READ_CHUNK = 64 * 1024
+
+
+def parse_size(value):
+    """解析 10M、1.5G 这类带单位的字节数，0 表示不限速。"""
+    units = {"": 1, "K": 1 << 10, "M": 1 << 20, "G": 1 << 30}
+    m = re.fullmatch(r"\s*([0-9.]+)\s*([KMG]?)i?B?\s*", value, re.IGNORECASE)
+    if not m:
+        raise argparse.ArgumentTypeError("无效的大小: %s" % value)
+    return int(float(m.group(1)) * units[m.group(2).upper()])
+
+
+class State:
+    def __init__(self, args):
+        self.lock = threading.Lock()
+        self.args = args
+        self.random = random.Random(args.seed)
+        self.next_id = 1
+        self.releases = []
+        self.contents = {}  # 资产 id -> 上传的内容（只保留不超过 --keep-data 的资产）
+        self.stats = {"requests": 0, "errors": 0, "uploads": 0, "deletes": 0, "downloads": 0,
+                      "bytes_received": 0, "bytes_sent": 0}
+        for i in range(args.releases):
+            self.new_release("v%d" % (i + 1))
+
+    def new_id(self):
+        with self.lock:
+            value = self.next_id
+            self.next_id += 1
+            return value
+
+    def new_release(self, tag, name=None, prerelease=False):
+        release = {
+            "id": self.new_id(),
+            "tag_name": tag,
+            "name": name or tag,
+            "draft": False,
+            "prerelease": prerelease,
+            "assets": [],
+        }
+        with self.lock:
+            self.releases.insert(0, release)
+        return release
+
+    def find_release(self, release_id):
+        for release in self.releases:
+            if release["id"] == release_id:
+                return release
+        return None
+
+    def find_asset(self, asset_id):
+        for release in self.releases:
+            for asset in release["assets"]:
+                if asset["id"] == asset_id:
+                    return release, asset
+        return None, None
+
+    def should_fail(self):
+        with self.lock:
+            return self.args.error_rate > 0 and self.random.random() < self.args.error_rate
+
+    def count(self, key, amount=1):
+        with self.lock:
+            self.stats[key] += amount
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "mock-github/1.0"
+    # 响应头和响应体分两次写出，不关 Nagle 的话每个请求都会多等一个延迟 ACK（约 40ms）
+    disable_nagle_algorithm = True
+    state = None
+
+    def log_message(self, fmt, *args):
+        if self.state.args.verbose:
+            sys.stderr.write("%s - %s\n" % (self.address_string(), fmt % args))
+
+    # ---------- 公共部分 ----------
+
+    def base_url(self):
+        host = self.headers.get("Host") or "%s:%d" % self.server.server_address[:2]
+        return "http://%s" % host
+
+    def release_json(self, release):
+        owner, repo = self.path_owner, self.path_repo
+        data = {k: v for k, v in release.items() if k != "assets"}
+        data["upload_url"] = "%s/repos/%s/%s/releases/%d/assets{?name,label}" % (
+            self.base_url(), owner, repo, release["id"])
+        data["assets"] = [dict(a) for a in release["assets"]]
+        return data
+
+    def send_json(self, code, obj=None, headers=None):
+        body = b"" if obj is None else json.dumps(obj).encode()
+        self.send_response(code)
+        if obj is not None:
+            self.send_header("Content-Type", "application/json; charset=utf-8")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("X-RateLimit-Limit", "5000")
+        self.send_header("X-RateLimit-Remaining", "4999")
+        self.send_header("X-RateLimit-Reset", str(int(time.time()) + 3600))
+        for key, value in (headers or {}).items():
+            self.send_header(key, value)
+        self.end_headers()
+        self.throttled_write(body)
+
+    def send_page(self, items, to_json):
+        """按 page/per_page 返回列表的一页，和 GitHub 一样用 Link 头给出下一页和最后一页。"""
+        page = int(self.query.get("page", ["1"])[0])
+        per_page = min(int(self.query.get("per_page", ["30"])[0]), 100)
+        chunk = items[(page - 1) * per_page:page * per_page]
+        headers = {}
+        if page * per_page < len(items):
+            last = (len(items) + per_page - 1) // per_page
+            base = "%s%s?per_page=%d" % (self.base_url(), urlparse(self.path).path, per_page)
+            headers["Link"] = '<%s&page=%d>; rel="next", <%s&page=%d>; rel="last"' % (
+                base, page + 1, base, last)
+        return self.send_json(200, [to_json(item) for item in chunk], headers)
+
+    def throttle(self, started, transferred):
+        bandwidth = self.state.args.bandwidth
+        if bandwidth > 0:
+            ahead = transferred / bandwidth - (time.monotonic() - started)
+            if ahead > 0:
+                time.sleep(ahead)
+
+    def throttled_write(self, body):
+        started = time.monotonic()
+        for offset in range(0, len(body), READ_CHUNK):
+            self.wfile.write(body[offset:offset + READ_CHUNK])
+            self.throttle(started, offset + READ_CHUNK)
+
+    def read_body(self, digest=None, keep=None):
+        """按带宽限制读取请求体，返回读到的字节数；digest 非 None 时同时计算哈希，
+        keep 非 None 时把数据块追加到这个列表中。"""
+        started = time.monotonic()
+        total = 0
+        if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+            while True:
+                size = int(self.rfile.readline().split(b";")[0].strip(), 16)
+                if size == 0:
+                    self.rfile.readline()
+                    break
+                total += self.read_exact(size, digest, keep, started, total)
+                self.rfile.readline()
+        else:
+            length = int(self.headers.get("Content-Length") or 0)
+            total = self.read_exact(length, digest, keep, started, 0)
+        self.state.count("bytes_received", total)
+        return total
+
+    def read_exact(self, length, digest, keep, started, already):
+        remaining = length
+        while remaining > 0:
+            chunk = self.rfile.read(min(remaining, READ_CHUNK))
+            if not chunk:
+                break
+            if digest is not None:
+                digest.update(chunk)
+            if keep is not None and not self.discarded:
+                # 超过 --keep-data 后不再保留，只继续计算哈希
+                if already + length - remaining + len(chunk) > self.state.args.keep_data:
+                    keep.clear()
+                    self.discarded = True
+                else:
+                    keep.append(chunk)
+            remaining -= len(chunk)
+            self.throttle(started, already + length - remaining)
+        return length - remaining
+
+    def begin(self):
+        """每个请求的公共处理：计数、延迟、错误注入。返回 False 表示已经回复了注入的错误。"""
+        self.state.count("requests")
+        if self.state.args.latency_ms > 0:
+            time.sleep(self.state.args.latency_ms / 1000.0)
+        url = urlparse(self.path)
+        self.query = parse_qs(url.query)
+        m = re.match(r"/repos/([^/]+)/([^/]+)(/.*)?$", url.path)
+        self.path_owner, self.path_repo = (m.group(1), m.group(2)) if m else ("", "")
+        self.route = (m.group(3) or "") if m else url.path
+        if url.path.startswith("/_"):
+            return True
+        # 默认只对上传、删除和下载资产注入错误；--error-scope all 时查询 Release 也会失败。
+        # 下载先经过资产 API 的重定向，错误只注入在内容请求上，避免一次下载承受两次注入
+        if self.state.args.error_scope == "assets" and (
+                not re.search(r"/assets|^/download/", url.path) or
+                (self.command == "GET" and re.search(r"/releases/assets/\d+$", url.path))):
+            return True
+        if self.state.should_fail():
+            self.state.count("errors")
+            # 先读完请求体，保持连接可以继续复用
+            self.read_body()
+            self.send_json(self.state.args.error_status, {"message": "injected error"})
+            return False
+        return True
+
+    # ---------- 路由 ----------
+
+    def do_GET(self):
+        if not self.begin():
+            return
+        route = self.route
+        if self.path.startswith("/_stats"):
+            with self.state.lock:
+                return self.send_json(200, dict(self.state.stats))
+
+        if route == "/releases":
+            return self.send_page(self.state.releases, self.release_json)
+
+        m = re.fullmatch(r"/releases/tags/(.+)", route)
+        if m:
+            tag = unquote(m.group(1))
+            for release in self.state.releases:
+                if release["tag_name"] == tag and not release["draft"]:
+                    return self.send_json(200, self.release_json(release))
+            return self.send_json(404, {"message": "Not Found"})
+
+        m = re.fullmatch(r"/releases/(\d+)", route)
+        if m:
+            release = self.state.find_release(int(m.group(1)))
+            if release:
+                return self.send_json(200, self.release_json(release))
+
+        m = re.fullmatch(r"/releases/(\d+)/assets", route)
+        if m:
+            release = self.state.find_release(int(m.group(1)))
+            if release:
+                return self.send_page(release["assets"], dict)
+
+        # 和 GitHub 一样，要求 application/octet-stream 时重定向到文件内容
+        m = re.fullmatch(r"/releases/assets/(\d+)", route)
+        if m:
+            _, asset = self.state.find_asset(int(m.group(1)))
+            if asset:
+                if "application/octet-stream" in self.headers.get("Accept", ""):
+                    return self.send_json(302, headers={"Location": asset["browser_download_url"]})
+                return self.send_json(200, asset)
+
+        m = re.fullmatch(r"/download/(\d+)/(.+)", route)
+        if m:
+            return self.send_download(int(m.group(1)), unquote(m.group(2)))
+        self.send_json(404, {"message": "Not Found"})
+
+    def send_download(self, asset_id, name):
+        _, asset = self.state.find_asset(asset_id)
+        body = self.state.contents.get(asset_id)
+        if not asset or asset["name"] != name:
+            return self.send_json(404, {"message": "Not Found"})
+        if body is None:
+            return self.send_json(410, {"message": "content larger than --keep-data was not kept"})
+        self.send_response(200)
+        self.send_header("Content-Type", asset["content_type"])
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.throttled_write(body)
+        with self.state.lock:
+            asset["download_count"] += 1
+            self.state.stats["downloads"] += 1
+            self.state.stats["bytes_sent"] += len(body)
+
+    def do_POST(self):
+        if not self.begin():
+            return
+        route = self.route
+
+        if route == "/releases":
+            length = int(self.headers.get("Content-Length") or 0)
+            body = json.loads(self.rfile.read(length) or b"{}")
+            tag = body.get("tag_name")
+            if not tag or any(r["tag_name"] == tag for r in self.state.releases):
+                return self.send_json(422, {"message": "Validation Failed"})
+            release = self.state.new_release(tag, body.get("name"), body.get("prerelease", False))
+            return self.send_json(201, self.release_json(release))
+
+        m = re.fullmatch(r"/releases/(\d+)/assets", route)
+        if m:
+            release = self.state.find_release(int(m.group(1)))
+            name = self.query.get("name", [None])[0]
+            if not release or not name:
+                self.read_body()
+                return self.send_json(404, {"message": "Not Found"})
+            digest = hashlib.sha256()
+            chunks = []
+            self.discarded = False
+            size = self.read_body(digest, chunks)
+            with self.state.lock:
+                if any(a["name"] == name for a in release["assets"]):
+                    conflict = True
+                else:
+                    conflict = False
+                    asset_id = self.state.next_id
+                    self.state.next_id += 1
+                    asset = {
+                        "id": asset_id,
+                        "name": name,
+                        "label": self.query.get("label", [""])[0],
+                        "state": "uploaded",
+                        "content_type": self.headers.get("Content-Type", "application/octet-stream"),
+                        "size": size,
+                        "digest": "sha256:" + digest.hexdigest(),
+                        "download_count": 0,
+                        "created_at": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+                        "updated_at": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+                        "browser_download_url": "%s/download/%d/%s" % (self.base_url(), asset_id, quote(name)),
+                    }
+                    release["assets"].append(asset)
+                    if not self.discarded:
+                        self.state.contents[asset_id] = b"".join(chunks)
+                    self.state.stats["uploads"] += 1
+            if conflict:
+                return self.send_json(422, {"message": "Validation Failed",
+                                            "errors": [{"resource": "ReleaseAsset", "code": "already_exists"}]})
+            return self.send_json(201, asset)
+
+        self.read_body()
+        self.send_json(404, {"message": "Not Found"})
+
+    def do_PATCH(self):
+        if not self.begin():
+            return
+        length = int(self.headers.get("Content-Length") or 0)
+        body = json.loads(self.rfile.read(length) or b"{}")
+        m = re.fullmatch(r"/releases/assets/(\d+)", self.route)
+        if m:
+            _, asset = self.state.find_asset(int(m.group(1)))
+            if asset:
+                for key in ("name", "label"):
+                    if key in body:
+                        asset[key] = body[key]
+                return self.send_json(200, asset)
+        self.send_json(404, {"message": "Not Found"})
+
+    def do_DELETE(self):
+        if not self.begin():
+            return
+        m = re.fullmatch(r"/releases/assets/(\d+)", self.route)
+        if m:
+            with self.state.lock:
+                release, asset = self.state.find_asset(int(m.group(1)))
+                if asset:
+                    release["assets"].remove(asset)
+                    self.state.contents.pop(asset["id"], None)
+                    self.state.stats["deletes"] += 1
+            if asset:
+                return self.send_json(204)
+        self.send_json(404, {"message": "Not Found"})
+
+
+def main():
+    parser = argparse.ArgumentParser(description="模拟 GitHub Releases API")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080, help="监听端口，0 表示自动选择")
+    parser.add_argument("--port-file", help="启动后把实际端口写入该文件")
+    parser.add_argument("--latency-ms", type=float, default=0, help="每个请求额外的延迟（毫秒）")
+    parser.add_argument("--bandwidth", type=parse_size, default=0,
+                        help="每个连接的上下行带宽，如 20M（字节/秒），0 表示不限")
+    parser.add_argument("--error-rate", type=float, default=0, help="随机返回错误的比例（0-1）")
+    parser.add_argument("--error-status", type=int, default=502, help="注入错误的 HTTP 状态码")
+    parser.add_argument("--error-scope", choices=("assets", "all"), default="assets",
+                        help="注入错误的范围：assets 只影响上传/删除资产，all 影响所有接口")
+    parser.add_argument("--releases", type=int, default=1, help="预先创建的 Release 数量")
+    parser.add_argument("--keep-data", type=parse_size, default=parse_size("64M"),
+                        help="保留内容供下载的资产大小上限（默认 64M），更大的资产只记录哈希")
+    parser.add_argument("--seed", type=int, default=1, help="错误注入的随机种子")
+    parser.add_argument("--verbose", action="store_true", help="打印每个请求")
+    args = parser.parse_args()
+
+    Handler.state = State(args)
+    # 默认的监听队列只有 5，并发上传刚开始时大量连接会被丢弃重传
+    ThreadingHTTPServer.request_queue_size = 128
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    port = server.server_address[1]
+    if args.port_file:
+        with open(args.port_file, "w") as fp:
+            fp.write("%d\n" % port)
+    sys.stderr.write("mock GitHub API listening on http://%s:%d\n" % (args.host, port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+#!/bin/sh
+# 离线基准测试：启动本地模拟的 GitHub API，按场景生成文件并用 manage 上传，
+# 每个场景的逐请求指标写入 $BENCH_OUT/<场景>.json，并打印一行汇总。
+#
+# 用法: bench/run.sh [场景...]     （默认: small flaky）
+#   small   1000 个 4 KiB 小文件，主要衡量每个请求的固定开销和连接复用
+#   large   10 个 1.5 GiB 文件（稀疏文件，不占磁盘），衡量大文件吞吐
+#   flaky   200 个 64 KiB 文件，50% 的请求返回 502，衡量重试行为
+#   all     以上全部
+#
+# 可用环境变量调整：
+#   MANAGE        manage 可执行文件（默认: ./manage）
+#   BENCH_JOBS    并发数（默认按场景选择）
+#   BENCH_LATENCY 每个请求的模拟延迟，毫秒（默认: 20）
+#   BENCH_BANDWIDTH 每个连接的模拟带宽，如 100M（默认: 0，不限）
+#   BENCH_OUT     报告目录（默认: bench/out）
+#   BENCH_TMP     生成测试文件的目录（默认: mktemp -d）
+
+set -eu
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+MANAGE=$(cd "$(dirname "${MANAGE:-./manage}")" && pwd)/$(basename "${MANAGE:-./manage}")
+BENCH_LATENCY=${BENCH_LATENCY:-20}
+BENCH_BANDWIDTH=${BENCH_BANDWIDTH:-0}
+BENCH_OUT=${BENCH_OUT:-$BENCH_DIR/out}
+PYTHON=${PYTHON:-python3}
+
+if [ ! -x "$MANAGE" ]; then
+    echo "找不到 manage 可执行文件: $MANAGE（先运行 make manage）" >&2
+    exit 1
+fi
+
+mkdir -p "$BENCH_OUT"
+BENCH_OUT=$(cd "$BENCH_OUT" && pwd)
+WORK=${BENCH_TMP:-$(mktemp -d "${TMPDIR:-/tmp}/manage-bench.XXXXXX")}
+MOCK_PID=
+
+cleanup() {
+    if [ -n "$MOCK_PID" ]; then
+        kill "$MOCK_PID" 2>/dev/null || true
+        wait "$MOCK_PID" 2>/dev/null || true
+    fi
+    if [ -z "${BENCH_TMP:-}" ]; then
+        rm -rf "$WORK"
+    fi
+}
+trap cleanup EXIT INT TERM
+
+# start_mock <错误率>：每个场景使用一个全新的服务，结果互不影响
+start_mock() {
+    rm -f "$WORK/port"
+    "$PYTHON" "$BENCH_DIR/mock_github.py" --port 0 --port-file "$WORK/port" \
+        --latency-ms "$BENCH_LATENCY" --bandwidth "$BENCH_BANDWIDTH" --error-rate "$1" 2>/dev/null &
+    MOCK_PID=$!
+    i=0
+    while [ ! -s "$WORK/port" ]; do
+        i=$((i + 1))
+        if [ "$i" -gt 100 ]; then
+            echo "模拟服务器启动失败" >&2
+            exit 1
+        fi
+        sleep 0.1
+    done
+    PORT=$(cat "$WORK/port")
+}
+
+stop_mock() {
+    kill "$MOCK_PID" 2>/dev/null || true
+    wait "$MOCK_PID" 2>/dev/null || true
+    MOCK_PID=
+}
+
+# make_files <目录> <数量> <大小>：大小交给 truncate，生成稀疏文件
+make_files() {
+    mkdir -p "$1"
+    n=1
+    while [ "$n" -le "$2" ]; do
+        truncate -s "$3" "$1/$(printf 'file%04d.bin' "$n")"
+        n=$((n + 1))
+    done
+}
+
+# run_scenario <名称> <文件数> <文件大小> <错误率> <默认并发数>
+run_scenario() {
+    name=$1
+    dir="$WORK/$name"
+    jobs=${BENCH_JOBS:-$5}
+    report="$BENCH_OUT/$name.json"
+
+    echo "==> $name: $2 个文件 × $3，错误率 $4，并发 $jobs"
+    make_files "$dir" "$2" "$3"
+    start_mock "$4"
+
+    # manage 只接受相对路径，在文件目录中运行
+    status=0
+    (
+        cd "$dir"
+        GITHUB_API_URL="http://127.0.0.1:$PORT" GITHUB_TOKEN=bench GITHUB_OWNER=bench GITHUB_REPO=bench \
+            MANAGE_LOG_LEVEL=3 "$MANAGE" upload -j "$jobs" --metrics "$report" file*.bin >"$BENCH_OUT/$name.log" 2>&1
+    ) || status=$?
+    stop_mock
+
+    "$PYTHON" - "$report" "$name" "$status" <<'EOF'
+import json, sys
+path, name, status = sys.argv[1], sys.argv[2], int(sys.argv[3])
+summary = json.load(open(path))["summary"]
+total = summary["latency_us"]["total"]
+print("    %-6s 请求 %d  重试 %d  失败 %d  耗时 %.2fs  吞吐 %.1f MB/s  "
+      "延迟 p50/p95/p99 %.1f/%.1f/%.1f ms  退出码 %d" % (
+          name, summary["requests"], summary["retries"], summary["failed"],
+          summary["wall_time_us"] / 1e6, summary["mb_per_s"],
+          total["p50"] / 1e3, total["p95"] / 1e3, total["p99"] / 1e3, status))
+EOF
+    rm -rf "$dir"
+}
+
+if [ $# -eq 0 ]; then
+    set -- small flaky
+fi
+
+for scenario in "$@"; do
+    case "$scenario" in
+        small) run_scenario small 1000 4K 0 16 ;;
+        large) run_scenario large 10 1536M 0 4 ;;
+        flaky) run_scenario flaky 200 64K 0.5 8 ;;
+        all)
+            run_scenario small 1000 4K 0 16
+            run_scenario large 10 1536M 0 4
+            run_scenario flaky 200 64K 0.5 8
+            ;;
+        *)
+            echo "未知场景: $scenario（可选: small large flaky all）" >&2
+            exit 1
+            ;;
+    esac
+done
+
+echo "报告目录: $BENCH_OUT"
@@ -1,22 +1,57 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdarg.h>
 #include <curl/curl.h>
 #include <json-c/json.h>
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <errno.h>
 #include <fnmatch.h>
+#include <regex.h>
 #include <unistd.h>
 #include <time.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <openssl/evp.h>
+#include <zlib.h>
+#ifdef MANAGE_WITH_ZSTD
+#include <zstd.h>
+#endif
 
-// 用于存储HTTP响应数据
-struct MemoryStruct {
-    char *memory;
+// 用于存储HTTP响应数据：容量按几何级数增长，重置后可在多次请求间复用
+typedef struct {
+    char *data;
     size_t size;
-};
+    size_t capacity;
+} ResponseBuffer;
+
+// 简单的 bump 分配器：URL、请求头等短字符串从这里分配，命令结束时统一释放
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;
+} Arena;
+
+// 单次命令的临时内存（非线程安全，只在发起请求的线程中使用）
+typedef struct {
+    Arena arena;
+    ResponseBuffer response;    // 顺序执行的请求共用的响应缓冲区
+} CommandScratch;
 
 // 错误码定义
 typedef enum {
@@ -31,9 +66,147 @@ typedef enum {
     ERR_FILE_IO = -8,
     ERR_INVALID_PATH = -9,
     ERR_NOT_FOUND = -10,
-    ERR_RETRY_EXHAUSTED = -11
+    ERR_RETRY_EXHAUSTED = -11,
+    ERR_DEADLINE = -12
 } ErrorCode;
 
+// 一次请求的结果，重试策略根据它区分可恢复与不可恢复的失败
+typedef struct {
+    long http_status;     // HTTP 状态码，未收到响应时为 0
+    CURLcode curl_code;   // curl 传输结果
+    int transient;        // curl 没有报错，但调用者判定为可以重试的失败（如下载内容与记录不符）
+} RequestStatus;
+
+// 一个操作（包括全部重试）的重试状态
+typedef struct {
+    int attempts;         // 已失败的次数（不含被速率限制拒绝的请求）
+    int rate_limited;     // 被速率限制拒绝（403/429）的次数，上限为 MAX_RATE_LIMIT_WAITS
+    long delay_ms;        // 上一次退避的毫秒数，下一次退避据此计算
+    double deadline;      // 整个操作的截止时间（单调时钟），0 表示不限
+} RetryState;
+
+// 并发请求驱动（runMultiRequests）中一个请求的调度状态，嵌在各类请求的结构体中
+typedef enum {
+    REQUEST_PENDING = 0,
+    REQUEST_ACTIVE,
+    REQUEST_DONE
+} MultiRequestState;
+
+typedef struct {
+    MultiRequestState state;
+    RetryState retry;
+    RequestStatus status;     // 最近一次请求的结果
+    double notBefore;         // 重试前需要等待到的时间点（单调时钟）
+    const char *label;        // 重试提示和传输指标中使用的名字
+    void *item;               // 所属的请求结构体，回调时原样传回
+    int index;                // 在请求列表中的位置
+} MultiRequest;
+
+// 驱动的回调，ctx 原样传给每个回调。start 创建句柄并加入 multi，成功时通过 out_curl 返回句柄；
+// finish 检查传输结果；release 释放本次尝试的句柄等资源；done 在请求最终成功或放弃重试时调用，
+// 返回非 ERR_OK 时中止整批请求。count 每轮重新读取，done 中可以追加新的请求（如分页）
+typedef struct {
+    void *ctx;
+    int concurrency;
+    int (*count)(void *ctx);
+    MultiRequest* (*request)(void *ctx, int index);
+    ErrorCode (*start)(CURLM *multi, void *item, void *ctx, CURL **out_curl);
+    ErrorCode (*finish)(void *item, CURLcode res, void *ctx);
+    void (*release)(CURLM *multi, void *item);
+    ErrorCode (*done)(void *item, ErrorCode result, void *ctx);
+} MultiRequestOps;
+
+// 从响应头中提取的信息
+typedef struct {
+    char *next_url;    // Link 头中 rel="next" 的地址（分页）
+    char *last_url;    // Link 头中 rel="last" 的地址，由它得知总页数
+} ResponseHeaders;
+
+// 增量 JSON 解析：curl 写回调把收到的数据块直接交给 json_tokener，不缓存完整响应体
+// 逐个回调时返回非 0 表示已经拿到需要的数据，停止接收
+typedef int (*JsonElementCallback)(struct json_object *element, void *userp);
+
+typedef enum {
+    JSON_SINK_START = 0,   // 尚未收到有效字符
+    JSON_SINK_WHOLE,       // 整体解析一个 JSON 值
+    JSON_SINK_BETWEEN,     // 顶层数组中，等待下一个元素
+    JSON_SINK_ELEMENT,     // 顶层数组中，正在解析一个元素
+    JSON_SINK_DONE
+} JsonSinkState;
+
+typedef struct {
+    struct json_tokener *tok;
+    struct json_object *root;          // 整体解析的结果（顶层不是数组时也存放在这里）
+    JsonElementCallback on_element;    // 非 NULL 时对顶层数组的每个元素回调
+    void *userp;
+    JsonSinkState state;
+    int stopped;                       // 回调要求提前停止
+    long elements;                     // 已回调的元素数
+    ErrorCode error;
+} JsonSink;
+
+// 上传时顺带计算校验和的哈希器（定义见“上传校验和”一节）
+typedef struct UploadHasher UploadHasher;
+
+// 上传数据源：由 curl 的读回调按块从磁盘读取，内存占用与文件大小无关
+typedef struct {
+    int fd;
+    curl_off_t size;
+    curl_off_t position;
+    UploadHasher *hasher;    // 启用 --checksums 时非 NULL
+    unsigned char *data;     // 非 NULL 时从内存读取（--compress 压缩后的内容），size 为压缩后大小
+    unsigned char *map;      // 非 NULL 时文件已整个映射（大文件），直接从映射复制
+    curl_off_t dropped;      // 映射中 [0, dropped) 的页已发送并释放
+    int pausable;            // 在 multi 事件循环中传输，受 --limit-rate 控制，令牌不足时暂停
+    int paused;              // 正因限速暂停
+    curl_off_t base;         // 数据在文件中的起始位置（--split 的分片），整个文件时为 0
+    curl_off_t budget;       // 在压缩内存预算中占用的字节数（见“上传压缩”一节）
+} UploadSource;
+
+// 一个传输的进度（见“传输进度”一节），进行中时挂在全局的进度链表上
+typedef struct TransferProgress {
+    struct TransferProgress *prev;
+    struct TransferProgress *next;
+    const char *name;
+    curl_off_t total;        // 本次尝试要传输的字节数
+    curl_off_t now;          // 本次尝试已传输的字节数
+    curl_off_t planned;      // 计入总进度的字节数（压缩前的大小），由 progressPlan 设置
+    double started;          // 本次尝试开始的时间（单调时钟）
+    int linked;
+} TransferProgress;
+
+// 上传前的压缩方式（--compress）
+typedef enum {
+    COMPRESS_NONE = 0,
+    COMPRESS_GZIP,
+    COMPRESS_ZSTD
+} CompressionType;
+
+typedef struct {
+    CompressionType type;
+    int level;
+} UploadCompression;
+
+// 校验和算法
+#define CHECKSUM_SHA256  0x1
+#define CHECKSUM_BLAKE2B 0x2
+
+// 单个文件的校验和（十六进制）
+typedef struct {
+    char *name;
+    char sha256[65];
+    char blake2b[129];
+} ChecksumEntry;
+
+// 本次命令上传的文件的校验和，并发上传时由多个回调写入
+typedef struct {
+    int algorithms;
+    pthread_mutex_t lock;
+    ChecksumEntry *entries;
+    size_t count;
+    size_t capacity;
+} ChecksumSet;
+
 // 日志级别定义
 typedef enum {
     LOG_DEBUG = 0,
@@ -43,20 +216,95 @@ typedef enum {
     LOG_FATAL = 4
 } LogLevel;
 
+// Release 元数据缓存（定义见“Release 元数据缓存”一节）
+typedef struct ReleaseCache ReleaseCache;
+
+// 批量上传的断点续传日志（定义见“断点续传”一节）
+typedef struct UploadJournal UploadJournal;
+typedef struct UploadWalk UploadWalk;
+
 typedef struct {
     const char *owner;
     const char *repo;
     const char *token;
     char *release_id;
     const char *tag_name;
+    char *api_base;       // API 地址（GITHUB_API_URL，默认 https://api.github.com），不含结尾的 '/'
+    char *upload_base;    // 上传地址的协议和主机（MANAGE_UPLOAD_URL），NULL 表示使用 upload_url 原样
     int owner_allocated;  // 标记是否动态分配
     int repo_allocated;   // 标记是否动态分配
     int token_allocated;  // 标记是否动态分配
+    int concurrency;      // 并发传输数（-j 或 MANAGE_CONCURRENCY），1 表示逐个执行
+    double deadline;      // 单个操作含重试的总时限（秒，--deadline 或 MANAGE_DEADLINE），0 表示不限
+    curl_off_t limit_rate;  // 所有传输合计的上传速率上限（字节/秒，--limit-rate 或 MANAGE_LIMIT_RATE），0 表示不限
+    curl_off_t speed_limit; // 低于此速率（字节/秒）持续 speed_time 秒的传输视为停滞并中止重试，0 表示不检查
+    long speed_time;        // --speed-time 或 MANAGE_SPEED_TIME
+    int show_progress;      // 显示传输进度（--no-progress 关闭）
+    ReleaseCache *release_cache;  // 本次命令共享的 Release 元数据缓存
+    CommandScratch *scratch;      // 本次命令的临时内存
+    ChecksumSet *checksums;       // 非 NULL 时上传过程中计算校验和（--checksums）
+    UploadJournal *journal;       // 非 NULL 时每个文件上传成功后写入上传日志
+    const UploadCompression *compression;  // 非 NULL 时上传前压缩，资产名追加 .gz/.zst
 } Config;
 
+// delete 的匹配条件：--match 为 shell 通配符（fnmatch），--regex 为 POSIX 扩展正则
+typedef struct {
+    const char *text;
+    int is_regex;
+    regex_t regex;
+    int compiled;
+} AssetPattern;
+
+// 目录上传的一个参数：起始目录和相对它的匹配模式（支持 **）
+typedef struct {
+    char *root;
+    char *pattern;
+    int max_depth;        // 模式不含 ** 时最多进入的目录层数，-1 表示不限
+    size_t rel_offset;    // 文件路径去掉起始目录前缀后的偏移
+} WalkSpec;
+
+// 目录上传时由相对路径生成资产名的方式（--flatten）
+typedef struct {
+    int keep_path;          // 0: 只用文件名；1: 保留相对路径，目录分隔符替换为 separator
+    const char *separator;
+} FlattenStyle;
+
+// list 的输出格式（--format）
+typedef enum {
+    LIST_TABLE = 0,      // 对齐的表格（默认）
+    LIST_NDJSON,         // 每行一个 JSON 对象
+    LIST_JSON,           // 一个 JSON 数组
+    LIST_CSV
+} ListFormat;
+
+typedef struct {
+    ListFormat format;
+    int all_releases;    // --all-releases：列出仓库中所有 Release 的资产
+} ListOptions;
+
 // 全局日志级别，可以通过环境变量 MANAGE_LOG_LEVEL 设置
 static LogLevel global_log_level = LOG_INFO;
 
+// 为 1 时“使用Release …”等状态信息写到 stderr，list 输出机器可读格式时 stdout 只有数据
+static int status_to_stderr = 0;
+
+static FILE* statusStream(void) {
+    return status_to_stderr ? stderr : stdout;
+}
+
+// 终端上正在显示的进度行（见“传输进度”一节）。压缩等后台线程也会写日志，
+// 进度行的状态和输出都由这把锁保护
+static pthread_mutex_t progress_line_lock = PTHREAD_MUTEX_INITIALIZER;
+static int progress_line_shown = 0;
+
+// 正在显示进度行时先清除，日志不会接在进度行后面（需持有 progress_line_lock）
+static void progressClearLocked(void) {
+    if (progress_line_shown) {
+        fputs("\r\033[K", stderr);
+        progress_line_shown = 0;
+    }
+}
+
 // 统一的日志函数
 static void log_message(LogLevel level, const char *fmt, ...) {
     static const char *level_strs[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
@@ -69,9 +317,12 @@ static void log_message(LogLevel level, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
 
+    pthread_mutex_lock(&progress_line_lock);
+    progressClearLocked();
     fprintf(stderr, "[%s] ", level_strs[level]);
     vfprintf(stderr, fmt, args);
     fprintf(stderr, "\n");
+    pthread_mutex_unlock(&progress_line_lock);
 
     va_end(args);
 
@@ -89,20 +340,114 @@ static void log_message(LogLevel level, const char *fmt, ...) {
 #define log_fatal(...) log_message(LOG_FATAL, __VA_ARGS__)
 
 // 重试配置
-#define MAX_RETRIES 3  // 最大重试次数
+#define MAX_RETRIES 3          // 最大重试次数
+#define MAX_RATE_LIMIT_WAITS 10 // 一个操作最多遵守多少次速率限制的等待，不占用 MAX_RETRIES
+#define RETRY_BASE_MS 500      // 退避的最短等待（毫秒）
+#define RETRY_CAP_MS 30000     // 退避的最长等待（毫秒）
+
+// API 配置
+#define DEFAULT_API_BASE "https://api.github.com"
+
+// 分页配置
+#define RELEASES_PER_PAGE 100   // 扫描 Release 列表时每页数量（GitHub 上限）
+#define MAX_LISTED_TAGS 30      // 找不到 tag 时最多列出的可用 tag 数
+#define LIST_PAGE_CONCURRENCY 8 // list 未指定 -j 时同时获取的页数
+#define APPLY_RESOLVE_CONCURRENCY 8 // apply 未指定并发数时同时解析的 Release 数
+
+// 守护进程配置
+#define SERVE_MAGIC 0x4d4e4731u     // 请求头的标识 "MNG1"
+#define SERVE_MAX_REQUEST (1024 * 1024)  // 一个请求中字符串的总长度上限
+#define SERVE_MAX_ARGS 65536        // 一个请求的命令参数个数上限
+#define SERVE_BACKLOG 64
+#define SERVE_CACHE_TTL 30          // 已解析的 Release 默认沿用的秒数
+#define SERVE_RECV_TIMEOUT 10       // 读取请求的超时（秒），避免卡住的客户端阻塞后续任务
+
+// 并发配置
+#define DEFAULT_CONCURRENCY 1   // 默认逐个传输
+#define MAX_CONCURRENCY 64      // 并发传输数上限
+
+// 上传配置
+#define MAX_ASSET_SIZE (2LL * 1024 * 1024 * 1024)  // GitHub 单个资产上限 2 GiB
+#define UPLOAD_BUFFER_SIZE (512L * 1024)          // curl 上传缓冲区大小
+#define UPLOAD_MMAP_MIN (8LL * 1024 * 1024)       // 不小于此大小的文件通过 mmap 读取
+#define UPLOAD_DROP_CHUNK (8LL * 1024 * 1024)     // 已发送的数据每累积这么多释放一次页缓存
+#define UPLOAD_RATE_BURST 0.1                     // 限速时最多积累多少秒的发送量
+#define UPLOAD_RATE_MIN_CHUNK (16L * 1024)        // 限速暂停的传输至少攒够这么多再恢复
+#define UPLOAD_MAX_PRIORITIES 32                  // --priority 最多可以指定的模式数
+#define UPLOAD_JOURNAL_FORMAT ".manage_upload_%s.json"  // 续传日志，按 release id 区分
+
+// 进度显示配置
+#define PROGRESS_TTY_INTERVAL 0.25      // 终端上刷新进度行的间隔（秒）
+#define PROGRESS_LOG_INTERVAL 10.0      // 输出不是终端时打印进度日志的间隔（秒）
+#define PROGRESS_RATE_WINDOW 3.0        // 总速率的平滑时间常数（秒）
+#define PROGRESS_NAME_WIDTH 32          // 进度行中文件名最多显示的字节数
+#define DEFAULT_SPEED_TIME 30           // 只指定 --speed-limit 时的持续时间（秒）
+
+// 目录上传配置
+#define WALK_THREADS 4                  // 并行扫描目录的线程数
+#define WALK_NAME_BUCKETS 1024          // 检查资产名冲突的哈希桶数
+#define DEFAULT_FLATTEN_SEPARATOR "_"   // 资产名中代替目录分隔符的字符串
+
+// 分片配置
+#define SPLIT_MIN_SIZE (1LL * 1024 * 1024)     // --split 允许的最小分片
+#define SPLIT_ALIGN (64LL * 1024)              // 分片大小向下取整到它的整数倍，分片起点因此总是页对齐
+#define SPLIT_PART_FORMAT "%s.part%03d"        // 分片的资产名
+#define SPLIT_MANIFEST_SUFFIX ".parts.json"    // 分片清单的资产名后缀
+#define DOWNLOAD_TEMP_SUFFIX ".download"       // 下载完成并校验之前写入的临时文件后缀
+
+// 同步配置
+#define DEFAULT_SYNC_MANIFEST ".manage_sync.json"   // 默认的本地哈希清单
+#define SHA256_HEX_SIZE 65                           // 64 位十六进制 + '\0'
+
+// 校验和配置
+#define CHECKSUM_QUEUE_DEPTH 8          // 等待哈希的上传缓冲区数量上限
+#define SHA256SUMS_NAME "SHA256SUMS"
+#define B2SUMS_NAME "B2SUMS"
+
+// 速率限制配置
+#define RATE_LIMIT_PACE_BELOW 200       // 剩余配额低于此值时开始均匀限速
+#define RATE_LIMIT_BURST 5.0            // 限速时允许的突发请求数
+#define RATE_LIMIT_SECONDARY_WAIT 60    // 429 未给出 Retry-After 时的等待秒数
+
+// 内存配置
+#define ARENA_BLOCK_SIZE 8192           // arena 每块大小
+#define RESPONSE_BUFFER_INITIAL 4096    // 响应缓冲区初始容量
+
+// 批量上传的顺序：先按 --priority 模式（资产名通配符，越靠前越先上传），
+// smallest_first 时同一优先级内小文件在前；其余保持命令行中的顺序
+typedef struct {
+    const char *patterns[UPLOAD_MAX_PRIORITIES];
+    int pattern_count;
+    int smallest_first;
+} UploadOrder;
 
 // 函数原型声明
 static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp);
-static struct curl_slist* setGithubHeaders(const char *token, const char *content_type);
-static ErrorCode getAssets(struct MemoryStruct *chunk, const Config *config);
+static struct curl_slist* setGithubHeaders(Arena *arena, const char *token, const char *content_type);
 static ErrorCode getLatestReleaseId(Config *config);
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp);
+static void freeResponseHeaders(ResponseHeaders *headers);
+static ErrorCode githubGetJson(const Config *config, const char *url, struct json_object **out_root,
+                               long *out_http_code, ResponseHeaders *out_headers);
+static ErrorCode initJsonSink(JsonSink *sink, JsonElementCallback on_element, void *userp);
+static void freeJsonSink(JsonSink *sink);
+static const char* jsonSinkMessage(const JsonSink *sink);
+static size_t JsonSinkWriteCallback(void *contents, size_t size, size_t nmemb, void *userp);
+static ErrorCode githubGetStream(const Config *config, const char *url, JsonSink *sink,
+                                 long *out_http_code, ResponseHeaders *out_headers);
 static ErrorCode deleteAsset(const char *assetId, const char *assetName, const Config *config);
 static ErrorCode uploadFile(const char *filePath, const Config *config);
 static ErrorCode deleteFile(const char *fileName, const Config *config);
 static ErrorCode listFiles(const Config *config);
 static const char* getFilenameFromPath(const char *path);
-static char* readFileToBuffer(const char *filename, long *file_size);
-static char* create_url(const char *format, ...);
+static ErrorCode openUploadSource(UploadSource *source, const char *filename,
+                                  const UploadCompression *compression);
+static ErrorCode openUploadRange(UploadSource *source, const char *filename,
+                                 const UploadCompression *compression, curl_off_t offset, curl_off_t length);
+static void closeUploadSource(UploadSource *source);
+static size_t UploadReadCallback(char *buffer, size_t size, size_t nitems, void *userp);
+static int UploadSeekCallback(void *userp, curl_off_t offset, int origin);
+static char* create_url(Arena *arena, const char *format, ...);
 static ErrorCode validate_config(const Config *config);
 static int matchWildcard(const char *pattern, const char *string);
 static ErrorCode uploadMultipleFiles(int fileCount, char **filePaths, const Config *config);
@@ -114,15 +459,176 @@ static void showUsage(void);
 static void showDetailedUsage(void);
 static ErrorCode createRelease(const char *tag_name, const char *release_name, const char *description,
                                int is_prerelease, const Config *config, char **out_release_id);
+static int parseConcurrency(const char *value);
+static double parseDeadline(const char *value);
+
+// 内存复用
+static void* arenaAlloc(Arena *arena, size_t n);
+static char* arenaPrintf(Arena *arena, const char *format, ...);
+static char* arenaVprintf(Arena *arena, const char *format, va_list args);
+static char* arenaStrdup(Arena *arena, const char *str);
+static void arenaReset(Arena *arena);
+static void arenaFree(Arena *arena);
+static ErrorCode responseBufferReserve(ResponseBuffer *buf, size_t extra);
+static void responseBufferReset(ResponseBuffer *buf);
+static void responseBufferFree(ResponseBuffer *buf);
+static Arena* commandArena(const Config *config);
+static ResponseBuffer* scratchResponse(const Config *config);
+static void resetCommandScratch(CommandScratch *scratch);
+static void freeCommandScratch(CommandScratch *scratch);
+
+// 连接复用
+static ErrorCode initHttpPool(void);
+static void cleanupHttpPool(void);
+static CURL* acquireCurlHandle(void);
+static void releaseCurlHandle(CURL *curl);
+
+// 传输指标
+static void enableMetrics(void);
+static void metricsRecordRequest(CURL *curl, CURLcode res, const char *label, int attempt);
+static ErrorCode writeMetricsReport(const char *path);
+static void freeMetrics(void);
+
+// API 速率限制
+static void rateLimitObserveHeader(const char *buffer, size_t len);
+static size_t RateLimitHeaderCallback(char *buffer, size_t size, size_t nitems, void *userp);
+static void rateLimitObserveStatus(long response_code);
+static void rateLimitObserveBody(long response_code, const char *body);
+static double rateLimitDelay(void);
+static void rateLimitAcquire(void);
+
+// Release 元数据缓存
+typedef struct ReleaseAsset ReleaseAsset;
+static ErrorCode ensureReleaseCache(const Config *config, ReleaseCache **out_cache);
+static ReleaseAsset* releaseCacheFind(const ReleaseCache *cache, const char *name);
+static ErrorCode releaseCacheAddAsset(ReleaseCache *cache, struct json_object *asset);
+static void releaseCacheRemove(ReleaseCache *cache, const char *name);
+static ErrorCode releaseCacheLoadJson(ReleaseCache *cache, const char *release_id,
+                                      struct json_object *release);
+static void releaseCacheClear(ReleaseCache *cache);
+
+// 目录递归上传
+static int globstarMatch(const char *pattern, const char *path);
+static int parseWalkSpec(const char *arg, WalkSpec *spec);
+static void freeWalkSpec(WalkSpec *spec);
+static int parseFlattenStyle(const char *value, FlattenStyle *style);
+static ErrorCode startUploadWalk(const WalkSpec *specs, int specCount, const FlattenStyle *style,
+                                 UploadWalk **out_walk);
+static void uploadWalkAttach(UploadWalk *walk, CURLM *multi);
+static int uploadWalkNext(UploadWalk *walk, const char **path, const char **name);
+static int finishUploadWalk(UploadWalk *walk);
+static ErrorCode uploadTree(int fileCount, char **filePaths, const WalkSpec *specs, int specCount,
+                            const FlattenStyle *style, const Config *config);
+
+// 上传压缩
+static int parseCompression(const char *value, UploadCompression *out);
+static int reportCompressionOption(const char *value, UploadCompression *out);
+static const char* compressionSuffix(const UploadCompression *compression);
+static const char* uploadAssetName(const Config *config, const char *fileName);
+static ErrorCode compressUploadSource(UploadSource *source, const UploadCompression *compression,
+                                      const char *filename);
+static int compressBudgetTake(UploadSource *source, curl_off_t fileSize);
+static void compressBudgetShrink(UploadSource *source, curl_off_t keep);
+
+// 按模式批量删除
+static int assetPatternMatches(const AssetPattern *pattern, const char *name);
+static ErrorCode deleteAssetsConcurrent(int count, ReleaseAsset **assets, const Config *config);
+static ErrorCode deleteMatchingAssets(int nameCount, char **names, int patternCount, AssetPattern *patterns,
+                                      int dryRun, const Config *config);
+
+// 资产清单导出
+static int parseListFormat(const char *value);
+static ErrorCode parseListOptions(int argc, char **argv, ListOptions *options, Config *config);
+static ErrorCode exportAssets(const ListOptions *options, const Config *config);
+
+// 上传限速与排序
+static long long parseByteSize(const char *value);
+static int parseUploadQueueOption(int argc, char **argv, int i, Config *config, UploadOrder *order);
+static ErrorCode orderUploadFiles(char **files, int count, const UploadOrder *order);
+static void uploadRateStart(curl_off_t rate);
+static void uploadRateStop(void);
+static size_t uploadRateTake(UploadSource *source, size_t want);
+static void uploadRateRelease(UploadSource *source);
+static double uploadRateWait(void);
+static int uploadRatePaused(void);
+
+// 传输进度
+static long parseSpeedTime(const char *value);
+static int parseTransferOption(int argc, char **argv, int i, Config *config);
+static void progressBegin(const Config *config, int rateShares);
+static void progressEnd(void);
+static void progressPlan(TransferProgress *t, curl_off_t bytes);
+static void progressAttach(CURL *curl, TransferProgress *t, const char *name, curl_off_t total);
+static void progressDetach(TransferProgress *t);
+static void progressFileDone(TransferProgress *t, int ok);
+static void progressClear(void);
+
+// 批量任务文件
+static ErrorCode applyJobFile(int argc, char **argv, const Config *base);
+
+// 守护进程
+static ErrorCode runCommand(int argc, char **argv, const Config *base, char **resolvedReleaseId);
+static ErrorCode forwardToDaemon(const char *socketPath, int argc, char **argv, int *exitCode);
+static ErrorCode serveJobs(int argc, char **argv, const Config *base);
+
+// 增量同步
+static ErrorCode syncFiles(int fileCount, char **filePaths, const Config *config,
+                           int deleteOrphans, int dryRun, const char *manifestPath);
+
+// 分片上传与下载
+static long long parseSplitSize(const char *value);
+static ErrorCode uploadSplitFiles(int fileCount, char **filePaths, const Config *config,
+                                  long long splitSize, int replaceExisting);
+static ErrorCode downloadAssets(int argc, char **argv, const Config *base);
+
+// 断点续传
+static ErrorCode uploadFilesResumable(int fileCount, char **filePaths, const Config *config, int resume);
+static void uploadJournalComplete(UploadJournal *journal, const char *name, long long assetId);
+
+// 上传校验和
+static UploadHasher* createUploadHasher(int algorithms);
+static void freeUploadHasher(UploadHasher *hasher);
+static void uploadHasherFeed(UploadHasher *hasher, const void *data, size_t len, curl_off_t offset);
+static ErrorCode hashFileSha256(const char *filePath, char out_hex[SHA256_HEX_SIZE]);
+static int parseChecksumAlgorithms(const char *value);
+static void initChecksumSet(ChecksumSet *set, int algorithms);
+static void freeChecksumSet(ChecksumSet *set);
+static void attachUploadHasher(const Config *config, UploadSource *source);
+static ErrorCode recordUploadChecksum(const Config *config, UploadSource *source,
+                                      const char *filePath, const char *fileName);
+static ErrorCode storeChecksumEntry(ChecksumSet *set, const char *fileName, const ChecksumEntry *digests);
+static void checksumWait(UploadHasher *hasher);
+static void formatDigest(EVP_MD_CTX *ctx, char *out_hex, size_t out_size);
+static ErrorCode uploadHasherFeedFile(UploadHasher *hasher, const char *filePath,
+                                      curl_off_t offset, curl_off_t length);
+static ErrorCode publishChecksums(const Config *config);
+static void stopChecksumWorker(void);
 
 // 重试机制相关
 static ErrorCode performWithRetry(ErrorCode (*operation)(const void *), const void *param,
-                                  int maxRetries, const char *opName);
+                                  int maxRetries, double deadlineSeconds, const char *opName);
 static ErrorCode retryableOperationWrapper(const void *param);
 static ErrorCode uploadFileWithRetry(const char *filePath, const Config *config, int maxRetries);
 static ErrorCode deleteFileWithRetry(const char *fileName, const Config *config, int maxRetries);
 static ErrorCode updateFileWithRetry(const char *filePath, const Config *config, int maxRetries);
-static int shouldRetryError(ErrorCode error);
+static CURLcode performRequest(CURL *curl);
+static void recordRequestStatus(RequestStatus *status, CURL *curl, CURLcode res);
+static void applyRequestDeadline(CURL *curl, double deadline);
+static int shouldRetryError(ErrorCode error, const RequestStatus *status);
+static long computeRetryDelayMs(long previousMs);
+static void initRetryState(RetryState *state, double deadlineSeconds);
+static ErrorCode planRetry(RetryState *state, ErrorCode error, const RequestStatus *status,
+                           int maxRetries, const char *opName, double *out_wait);
+static double monotonicSeconds(void);
+
+// 并发请求驱动（curl_multi）
+static ErrorCode runMultiRequests(const MultiRequestOps *ops);
+
+// 并发上传引擎（curl_multi）
+static ErrorCode getUploadUrlTemplate(const Config *config, const char **out_template);
+static char* buildUploadUrl(Arena *arena, const char *uploadUrlTemplate, const char *fileName);
+static ErrorCode uploadMultipleFilesConcurrent(int fileCount, char **filePaths, UploadWalk *walk,
+                                               const Config *config, int replaceExisting);
 
 // 包装器参数结构体
 typedef struct {
@@ -132,6 +638,14 @@ typedef struct {
     const char *opName;
 } RetryWrapperParam;
 
+// 当前线程正在执行的操作的截止时间（单调时钟），acquireCurlHandle 据此限制请求耗时
+static __thread double request_deadline = 0;
+// 当前线程最近一次请求的结果，performWithRetry 据此判断失败是否值得重试
+static __thread RequestStatus last_request_status;
+// 当前线程正在重试的操作名（通常是文件名）和已失败次数，用于传输指标
+static __thread const char *request_label = NULL;
+static __thread int request_failures = 0;
+
 // 从文件安全地读取token
 static char* readTokenFromFile(const char *filename) {
     FILE *fp = fopen(filename, "r");
@@ -173,6 +687,34 @@ static char* readTokenFromFile(const char *filename) {
     return token;
 }
 
+static int isHttpUrl(const char *value) {
+    return strncmp(value, "http://", 7) == 0 || strncmp(value, "https://", 8) == 0;
+}
+
+// 复制基础 URL 并去掉结尾的 '/'，之后统一用 "%s/repos/..." 拼接
+static char* copyBaseUrl(const char *value) {
+    char *copy = strdup(value);
+    if (!copy) return NULL;
+    size_t len = strlen(copy);
+    while (len > 0 && copy[len - 1] == '/') {
+        copy[--len] = '\0';
+    }
+    return copy;
+}
+
+// 把 URL 的协议和主机部分替换为 base，保留路径（和 URI 模板）
+static char* rebaseUrl(const char *base, const char *url) {
+    const char *path = strstr(url, "://");
+    path = path ? strchr(path + 3, '/') : NULL;
+    if (!path) path = "";
+
+    size_t len = strlen(base) + strlen(path) + 1;
+    char *result = malloc(len);
+    if (!result) return NULL;
+    snprintf(result, len, "%s%s", base, path);
+    return result;
+}
+
 // 从环境变量获取配置信息
 static ErrorCode getConfig(Config *config) {
     if (!config) {
@@ -190,6 +732,69 @@ static ErrorCode getConfig(Config *config) {
         }
     }
 
+    // 并发传输数，命令行 -j 可覆盖
+    config->concurrency = DEFAULT_CONCURRENCY;
+    const char *concurrency_env = getenv("MANAGE_CONCURRENCY");
+    if (concurrency_env) {
+        int concurrency = parseConcurrency(concurrency_env);
+        if (concurrency > 0) {
+            config->concurrency = concurrency;
+            log_debug("并发传输数设置为: %d", concurrency);
+        } else {
+            log_warn("忽略无效的 MANAGE_CONCURRENCY: %s", concurrency_env);
+        }
+    }
+
+    // 单个操作的总时限，命令行 --deadline 可覆盖
+    config->deadline = 0;
+    const char *deadline_env = getenv("MANAGE_DEADLINE");
+    if (deadline_env) {
+        double deadline = parseDeadline(deadline_env);
+        if (deadline >= 0) {
+            config->deadline = deadline;
+            log_debug("操作时限设置为: %.1f 秒", deadline);
+        } else {
+            log_warn("忽略无效的 MANAGE_DEADLINE: %s", deadline_env);
+        }
+    }
+
+    // 上传限速，命令行 --limit-rate 可覆盖
+    config->limit_rate = 0;
+    const char *rate_env = getenv("MANAGE_LIMIT_RATE");
+    if (rate_env) {
+        long long rate = parseByteSize(rate_env);
+        if (rate > 0) {
+            config->limit_rate = (curl_off_t)rate;
+            log_debug("上传限速设置为: %lld 字节/秒", rate);
+        } else {
+            log_warn("忽略无效的 MANAGE_LIMIT_RATE: %s", rate_env);
+        }
+    }
+
+    // 停滞检测，命令行 --speed-limit/--speed-time 可覆盖
+    config->speed_limit = 0;
+    config->speed_time = DEFAULT_SPEED_TIME;
+    config->show_progress = 1;
+    const char *speed_env = getenv("MANAGE_SPEED_LIMIT");
+    if (speed_env) {
+        long long speed = parseByteSize(speed_env);
+        if (speed > 0) {
+            config->speed_limit = (curl_off_t)speed;
+            log_debug("停滞检测速率设置为: %lld 字节/秒", speed);
+        } else {
+            log_warn("忽略无效的 MANAGE_SPEED_LIMIT: %s", speed_env);
+        }
+    }
+    const char *speed_time_env = getenv("MANAGE_SPEED_TIME");
+    if (speed_time_env) {
+        long seconds = parseSpeedTime(speed_time_env);
+        if (seconds > 0) {
+            config->speed_time = seconds;
+        } else {
+            log_warn("忽略无效的 MANAGE_SPEED_TIME: %s", speed_time_env);
+        }
+    }
+
     // 获取 GitHub token，优先从 GITHUB_TOKEN 环境变量获取
     config->token = getenv("GITHUB_TOKEN");
     config->token_allocated = 0;  // 初始化为环境变量
@@ -241,6 +846,28 @@ static ErrorCode getConfig(Config *config) {
         log_debug("使用默认 repo: %s", config->repo);
     }
 
+    // API 地址，可指向 GitHub Enterprise（https://host/api/v3）或本地模拟服务器
+    const char *api_env = getenv("GITHUB_API_URL");
+    if (api_env && *api_env && !isHttpUrl(api_env)) {
+        fprintf(stderr, "错误：GITHUB_API_URL 必须以 http:// 或 https:// 开头\n");
+        return ERR_CONFIG;
+    }
+    config->api_base = copyBaseUrl(api_env && *api_env ? api_env : DEFAULT_API_BASE);
+
+    // 上传地址默认取自 Release 的 upload_url，设置后替换其中的协议和主机部分
+    const char *upload_env = getenv("MANAGE_UPLOAD_URL");
+    if (upload_env && *upload_env) {
+        if (!isHttpUrl(upload_env)) {
+            fprintf(stderr, "错误：MANAGE_UPLOAD_URL 必须以 http:// 或 https:// 开头\n");
+            return ERR_CONFIG;
+        }
+        config->upload_base = copyBaseUrl(upload_env);
+    }
+    if (!config->api_base || (upload_env && *upload_env && !config->upload_base)) {
+        log_error("内存分配失败");
+        return ERR_MEMORY;
+    }
+
     // release_id 将在运行时获取
     config->release_id = NULL;
 
@@ -254,109 +881,201 @@ static ErrorCode getConfig(Config *config) {
     return ERR_OK;
 }
 
-// 获取Releases列表并获取指定的release id（根据tag_name）或最新的release id
-static ErrorCode getLatestReleaseId(Config *config) {
-    struct MemoryStruct chunk = {NULL, 0};
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    struct json_object *root = NULL;
-    char *url = NULL;
-    ErrorCode result = ERR_OK;
-    char *new_release_id = NULL;
+// 逐页扫描 Release 列表时的查找状态
+typedef struct {
+    const char *tag_name;
+    struct json_object *found;            // 匹配的 Release（持有引用）
+    char *listed[MAX_LISTED_TAGS];        // 找不到时展示的前几个 tag
+    int seen;
+} ReleaseScan;
+
+// 每解析出一个 Release 就检查一次，匹配后立即停止接收
+static int scanReleaseElement(struct json_object *release, void *userp) {
+    ReleaseScan *scan = (ReleaseScan *)userp;
+    struct json_object *tag_obj;
 
-    chunk.memory = malloc(1);
-    if (!chunk.memory) {
-        fprintf(stderr, "内存分配失败\n");
-        return ERR_MEMORY;
+    if (!json_object_object_get_ex(release, "tag_name", &tag_obj) ||
+        !json_object_is_type(tag_obj, json_type_string)) {
+        return 0;
     }
-    chunk.memory[0] = '\0';
 
-    url = create_url("https://api.github.com/repos/%s/%s/releases",
-                     config->owner, config->repo);
-    if (!url) {
-        fprintf(stderr, "URL 分配失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
+    const char *tag = json_object_get_string(tag_obj);
+    if (strcmp(tag, scan->tag_name) == 0) {
+        scan->found = json_object_get(release);
+        return 1;
     }
 
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "初始化 CURL 失败\n");
-        result = ERR_CURL_INIT;
-        goto cleanup;
+    if (scan->seen < MAX_LISTED_TAGS) {
+        scan->listed[scan->seen] = strdup(tag);
     }
+    scan->seen++;
+    return 0;
+}
 
-    headers = setGithubHeaders(config->token, NULL);
+// 逐页查找指定 tag 的 Release（per_page=100，按 Link 头翻页）
+// 响应边接收边解析，找到匹配项后立即停止，不再下载和解析剩余数据
+// 用于 tags 接口查不到的情况（例如草稿 Release），找到时 *out_release 需要调用者释放
+static ErrorCode findReleaseByScan(const Config *config, const char *tag_name,
+                                   struct json_object **out_release) {
+    ResponseHeaders headers = {0};
+    ReleaseScan scan = {0};
+    char *url = NULL;
+    ErrorCode result = ERR_NOT_FOUND;
+    int pages = 0;
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    *out_release = NULL;
+    scan.tag_name = tag_name;
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "获取Release列表失败: %s\n", curl_easy_strerror(res));
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
+    url = create_url(commandArena(config), "%s/repos/%s/%s/releases?per_page=%d",
+                     config->api_base, config->owner, config->repo, RELEASES_PER_PAGE);
+    if (!url) {
+        fprintf(stderr, "URL 分配失败\n");
+        return ERR_MEMORY;
     }
 
-    // 解析JSON数组
-    root = json_tokener_parse(chunk.memory);
-    if (!root) {
-        fprintf(stderr, "解析JSON失败\n");
-        result = ERR_JSON_PARSE;
-        goto cleanup;
-    }
+    while (url) {
+        JsonSink sink;
+        long response_code = 0;
 
-    if (!json_object_is_type(root, json_type_array)) {
-        fprintf(stderr, "返回数据不是JSON数组格式\n");
-        result = ERR_JSON_TYPE;
-        goto cleanup;
+        if (initJsonSink(&sink, scanReleaseElement, &scan) != ERR_OK) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+
+        ErrorCode ret = githubGetStream(config, url, &sink, &response_code, &headers);
+        int is_array = (sink.root == NULL);
+        freeJsonSink(&sink);
+        url = NULL;
+        pages++;
+
+        if (ret != ERR_OK) {
+            fprintf(stderr, "获取Release列表失败\n");
+            result = ret;
+            goto cleanup;
+        }
+
+        if (!is_array) {
+            fprintf(stderr, "返回数据不是JSON数组格式\n");
+            result = ERR_JSON_TYPE;
+            goto cleanup;
+        }
+
+        if (scan.found) {
+            log_debug("在第 %d 页找到 tag \"%s\"", pages, tag_name);
+            *out_release = scan.found;
+            scan.found = NULL;
+            result = ERR_OK;
+            goto cleanup;
+        }
+
+        // 没有下一页就结束
+        if (headers.next_url) {
+            url = arenaStrdup(commandArena(config), headers.next_url);
+            if (!url) {
+                fprintf(stderr, "URL 分配失败\n");
+                result = ERR_MEMORY;
+                goto cleanup;
+            }
+        }
     }
 
-    int arraySize = json_object_array_length(root);
-    if (arraySize == 0) {
+    if (scan.seen == 0) {
         fprintf(stderr, "没有找到任何releases\n");
-        result = ERR_NOT_FOUND;
-        goto cleanup;
+    } else {
+        fprintf(stderr, "未找到tag为 \"%s\" 的release\n", tag_name);
+        fprintf(stderr, "可用的tag有:\n");
+        for (int i = 0; i < scan.seen && i < MAX_LISTED_TAGS; i++) {
+            if (scan.listed[i]) fprintf(stderr, "  - %s\n", scan.listed[i]);
+        }
+        if (scan.seen > MAX_LISTED_TAGS) {
+            fprintf(stderr, "  ...（共 %d 个）\n", scan.seen);
+        }
     }
 
-    // 查找目标release
+cleanup:
+    if (scan.found) json_object_put(scan.found);
+    freeResponseHeaders(&headers);
+    for (int i = 0; i < scan.seen && i < MAX_LISTED_TAGS; i++) {
+        free(scan.listed[i]);
+    }
+
+    return result;
+}
+
+// 获取指定 tag（或最新）的 Release，并设置 release id
+// 指定 tag 时直接请求 releases/tags/{tag}，只有查不到时才逐页扫描
+static ErrorCode getLatestReleaseId(Config *config) {
+    struct json_object *root = NULL;
     struct json_object *targetRelease = NULL;
+    char *url = NULL;
+    char *escaped_tag = NULL;
+    ErrorCode result = ERR_OK;
+    char *new_release_id = NULL;
+    long response_code = 0;
 
     if (config->tag_name) {
-        // 按tag_name查找release
-        for (int i = 0; i < arraySize; i++) {
-            struct json_object *release = json_object_array_get_idx(root, i);
-            struct json_object *tag_obj;
-
-            if (json_object_object_get_ex(release, "tag_name", &tag_obj) &&
-                json_object_is_type(tag_obj, json_type_string)) {
-                const char *tag = json_object_get_string(tag_obj);
-                if (strcmp(tag, config->tag_name) == 0) {
-                    targetRelease = release;
-                    break;
-                }
+        escaped_tag = curl_easy_escape(NULL, config->tag_name, 0);
+        if (!escaped_tag) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+
+        url = create_url(commandArena(config), "%s/repos/%s/%s/releases/tags/%s",
+                         config->api_base, config->owner, config->repo, escaped_tag);
+        if (!url) {
+            fprintf(stderr, "URL 分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+
+        result = githubGetJson(config, url, &root, &response_code, NULL);
+        if (result == ERR_OK) {
+            targetRelease = root;
+        } else if (response_code == 404) {
+            // tags 接口不返回草稿 Release，退回到逐页扫描
+            log_debug("releases/tags 未找到 \"%s\"，逐页扫描 Release 列表", config->tag_name);
+            result = findReleaseByScan(config, config->tag_name, &root);
+            if (result != ERR_OK) {
+                goto cleanup;
             }
+            targetRelease = root;
+        } else {
+            fprintf(stderr, "获取Release失败\n");
+            goto cleanup;
+        }
+    } else {
+        // 未指定tag_name，使用列表中的第一个release
+        url = create_url(commandArena(config), "%s/repos/%s/%s/releases?per_page=1",
+                         config->api_base, config->owner, config->repo);
+        if (!url) {
+            fprintf(stderr, "URL 分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
         }
 
-        if (!targetRelease) {
-            fprintf(stderr, "未找到tag为 \"%s\" 的release\n", config->tag_name);
-            fprintf(stderr, "可用的tag有:\n");
-            for (int i = 0; i < arraySize; i++) {
-                struct json_object *release = json_object_array_get_idx(root, i);
-                struct json_object *tag_obj;
-                if (json_object_object_get_ex(release, "tag_name", &tag_obj) &&
-                    json_object_is_type(tag_obj, json_type_string)) {
-                    fprintf(stderr, "  - %s\n", json_object_get_string(tag_obj));
-                }
+        result = githubGetJson(config, url, &root, &response_code, NULL);
+        if (result != ERR_OK) {
+            if (response_code == 404) {
+                fprintf(stderr, "HTTP错误: 404（仓库不存在或无权访问）\n");
             }
+            fprintf(stderr, "获取Release列表失败\n");
+            goto cleanup;
+        }
+
+        if (!json_object_is_type(root, json_type_array)) {
+            fprintf(stderr, "返回数据不是JSON数组格式\n");
+            result = ERR_JSON_TYPE;
+            goto cleanup;
+        }
+
+        if (json_object_array_length(root) == 0) {
+            fprintf(stderr, "没有找到任何releases\n");
             result = ERR_NOT_FOUND;
             goto cleanup;
         }
-    } else {
-        // 未指定tag_name，使用第一个release
+
         targetRelease = json_object_array_get_idx(root, 0);
     }
 
@@ -368,29 +1087,20 @@ static ErrorCode getLatestReleaseId(Config *config) {
         goto cleanup;
     }
 
-    int id_value = json_object_get_int(id_obj);
-
     // 将id转换为字符串
     char temp_id[32];
-    int ret = snprintf(temp_id, sizeof(temp_id), "%d", id_value);
+    int ret = snprintf(temp_id, sizeof(temp_id), "%lld", (long long)json_object_get_int64(id_obj));
     if (ret < 0 || ret >= (int)sizeof(temp_id)) {
         fprintf(stderr, "格式化ID时出错\n");
         result = ERR_CONFIG;
         goto cleanup;
     }
 
-    // 只在返回 ERR_OK 时更新 release_id
     // 获取并显示tag_name用于确认
     struct json_object *tag_obj;
     if (json_object_object_get_ex(targetRelease, "tag_name", &tag_obj) &&
         json_object_is_type(tag_obj, json_type_string)) {
-        printf("使用Release Tag: %s\n", json_object_get_string(tag_obj));
-    }
-
-    // 释放旧的 release_id（如果存在）
-    if (config->release_id) {
-        free(config->release_id);
-        config->release_id = NULL;  // 设置为 NULL 避免后续使用已释放的内存
+        fprintf(statusStream(), "使用Release Tag: %s\n", json_object_get_string(tag_obj));
     }
 
     new_release_id = strdup(temp_id);
@@ -400,23 +1110,29 @@ static ErrorCode getLatestReleaseId(Config *config) {
         goto cleanup;
     }
 
+    // 释放旧的 release_id（如果存在）
+    if (config->release_id) {
+        free(config->release_id);
+    }
     config->release_id = new_release_id;
     new_release_id = NULL;
-    printf("使用Release ID: %s\n", config->release_id);
+    fprintf(statusStream(), "使用Release ID: %s\n", config->release_id);
+
+    // 返回的 Release 对象已包含 upload_url 和资产列表，直接填充缓存
+    if (config->release_cache) {
+        releaseCacheLoadJson(config->release_cache, config->release_id, targetRelease);
+    }
 
 cleanup:
     if (root) json_object_put(root);
-    if (chunk.memory) free(chunk.memory);
-    if (headers) curl_slist_free_all(headers);
-    if (curl) curl_easy_cleanup(curl);
-    if (url) free(url);
+    if (escaped_tag) curl_free(escaped_tag);
     if (new_release_id) free(new_release_id);
 
     return result;
 }
 
-// 设置常用的GitHub API请求头
-static struct curl_slist* setGithubHeaders(const char *token, const char *content_type) {
+// 设置常用的GitHub API请求头（临时字符串从 arena 分配）
+static struct curl_slist* setGithubHeaders(Arena *arena, const char *token, const char *content_type) {
     struct curl_slist *headers = NULL;
     struct curl_slist *new_headers;
 
@@ -426,23 +1142,8 @@ static struct curl_slist* setGithubHeaders(const char *token, const char *conten
     headers = curl_slist_append(headers, "X-GitHub-Api-Version: 2022-11-28");
     if (!headers) return NULL;
 
-    char *auth_header = NULL;
-    int auth_len = snprintf(NULL, 0, "Authorization: Bearer %s", token);
-    if (auth_len < 0) {
-        curl_slist_free_all(headers);
-        return NULL;
-    }
-
-    auth_header = malloc(auth_len + 1);
-    if (!auth_header) {
-        curl_slist_free_all(headers);
-        return NULL;
-    }
-
-    snprintf(auth_header, auth_len + 1, "Authorization: Bearer %s", token);
-    new_headers = curl_slist_append(headers, auth_header);
-    free(auth_header);
-
+    char *auth_header = arenaPrintf(arena, "Authorization: Bearer %s", token);
+    new_headers = auth_header ? curl_slist_append(headers, auth_header) : NULL;
     if (!new_headers) {
         curl_slist_free_all(headers);
         return NULL;
@@ -450,23 +1151,8 @@ static struct curl_slist* setGithubHeaders(const char *token, const char *conten
     headers = new_headers;
 
     if (content_type) {
-        char *content_type_header = NULL;
-        int ct_len = snprintf(NULL, 0, "Content-Type: %s", content_type);
-        if (ct_len < 0) {
-            curl_slist_free_all(headers);
-            return NULL;
-        }
-
-        content_type_header = malloc(ct_len + 1);
-        if (!content_type_header) {
-            curl_slist_free_all(headers);
-            return NULL;
-        }
-
-        snprintf(content_type_header, ct_len + 1, "Content-Type: %s", content_type);
-        new_headers = curl_slist_append(headers, content_type_header);
-        free(content_type_header);
-
+        char *content_type_header = arenaPrintf(arena, "Content-Type: %s", content_type);
+        new_headers = content_type_header ? curl_slist_append(headers, content_type_header) : NULL;
         if (!new_headers) {
             curl_slist_free_all(headers);
             return NULL;
@@ -480,91 +1166,597 @@ static struct curl_slist* setGithubHeaders(const char *token, const char *conten
 // HTTP响应回调函数
 static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
     size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+    ResponseBuffer *buf = (ResponseBuffer *)userp;
 
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if(ptr == NULL) {
+    if (responseBufferReserve(buf, realsize) != ERR_OK) {
         printf("Not enough memory (realloc returned NULL)\n");
         return 0;
     }
 
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
+    memcpy(buf->data + buf->size, contents, realsize);
+    buf->size += realsize;
+    buf->data[buf->size] = 0;
 
     return realsize;
 }
 
-// 验证文件路径是否安全（防止路径遍历）
-static int is_safe_path(const char *path) {
-    if (!path) return 0;
-
-    // 检查是否包含 "../" 或 "..\"
-    if (strstr(path, "../") || strstr(path, "..\\")) {
-        return 0;
+// 释放响应头信息
+static void freeResponseHeaders(ResponseHeaders *headers) {
+    if (headers->next_url) {
+        free(headers->next_url);
+        headers->next_url = NULL;
     }
-
-    // 如果以 "/" 开头，可能是绝对路径，限制访问
-    if (path[0] == '/') {
-        return 0;
+    if (headers->last_url) {
+        free(headers->last_url);
+        headers->last_url = NULL;
     }
-
-    return 1;
 }
 
-// 读取文件到缓冲区
-char* readFileToBuffer(const char *filename, long *file_size) {
-    if (!is_safe_path(filename)) {
-        fprintf(stderr, "无效的文件路径: %s\n", filename);
+// 从 Link 头中取出 rel 参数为 relation（如 "next"）的地址
+static char* parseLinkRel(const char *value, size_t len, const char *relation) {
+    const char *end = value + len;
+    const char *p = value;
+    char wanted[32];
+    int wantedLen = snprintf(wanted, sizeof(wanted), "rel=\"%s\"", relation);
+    if (wantedLen < 0 || wantedLen >= (int)sizeof(wanted)) {
         return NULL;
     }
 
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        printf("无法打开文件: %s\n", filename);
-        return NULL;
-    }
+    while (p < end) {
+        const char *open = memchr(p, '<', end - p);
+        if (!open) break;
+        const char *close = memchr(open, '>', end - open);
+        if (!close) break;
 
-    fseek(file, 0, SEEK_END);
-    *file_size = ftell(file);
-    if (*file_size < 0) {
-        perror("获取文件大小失败");
-        fclose(file);
-        return NULL;
-    }
-    fseek(file, 0, SEEK_SET);
+        // 当前链接的参数到下一个逗号为止
+        const char *next = memchr(close, ',', end - close);
+        const char *params_end = next ? next : end;
+        const char *rel = close;
+        while ((rel = memchr(rel, 'r', params_end - rel)) != NULL) {
+            if (params_end - rel >= wantedLen && strncmp(rel, wanted, wantedLen) == 0) {
+                return strndup(open + 1, close - open - 1);
+            }
+            rel++;
+        }
 
-    if (*file_size == 0) {
-        printf("文件为空\n");
-        fclose(file);
-        return NULL;
+        p = next ? next + 1 : end;
     }
+    return NULL;
+}
 
-    // 对于非常大的文件进行检查，防止内存耗尽
-    if (*file_size > 1024L * 1024L * 1024L) { // 1GB
-        printf("文件过大\n");
-        fclose(file);
-        return NULL;
-    }
+// HTTP响应头回调函数
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    size_t realsize = size * nitems;
+    ResponseHeaders *headers = (ResponseHeaders *)userp;
 
-    char *buffer = malloc(*file_size);
-    if (!buffer) {
-        printf("内存分配失败\n");
-        fclose(file);
-        return NULL;
+    rateLimitObserveHeader(buffer, realsize);
+
+    if (realsize > 5 && strncasecmp(buffer, "Link:", 5) == 0) {
+        char *next_url = parseLinkRel(buffer + 5, realsize - 5, "next");
+        if (next_url) {
+            free(headers->next_url);
+            headers->next_url = next_url;
+        }
+        char *last_url = parseLinkRel(buffer + 5, realsize - 5, "last");
+        if (last_url) {
+            free(headers->last_url);
+            headers->last_url = last_url;
+        }
     }
 
-    size_t result = fread(buffer, 1, *file_size, file);
-    if (result != (size_t)*file_size) {
-        printf("文件读取失败\n");
-        free(buffer);
-        fclose(file);
+    return realsize;
+}
+
+// json-c 0.15 之前没有 json_tokener_get_parse_end
+#if defined(JSON_C_VERSION_NUM) && JSON_C_VERSION_NUM >= ((0 << 16) | (15 << 8))
+#define jsonTokenerParseEnd(tok) json_tokener_get_parse_end(tok)
+#else
+#define jsonTokenerParseEnd(tok) ((size_t)(tok)->char_offset)
+#endif
+
+// 初始化 JSON 接收器；on_element 非 NULL 时按顶层数组元素逐个回调
+static ErrorCode initJsonSink(JsonSink *sink, JsonElementCallback on_element, void *userp) {
+    memset(sink, 0, sizeof(*sink));
+    sink->tok = json_tokener_new();
+    if (!sink->tok) {
+        return ERR_MEMORY;
+    }
+    sink->on_element = on_element;
+    sink->userp = userp;
+    sink->state = JSON_SINK_START;
+    sink->error = ERR_OK;
+    return ERR_OK;
+}
+
+static void freeJsonSink(JsonSink *sink) {
+    if (sink->tok) {
+        json_tokener_free(sink->tok);
+        sink->tok = NULL;
+    }
+    if (sink->root) {
+        json_object_put(sink->root);
+        sink->root = NULL;
+    }
+}
+
+// 错误响应中的 message 字段，没有时返回 NULL
+static const char* jsonSinkMessage(const JsonSink *sink) {
+    struct json_object *message;
+    if (!sink->root || !json_object_object_get_ex(sink->root, "message", &message)) {
         return NULL;
     }
+    return json_object_get_string(message);
+}
+
+// 检查接收结果：解析出错或响应不完整时返回错误
+static ErrorCode finishJsonSink(JsonSink *sink) {
+    if (sink->error != ERR_OK) {
+        return sink->error;
+    }
+    if (sink->stopped || sink->state == JSON_SINK_DONE) {
+        return ERR_OK;
+    }
+    return ERR_JSON_PARSE;
+}
+
+// 把一段数据交给 tokener；返回已消费的字节数，-1 表示解析出错，数据不完整时消费全部
+static long feedJsonTokener(JsonSink *sink, const char *data, size_t len, struct json_object **out) {
+    *out = json_tokener_parse_ex(sink->tok, data, (int)len);
+    enum json_tokener_error jerr = json_tokener_get_error(sink->tok);
+
+    if (jerr == json_tokener_continue) {
+        return (long)len;
+    }
+    if (jerr != json_tokener_success) {
+        log_error("解析JSON失败: %s", json_tokener_error_desc(jerr));
+        return -1;
+    }
+
+    size_t consumed = jsonTokenerParseEnd(sink->tok);
+    json_tokener_reset(sink->tok);
+    return (long)consumed;
+}
+
+// curl 写回调：边接收边解析，不缓存完整响应体
+static size_t JsonSinkWriteCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    JsonSink *sink = (JsonSink *)userp;
+    const char *p = (const char *)contents;
+    size_t len = realsize;
+
+    if (sink->error != ERR_OK || sink->stopped) {
+        return 0;
+    }
+
+    while (len > 0) {
+        struct json_object *obj = NULL;
+        long consumed;
+
+        switch (sink->state) {
+            case JSON_SINK_START:
+                while (len > 0 && isspace((unsigned char)*p)) { p++; len--; }
+                if (len == 0) break;
+                if (sink->on_element && *p == '[') {
+                    sink->state = JSON_SINK_BETWEEN;
+                    p++;
+                    len--;
+                } else {
+                    // 非数组（或未要求逐个回调）时整体解析，错误响应也走这里
+                    sink->state = JSON_SINK_WHOLE;
+                }
+                break;
+
+            case JSON_SINK_WHOLE:
+                consumed = feedJsonTokener(sink, p, len, &obj);
+                if (consumed < 0) {
+                    sink->error = ERR_JSON_PARSE;
+                    return 0;
+                }
+                if (obj) {
+                    sink->root = obj;
+                    sink->state = JSON_SINK_DONE;
+                }
+                return realsize;
+
+            case JSON_SINK_BETWEEN:
+                while (len > 0 && (isspace((unsigned char)*p) || *p == ',')) { p++; len--; }
+                if (len == 0) break;
+                if (*p == ']') {
+                    sink->state = JSON_SINK_DONE;
+                    return realsize;
+                }
+                sink->state = JSON_SINK_ELEMENT;
+                break;
+
+            case JSON_SINK_ELEMENT:
+                consumed = feedJsonTokener(sink, p, len, &obj);
+                if (consumed < 0) {
+                    sink->error = ERR_JSON_PARSE;
+                    return 0;
+                }
+                p += consumed;
+                len -= (size_t)consumed;
+                if (!obj) break;
+
+                sink->state = JSON_SINK_BETWEEN;
+                sink->elements++;
+                int stop = sink->on_element(obj, sink->userp);
+                json_object_put(obj);
+                if (stop) {
+                    // 已找到所需数据，中止剩余传输
+                    sink->stopped = 1;
+                    return 0;
+                }
+                break;
+
+            case JSON_SINK_DONE:
+            default:
+                return realsize;
+        }
+    }
+
+    return realsize;
+}
+
+// 发送 GET 请求，响应体在接收过程中直接交给 JSON 接收器解析
+// HTTP 错误时返回 ERR_HTTP_ERROR，状态码通过 out_http_code 返回；out_headers 可为 NULL
+static ErrorCode githubGetStream(const Config *config, const char *url, JsonSink *sink,
+                                 long *out_http_code, ResponseHeaders *out_headers) {
+    CURL *curl = NULL;
+    struct curl_slist *headers = NULL;
+    ErrorCode result = ERR_OK;
+
+    *out_http_code = 0;
+
+    curl = acquireCurlHandle();
+    if (!curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    headers = setGithubHeaders(commandArena(config), config->token, NULL);
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, JsonSinkWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)sink);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    if (out_headers) {
+        freeResponseHeaders(out_headers);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)out_headers);
+    }
+
+    CURLcode res = performRequest(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, out_http_code);
+
+    // 接收器主动停止时 curl 返回写入错误，这是正常结束
+    if (res != CURLE_OK && !(res == CURLE_WRITE_ERROR && sink->stopped)) {
+        if (res == CURLE_WRITE_ERROR && sink->error != ERR_OK) {
+            fprintf(stderr, "解析JSON失败\n");
+            result = sink->error;
+        } else {
+            fprintf(stderr, "请求失败: %s\n", curl_easy_strerror(res));
+            result = ERR_CURL_PERFORM;
+        }
+        goto cleanup;
+    }
+
+    if (*out_http_code >= 400) {
+        if (*out_http_code != 404) {
+            fprintf(stderr, "HTTP错误: %ld\n", *out_http_code);
+        }
+        rateLimitObserveBody(*out_http_code, jsonSinkMessage(sink));
+        result = ERR_HTTP_ERROR;
+        goto cleanup;
+    }
+
+    result = finishJsonSink(sink);
+    if (result != ERR_OK) {
+        fprintf(stderr, "解析JSON失败\n");
+    }
+
+cleanup:
+    if (headers) curl_slist_free_all(headers);
+    if (curl) releaseCurlHandle(curl);
+
+    return result;
+}
+
+// 发送 GET 请求并解析 JSON 响应（增量解析，不缓存完整响应体）
+static ErrorCode githubGetJson(const Config *config, const char *url, struct json_object **out_root,
+                               long *out_http_code, ResponseHeaders *out_headers) {
+    JsonSink sink;
+
+    *out_root = NULL;
+    if (initJsonSink(&sink, NULL, NULL) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    ErrorCode result = githubGetStream(config, url, &sink, out_http_code, out_headers);
+    if (result == ERR_OK) {
+        *out_root = sink.root;
+        sink.root = NULL;
+    }
+
+    freeJsonSink(&sink);
+    return result;
+}
+
+// 验证文件路径是否安全（防止路径遍历）
+static int is_safe_path(const char *path) {
+    if (!path) return 0;
+
+    // 检查是否包含 "../" 或 "..\"
+    if (strstr(path, "../") || strstr(path, "..\\")) {
+        return 0;
+    }
+
+    // 如果以 "/" 开头，可能是绝对路径，限制访问
+    if (path[0] == '/') {
+        return 0;
+    }
+
+    return 1;
+}
+
+// 映射的文件在上传过程中被截断后，访问超出文件末尾的页会触发 SIGBUS。
+// 读回调复制映射内容时设置跳转点，信号处理函数跳回去按读取失败处理。
+// volatile：编译器知道 memcpy 不读它，否则会把复制前的赋值当作无用的写入删掉
+static __thread sigjmp_buf *volatile upload_map_guard = NULL;
+static pthread_once_t upload_map_guard_once = PTHREAD_ONCE_INIT;
+
+static void uploadMapSigbusHandler(int sig) {
+    if (upload_map_guard) {
+        siglongjmp(*upload_map_guard, 1);
+    }
+    // 不是复制映射时发生的，恢复默认处理并重新触发
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// SA_NODEFER：跳出处理函数后 SIGBUS 不会保持屏蔽，sigsetjmp 因此无需保存信号掩码（省一次系统调用）
+static void installUploadMapGuard(void) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = uploadMapSigbusHandler;
+    action.sa_flags = SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGBUS, &action, NULL);
+}
+
+// 从映射复制一段内容，文件已被截断（触发 SIGBUS）时返回 -1
+static int copyFromMapping(char *dst, const unsigned char *src, size_t len) {
+    sigjmp_buf env;
+    if (sigsetjmp(env, 0)) {
+        upload_map_guard = NULL;
+        return -1;
+    }
+    upload_map_guard = &env;
+    memcpy(dst, src, len);
+    upload_map_guard = NULL;
+    return 0;
+}
+
+// 把大文件整个映射到内存，读回调直接从映射复制到 curl 的缓冲区，不再逐块 pread；
+// 并提示内核顺序预读。映射失败时继续用 pread 读取
+static void mapUploadSource(UploadSource *source) {
+    pthread_once(&upload_map_guard_once, installUploadMapGuard);
+    void *map = mmap(NULL, (size_t)source->size, PROT_READ, MAP_SHARED, source->fd, (off_t)source->base);
+    if (map == MAP_FAILED) {
+        log_debug("mmap 失败（%s），改用 pread 读取", strerror(errno));
+        return;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, (size_t)source->size, MADV_SEQUENTIAL);
+#endif
+    source->map = map;
+    source->dropped = 0;
+}
+
+// 释放映射中已发送部分的页：madvise 解除映射，posix_fadvise 让内核把它们从页缓存中丢掉，
+// 上传几 GB 的文件既不占用进程内存，也不会挤掉页缓存中的其他数据（如构建缓存）。
+// 重试时需要的页再从磁盘读取
+static void dropSentPages(UploadSource *source) {
+    static curl_off_t pageSize = 0;
+    if (pageSize == 0) pageSize = (curl_off_t)sysconf(_SC_PAGESIZE);
+
+    curl_off_t end = source->position;
+    if (end < source->size) {
+        end -= end % pageSize;
+    }
+    if (end <= source->dropped) {
+        return;
+    }
+
+#ifdef MADV_DONTNEED
+    madvise(source->map + source->dropped, (size_t)(end - source->dropped), MADV_DONTNEED);
+#endif
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(source->fd, (off_t)(source->base + source->dropped), (off_t)(end - source->dropped),
+                  POSIX_FADV_DONTNEED);
+#endif
+    source->dropped = end;
+}
+
+// 打开上传数据源，只记录文件大小，内容在传输时按块读取；
+// compression 非 NULL 时先把文件压缩到内存，上传压缩后的内容
+static ErrorCode openUploadSource(UploadSource *source, const char *filename,
+                                  const UploadCompression *compression) {
+    return openUploadRange(source, filename, compression, 0, -1);
+}
+
+// 同 openUploadSource，length 不小于 0 时只上传文件中 [offset, offset + length) 这一段
+// （--split 的分片，offset 按 SPLIT_ALIGN 对齐，可以直接映射）
+static ErrorCode openUploadRange(UploadSource *source, const char *filename,
+                                 const UploadCompression *compression, curl_off_t offset, curl_off_t length) {
+    source->fd = -1;
+    source->size = 0;
+    source->position = 0;
+    source->data = NULL;
+    source->map = NULL;
+    source->dropped = 0;
+    source->base = 0;
+
+    if (!is_safe_path(filename)) {
+        fprintf(stderr, "无效的文件路径: %s\n", filename);
+        return ERR_INVALID_PATH;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("无法打开文件: %s\n", filename);
+        return ERR_FILE_IO;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("获取文件大小失败");
+        close(fd);
+        return ERR_FILE_IO;
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        printf("不是普通文件: %s\n", filename);
+        close(fd);
+        return ERR_FILE_IO;
+    }
+
+    if (st.st_size == 0) {
+        printf("文件为空\n");
+        close(fd);
+        return ERR_FILE_IO;
+    }
+
+    if (length >= 0 && (curl_off_t)st.st_size < offset + length) {
+        printf("文件在上传过程中变小了: %s\n", filename);
+        close(fd);
+        return ERR_FILE_IO;
+    }
+
+    // GitHub 不接受超过 2 GiB 的资产（压缩时检查压缩后的大小，分片的大小在切分时已限制）
+    if (length < 0 && (long long)st.st_size >= MAX_ASSET_SIZE && !compression) {
+        printf("文件过大（GitHub 单个文件需小于 2 GiB，可以用 --split 分片上传）\n");
+        close(fd);
+        return ERR_FILE_IO;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    source->fd = fd;
+    source->size = length >= 0 ? length : (curl_off_t)st.st_size;
+    source->base = length >= 0 ? offset : 0;
+
+    if (!compression && source->size >= UPLOAD_MMAP_MIN) {
+        mapUploadSource(source);
+    }
+
+    if (compression) {
+        ErrorCode result = compressUploadSource(source, compression, filename);
+        if (result != ERR_OK) {
+            closeUploadSource(source);
+            return result;
+        }
+    }
+    return ERR_OK;
+}
+
+// 关闭上传数据源
+static void closeUploadSource(UploadSource *source) {
+    compressBudgetShrink(source, 0);
+    if (source->map) {
+        munmap(source->map, (size_t)source->size);
+        source->map = NULL;
+        source->dropped = 0;
+    }
+    if (source->hasher) {
+        freeUploadHasher(source->hasher);
+        source->hasher = NULL;
+    }
+    if (source->fd >= 0) {
+        close(source->fd);
+        source->fd = -1;
+    }
+    free(source->data);
+    source->data = NULL;
+    source->size = 0;
+    source->position = 0;
+    source->base = 0;
+}
+
+// curl 读回调：直接读入 curl 的上传缓冲区
+static size_t UploadReadCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    UploadSource *source = (UploadSource *)userp;
+    size_t want = size * nitems;
+    curl_off_t remaining = source->size - source->position;
+
+    if (remaining <= 0) {
+        return 0;
+    }
+    if ((curl_off_t)want > remaining) {
+        want = (size_t)remaining;
+    }
+    if (source->pausable) {
+        want = uploadRateTake(source, want);
+        if (want == 0) {
+            return CURL_READFUNC_PAUSE;
+        }
+    }
+
+    ssize_t n;
+    if (source->data) {
+        memcpy(buffer, source->data + source->position, want);
+        n = (ssize_t)want;
+    } else if (source->map) {
+        // 重发时回到了已释放的位置，之后重新计算释放范围
+        if (source->position < source->dropped) {
+            source->dropped = 0;
+        }
+        // 文件被截断时复制会触发 SIGBUS，由 copyFromMapping 捕获后按截断处理
+        n = copyFromMapping(buffer, source->map + source->position, want) == 0 ? (ssize_t)want : 0;
+    } else {
+        do {
+            n = pread(source->fd, buffer, want, (off_t)(source->base + source->position));
+        } while (n < 0 && errno == EINTR);
+    }
+
+    if (n <= 0) {
+        // 文件在上传过程中被截断或读取出错
+        log_error("读取上传文件失败: %s", n < 0 ? strerror(errno) : "文件被截断");
+        return CURL_READFUNC_ABORT;
+    }
+
+    if (source->hasher) {
+        uploadHasherFeed(source->hasher, buffer, (size_t)n, source->position);
+    }
+    source->position += n;
+    if (source->map && (source->position - source->dropped >= UPLOAD_DROP_CHUNK ||
+                        source->position == source->size)) {
+        dropSentPages(source);
+    }
+    return (size_t)n;
+}
 
-    fclose(file);
-    return buffer;
+// curl 定位回调：重定向或认证重发时需要回到开头
+static int UploadSeekCallback(void *userp, curl_off_t offset, int origin) {
+    UploadSource *source = (UploadSource *)userp;
+    curl_off_t target;
+
+    switch (origin) {
+        case SEEK_SET: target = offset; break;
+        case SEEK_CUR: target = source->position + offset; break;
+        case SEEK_END: target = source->size + offset; break;
+        default: return CURL_SEEKFUNC_CANTSEEK;
+    }
+
+    if (target < 0 || target > source->size) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+    source->position = target;
+    return CURL_SEEKFUNC_OK;
 }
 
 // 获取文件名
@@ -576,29 +1768,11 @@ const char* getFilenameFromPath(const char *path) {
     return path;
 }
 
-// 创建URL的辅助函数
-static char* create_url(const char *format, ...) {
+// 创建URL的辅助函数，URL 从命令的 arena 中分配，不需要单独释放
+static char* create_url(Arena *arena, const char *format, ...) {
     va_list args;
-    va_list args_copy;
     va_start(args, format);
-
-    // 先计算所需长度
-    va_copy(args_copy, args);
-    int len = vsnprintf(NULL, 0, format, args_copy);
-    va_end(args_copy);
-
-    if (len < 0) {
-        va_end(args);
-        return NULL;
-    }
-
-    char *url = malloc(len + 1);
-    if (!url) {
-        va_end(args);
-        return NULL;
-    }
-
-    vsnprintf(url, len + 1, format, args);
+    char *url = arenaVprintf(arena, format, args);
     va_end(args);
 
     return url;
@@ -732,6 +1906,10 @@ static ErrorCode uploadMultipleFiles(int fileCount, char **filePaths, const Conf
     int success = 0;
     int failed = 0;
 
+    if (config->concurrency > 1 && fileCount > 1) {
+        return uploadMultipleFilesConcurrent(fileCount, filePaths, NULL, config, 0);
+    }
+
     printf("准备批量上传 %d 个文件...\n\n", fileCount);
 
     for (int i = 0; i < fileCount; i++) {
@@ -739,21 +1917,14 @@ static ErrorCode uploadMultipleFiles(int fileCount, char **filePaths, const Conf
         fflush(stdout);
 
         ErrorCode result = uploadFileWithRetry(filePaths[i], config, MAX_RETRIES);
+        // 每个文件的 URL 和请求头只在本次请求中使用，用完即可回收
+        arenaReset(commandArena(config));
         if (result == ERR_OK) {
             success++;
         } else {
             failed++;
             fprintf(stderr, "文件 \"%s\" 上传失败\n", filePaths[i]);
         }
-
-        // 在上传之间稍作延迟，避免触发API限制
-        if (i < fileCount - 1) {
-#ifdef _WIN32
-            Sleep(100);
-#else
-            usleep(100000);  // 0.1秒
-#endif
-        }
     }
 
     printf("\n===================================\n");
@@ -781,20 +1952,13 @@ static ErrorCode deleteMultipleFiles(int fileCount, char **fileNames, const Conf
         fflush(stdout);
 
         ErrorCode result = deleteFileWithRetry(fileNames[i], config, MAX_RETRIES);
+        // 每个文件的 URL 和请求头只在本次请求中使用，用完即可回收
+        arenaReset(commandArena(config));
         if (result == ERR_OK) {
             success++;
         } else {
             failed++;
         }
-
-        // 在删除之间稍作延迟，避免触发API限制
-        if (i < fileCount - 1) {
-#ifdef _WIN32
-            Sleep(100);
-#else
-            usleep(100000);  // 0.1秒
-#endif
-        }
     }
 
     printf("\n===================================\n");
@@ -817,7 +1981,7 @@ static ErrorCode updateFile(const char *filePath, const Config *config) {
         return ERR_CONFIG;
     }
 
-    const char *fileName = getFilenameFromPath(filePath);
+    const char *fileName = uploadAssetName(config, getFilenameFromPath(filePath));
 
     printf("准备更新文件 \"%s\"...\n", fileName);
 
@@ -853,6 +2017,11 @@ static ErrorCode updateMultipleFiles(int fileCount, char **filePaths, const Conf
         return ERR_CONFIG;
     }
 
+    // 多个文件时删除与上传流水线执行：上传第 N 个文件的同时删除第 N+1 个的旧版本
+    if (fileCount > 1) {
+        return uploadMultipleFilesConcurrent(fileCount, filePaths, NULL, config, 1);
+    }
+
     int success = 0;
     int failed = 0;
 
@@ -863,21 +2032,14 @@ static ErrorCode updateMultipleFiles(int fileCount, char **filePaths, const Conf
         fflush(stdout);
 
         ErrorCode result = updateFileWithRetry(filePaths[i], config, MAX_RETRIES);
+        // 每个文件的 URL 和请求头只在本次请求中使用，用完即可回收
+        arenaReset(commandArena(config));
         if (result == ERR_OK) {
             success++;
         } else {
             failed++;
             fprintf(stderr, "文件 \"%s\" 更新失败\n", filePaths[i]);
         }
-
-        // 在更新之间稍作延迟，避免触发API限制
-        if (i < fileCount - 1) {
-#ifdef _WIN32
-            Sleep(100);
-#else
-            usleep(100000);  // 0.1秒
-#endif
-        }
     }
 
     printf("\n===================================\n");
@@ -889,1192 +2051,9020 @@ static ErrorCode updateMultipleFiles(int fileCount, char **filePaths, const Conf
     return (failed == 0) ? ERR_OK : ERR_CURL_PERFORM;
 }
 
-// 获取Release中的所有资产
-ErrorCode getAssets(struct MemoryStruct *chunk, const Config *config) {
-    if (validate_config(config) != ERR_OK) {
-        return ERR_CONFIG;
+// ==================== 内存复用 ====================
+
+// 从 arena 分配内存，按 8 字节对齐；块用完时追加新块
+static void* arenaAlloc(Arena *arena, size_t n) {
+    n = (n + 7) & ~(size_t)7;
+
+    ArenaBlock *block = arena->head;
+    if (!block || block->capacity - block->used < n) {
+        size_t capacity = n > ARENA_BLOCK_SIZE ? n : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + capacity);
+        if (!block) return NULL;
+        block->capacity = capacity;
+        block->used = 0;
+        block->next = arena->head;
+        arena->head = block;
     }
 
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    ErrorCode result = ERR_OK;
-    char *url = NULL;
+    void *ptr = block->data + block->used;
+    block->used += n;
+    return ptr;
+}
 
-    url = create_url("https://api.github.com/repos/%s/%s/releases/%s",
-                     config->owner, config->repo, config->release_id);
-    if (!url) {
-        fprintf(stderr, "内存分配失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
+// 在 arena 中格式化字符串
+static char* arenaVprintf(Arena *arena, const char *format, va_list args) {
+    va_list args_copy;
+
+    // 先计算所需长度
+    va_copy(args_copy, args);
+    int len = vsnprintf(NULL, 0, format, args_copy);
+    va_end(args_copy);
+
+    if (len < 0) {
+        return NULL;
     }
 
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "初始化 CURL 失败\n");
-        result = ERR_CURL_INIT;
-        goto cleanup;
+    char *str = arenaAlloc(arena, (size_t)len + 1);
+    if (!str) {
+        return NULL;
     }
 
-    headers = setGithubHeaders(config->token, NULL);
+    vsnprintf(str, (size_t)len + 1, format, args);
+    return str;
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)chunk);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "获取Release信息失败: %s\n", curl_easy_strerror(res));
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
-    }
+static char* arenaPrintf(Arena *arena, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    char *str = arenaVprintf(arena, format, args);
+    va_end(args);
+    return str;
+}
 
-    // 检查HTTP响应码
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    if (response_code >= 400) {
-        fprintf(stderr, "HTTP错误: %ld\n", response_code);
-        result = ERR_HTTP_ERROR;
-        goto cleanup;
+static char* arenaStrdup(Arena *arena, const char *str) {
+    size_t len = strlen(str);
+    char *copy = arenaAlloc(arena, len + 1);
+    if (copy) {
+        memcpy(copy, str, len + 1);
     }
+    return copy;
+}
 
-cleanup:
-    if (headers) curl_slist_free_all(headers);
-    if (curl) curl_easy_cleanup(curl);
-    if (url) free(url);
+// 重置 arena：保留最近的一个块供下次使用，其余释放
+static void arenaReset(Arena *arena) {
+    ArenaBlock *block = arena->head;
+    if (!block) return;
 
-    return result;
+    ArenaBlock *next = block->next;
+    while (next) {
+        ArenaBlock *tmp = next->next;
+        free(next);
+        next = tmp;
+    }
+    block->next = NULL;
+    block->used = 0;
 }
 
-// 删除指定的资产
-ErrorCode deleteAsset(const char *assetId, const char *assetName, const Config *config) {
-    if (validate_config(config) != ERR_OK) {
-        return ERR_CONFIG;
+static void arenaFree(Arena *arena) {
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
     }
+    arena->head = NULL;
+}
 
-    if (!assetId || !assetName) {
-        fprintf(stderr, "错误：assetId 和 assetName 不能为空\n");
-        return ERR_CONFIG;
+// 确保缓冲区还能容纳 extra 字节（另加结尾的 '\0'），容量按 2 倍增长
+static ErrorCode responseBufferReserve(ResponseBuffer *buf, size_t extra) {
+    size_t needed = buf->size + extra + 1;
+    if (needed <= buf->capacity) {
+        return ERR_OK;
     }
 
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    ErrorCode result = ERR_OK;
-    char *url = NULL;
+    size_t capacity = buf->capacity ? buf->capacity : RESPONSE_BUFFER_INITIAL;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
 
-    url = create_url("https://api.github.com/repos/%s/%s/releases/assets/%s",
-                     config->owner, config->repo, assetId);
-    if (!url) {
-        fprintf(stderr, "内存分配失败\n");
+    char *data = realloc(buf->data, capacity);
+    if (!data) {
         return ERR_MEMORY;
     }
+    buf->data = data;
+    buf->capacity = capacity;
+    return ERR_OK;
+}
 
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "初始化 CURL 失败\n");
-        free(url);
-        return ERR_CURL_INIT;
+// 清空内容但保留容量，供下一个请求复用
+static void responseBufferReset(ResponseBuffer *buf) {
+    buf->size = 0;
+    if (buf->data) {
+        buf->data[0] = '\0';
     }
+}
 
-    headers = setGithubHeaders(config->token, NULL);
+static void responseBufferFree(ResponseBuffer *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+// 本次命令的 arena
+static Arena* commandArena(const Config *config) {
+    return &config->scratch->arena;
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "删除资产失败: %s\n", curl_easy_strerror(res));
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
+// 取出本次命令共享的响应缓冲区（已清空），只能用于顺序执行的请求
+static ResponseBuffer* scratchResponse(const Config *config) {
+    ResponseBuffer *buf = &config->scratch->response;
+    responseBufferReset(buf);
+    if (responseBufferReserve(buf, 0) != ERR_OK) {
+        return NULL;
     }
+    return buf;
+}
 
-    // 检查HTTP响应码
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    if (response_code >= 400) {
-        fprintf(stderr, "删除资产失败，HTTP错误: %ld\n", response_code);
-        result = ERR_HTTP_ERROR;
-        goto cleanup;
-    }
+// 一条命令结束后清空临时内存，保留一个 arena 块和响应缓冲区的容量给下一条命令
+static void resetCommandScratch(CommandScratch *scratch) {
+    arenaReset(&scratch->arena);
+    responseBufferReset(&scratch->response);
+}
 
-    printf("\n✅ 文件 \"%s\" 删除成功!\n", assetName);
-    result = ERR_OK;
+// 释放命令的临时内存
+static void freeCommandScratch(CommandScratch *scratch) {
+    arenaFree(&scratch->arena);
+    responseBufferFree(&scratch->response);
+}
 
-cleanup:
-    if (url) free(url);
-    if (headers) curl_slist_free_all(headers);
-    if (curl) curl_easy_cleanup(curl);
+// ==================== 连接复用 ====================
 
-    return result;
+// 所有请求共享 DNS 缓存、TLS 会话和连接池，空闲的 easy 句柄放回池中复用，
+// 批量操作因此可以复用已经建立好的 TCP+TLS 连接
+#define HANDLE_POOL_SIZE (MAX_CONCURRENCY + 4)
+
+typedef struct {
+    CURLSH *share;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+    pthread_mutex_t pool_lock;
+    CURL *idle[HANDLE_POOL_SIZE];
+    int idle_count;
+    long requests;          // 已完成的请求数
+    long new_connections;   // 其中新建连接（需要握手）的次数
+} HttpPool;
+
+static HttpPool http_pool = {
+    .pool_lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void shareLockCallback(CURL *handle, curl_lock_data data, curl_lock_access access, void *userp) {
+    (void)handle;
+    (void)access;
+    pthread_mutex_lock(&((HttpPool *)userp)->locks[data]);
 }
 
-// 上传文件
-ErrorCode uploadFile(const char *filePath, const Config *config) {
-    if (validate_config(config) != ERR_OK) {
-        return ERR_CONFIG;
+static void shareUnlockCallback(CURL *handle, curl_lock_data data, void *userp) {
+    (void)handle;
+    pthread_mutex_unlock(&((HttpPool *)userp)->locks[data]);
+}
+
+// 初始化共享对象，需在 curl_global_init 之后调用
+static ErrorCode initHttpPool(void) {
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&http_pool.locks[i], NULL);
     }
 
-    if (!filePath) {
-        fprintf(stderr, "错误：文件路径不能为空\n");
-        return ERR_CONFIG;
+    http_pool.share = curl_share_init();
+    if (!http_pool.share) {
+        log_error("初始化 CURL 共享对象失败");
+        return ERR_CURL_INIT;
     }
 
-    CURL *curl = NULL;
-    struct MemoryStruct chunk = {NULL, 0};
-    struct curl_slist *headers = NULL;
-    struct json_object *root = NULL;
-    struct json_object *uploadResponse = NULL;
-    char *fileBuffer = NULL;
-    char *uploadUrl = NULL;
-    ErrorCode result = ERR_OK;
+    curl_share_setopt(http_pool.share, CURLSHOPT_LOCKFUNC, shareLockCallback);
+    curl_share_setopt(http_pool.share, CURLSHOPT_UNLOCKFUNC, shareUnlockCallback);
+    curl_share_setopt(http_pool.share, CURLSHOPT_USERDATA, (void *)&http_pool);
+    curl_share_setopt(http_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(http_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900  // 7.57.0 起支持共享连接池
+    curl_share_setopt(http_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
 
-    // 首先获取Release信息
-    chunk.memory = malloc(1);
-    if (!chunk.memory) {
-        fprintf(stderr, "内存分配失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
-    }
-    chunk.memory[0] = '\0';
-    chunk.size = 0;
+    return ERR_OK;
+}
 
-    if (getAssets(&chunk, config) != ERR_OK) {
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
+// 释放池中的句柄和共享对象，并在调试级别报告复用效果
+static void cleanupHttpPool(void) {
+    if (http_pool.requests > 0) {
+        log_debug("连接复用: %ld 个请求，新建 %ld 个连接，节省 %ld 次 TCP/TLS 握手",
+                  http_pool.requests, http_pool.new_connections,
+                  http_pool.requests - http_pool.new_connections);
     }
 
-    // 解析JSON获取upload_url
-    root = json_tokener_parse(chunk.memory);
-    if (!root) {
-        fprintf(stderr, "解析JSON失败\n");
-        result = ERR_JSON_PARSE;
-        goto cleanup;
+    pthread_mutex_lock(&http_pool.pool_lock);
+    for (int i = 0; i < http_pool.idle_count; i++) {
+        curl_easy_cleanup(http_pool.idle[i]);
     }
+    http_pool.idle_count = 0;
+    pthread_mutex_unlock(&http_pool.pool_lock);
 
-    struct json_object *upload_url_item;
-    if (!json_object_object_get_ex(root, "upload_url", &upload_url_item) ||
-        !json_object_is_type(upload_url_item, json_type_string)) {
-        fprintf(stderr, "获取upload_url失败\n");
-        result = ERR_JSON_TYPE;
-        goto cleanup;
+    if (http_pool.share) {
+        curl_share_cleanup(http_pool.share);
+        http_pool.share = NULL;
     }
 
-    const char *uploadUrlTemplate = json_object_get_string(upload_url_item);
-    const char *fileName = getFilenameFromPath(filePath);
-
-    // 动态构建上传URL，避免缓冲区溢出
-    size_t template_len = strlen(uploadUrlTemplate);
-    size_t filename_len = strlen(fileName);
-    size_t url_max_len = template_len + filename_len + 64; // +64 用于参数
-    uploadUrl = malloc(url_max_len);
-    if (!uploadUrl) {
-        fprintf(stderr, "内存分配失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&http_pool.locks[i]);
     }
+}
 
-    char *template_end = strstr(uploadUrlTemplate, "{?name,label}");
-    if (template_end) {
-        size_t prefix_len = template_end - uploadUrlTemplate;
-        snprintf(uploadUrl, url_max_len, "%.*s?name=%s",
-                 (int)prefix_len, uploadUrlTemplate, fileName);
-    } else {
-        snprintf(uploadUrl, url_max_len, "%s?name=%s", uploadUrlTemplate, fileName);
-    }
+// 从池中取出一个已重置的句柄，池为空时新建
+static CURL* acquireCurlHandle(void) {
+    CURL *curl = NULL;
 
-    // 读取文件
-    long fileSize = 0;
-    fileBuffer = readFileToBuffer(filePath, &fileSize);
-    if (!fileBuffer) {
-        result = ERR_FILE_IO;
-        goto cleanup;
+    pthread_mutex_lock(&http_pool.pool_lock);
+    if (http_pool.idle_count > 0) {
+        curl = http_pool.idle[--http_pool.idle_count];
     }
+    pthread_mutex_unlock(&http_pool.pool_lock);
 
-    printf("准备上传文件 \"%s\" (%ld bytes)...\n", fileName, fileSize);
-    printf("上传到: %s\n", uploadUrl);
-
-    // 准备上传
-    curl = curl_easy_init();
     if (!curl) {
-        fprintf(stderr, "初始化 CURL 失败\n");
-        result = ERR_CURL_INIT;
-        goto cleanup;
+        curl = curl_easy_init();
+        if (!curl) return NULL;
     }
 
-    headers = setGithubHeaders(config->token, "application/octet-stream");
-
-    // 构建 Content-Length 头
-    char content_length[64];
-    snprintf(content_length, sizeof(content_length), "Content-Length: %ld", fileSize);
-    headers = curl_slist_append(headers, content_length);
-    if (!headers) {
-        fprintf(stderr, "添加header失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
+    if (http_pool.share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, http_pool.share);
     }
 
-    chunk.size = 0;
-
-    curl_easy_setopt(curl, CURLOPT_URL, uploadUrl);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, fileBuffer);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, fileSize);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    // 每个请求都从这里取句柄：默认读取速率限制响应头，并按当前配额控制发出节奏
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, RateLimitHeaderCallback);
+    rateLimitAcquire();
+    applyRequestDeadline(curl, request_deadline);
+    return curl;
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "上传文件失败: %s\n", curl_easy_strerror(res));
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
-    }
+// 统计本次请求是否新建了连接，然后重置句柄放回池中
+static void releaseCurlHandle(CURL *curl) {
+    if (!curl) return;
 
-    // 检查HTTP响应码
-    long response_code;
+    // 只统计真正发出过的请求
+    long connects = 0;
+    long response_code = 0;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    if (response_code >= 400) {
-        fprintf(stderr, "上传文件失败，HTTP错误: %ld\n", response_code);
-        result = ERR_HTTP_ERROR;
-        goto cleanup;
+    rateLimitObserveStatus(response_code);
+    if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK &&
+        (response_code > 0 || connects > 0)) {
+        pthread_mutex_lock(&http_pool.pool_lock);
+        http_pool.requests++;
+        http_pool.new_connections += connects;
+        pthread_mutex_unlock(&http_pool.pool_lock);
     }
 
-    // 解析上传响应
-    uploadResponse = json_tokener_parse(chunk.memory);
-    if (uploadResponse) {
-        printf("\n✅ 文件上传成功!\n");
-
-        struct json_object *id;
-        if (json_object_object_get_ex(uploadResponse, "id", &id)) {
-            printf("   - Asset ID: %d\n", json_object_get_int(id));
-        }
+    // curl_easy_reset 会清除选项，但保留共享对象中的连接和会话缓存
+    curl_easy_reset(curl);
 
-        struct json_object *url;
-        if (json_object_object_get_ex(uploadResponse, "browser_download_url", &url) &&
-            json_object_is_type(url, json_type_string)) {
-            printf("   - 下载链接: %s\n", json_object_get_string(url));
-        }
-    } else {
-        printf("上传成功，但无法解析响应\n");
+    pthread_mutex_lock(&http_pool.pool_lock);
+    if (http_pool.idle_count < HANDLE_POOL_SIZE) {
+        http_pool.idle[http_pool.idle_count++] = curl;
+        curl = NULL;
     }
+    pthread_mutex_unlock(&http_pool.pool_lock);
 
-cleanup:
-    if (uploadResponse) json_object_put(uploadResponse);
-    if (uploadUrl) free(uploadUrl);
-    if (fileBuffer) free(fileBuffer);
-    if (root) json_object_put(root);
-    if (chunk.memory) free(chunk.memory);
-    if (headers) curl_slist_free_all(headers);
     if (curl) curl_easy_cleanup(curl);
-
-    return result;
 }
 
-// 删除文件
-ErrorCode deleteFile(const char *fileName, const Config *config) {
-    if (validate_config(config) != ERR_OK) {
-        return ERR_CONFIG;
-    }
+// ==================== 传输指标 ====================
 
-    if (!fileName) {
-        fprintf(stderr, "错误：文件名不能为空\n");
-        return ERR_CONFIG;
-    }
+// 每个请求结束时从 curl_easy_getinfo 取一条记录，命令结束时写成 JSON 或 CSV 报告（--metrics）
+// 时间均为 curl 的累计时间点（从请求开始计），单位微秒
+typedef struct {
+    char *label;             // 请求所属的文件，普通 API 请求为 NULL
+    char method[8];
+    long http_status;
+    CURLcode curl_code;
+    int attempt;             // 该文件的第几次尝试（从 1 开始）
+    curl_off_t dns_us;       // DNS 解析完成
+    curl_off_t connect_us;   // TCP 连接建立
+    curl_off_t tls_us;       // TLS 握手完成（复用连接或 HTTP 时为 0）
+    curl_off_t ttfb_us;      // 收到第一个响应字节
+    curl_off_t total_us;
+    curl_off_t bytes_up;
+    curl_off_t bytes_down;
+    double finished;         // 结束时间（单调时钟）
+} RequestMetric;
 
-    // 检查文件名是否包含非法字符
-    if (strchr(fileName, '/') || strchr(fileName, '\\')) {
-        fprintf(stderr, "错误：文件名不能包含路径分隔符\n");
-        return ERR_INVALID_PATH;
-    }
+typedef struct {
+    pthread_mutex_t lock;
+    int enabled;
+    RequestMetric *items;
+    size_t count;
+    size_t capacity;
+} MetricsLog;
+
+static MetricsLog metrics_log = {
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
 
-    struct MemoryStruct chunk = {NULL, 0};
-    struct json_object *root = NULL;
-    ErrorCode result = ERR_OK;
-    int found = 0;
+#define METRICS_TIME_FIELDS 5
+static const char *metrics_time_names[METRICS_TIME_FIELDS] = {"dns", "connect", "tls", "ttfb", "total"};
 
-    chunk.memory = malloc(1);
-    if (!chunk.memory) {
-        fprintf(stderr, "内存分配失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
+static curl_off_t metricTime(const RequestMetric *m, int field) {
+    switch (field) {
+        case 0: return m->dns_us;
+        case 1: return m->connect_us;
+        case 2: return m->tls_us;
+        case 3: return m->ttfb_us;
+        default: return m->total_us;
     }
-    chunk.memory[0] = '\0';
-    chunk.size = 0;
+}
 
-    // 获取资产列表
-    if (getAssets(&chunk, config) != ERR_OK) {
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
-    }
+static void enableMetrics(void) {
+    metrics_log.enabled = 1;
+}
 
-    // 解析JSON
-    root = json_tokener_parse(chunk.memory);
-    if (!root) {
-        fprintf(stderr, "解析JSON失败\n");
-        result = ERR_JSON_PARSE;
-        goto cleanup;
+// 记录一个已结束的请求（成功或失败），未启用 --metrics 时不做任何事
+static void metricsRecordRequest(CURL *curl, CURLcode res, const char *label, int attempt) {
+    if (!metrics_log.enabled) return;
+
+    RequestMetric m = {0};
+    m.curl_code = res;
+    m.attempt = attempt;
+    m.finished = monotonicSeconds();
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &m.http_status);
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &m.dns_us);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &m.connect_us);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &m.tls_us);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &m.ttfb_us);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &m.total_us);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &m.bytes_up);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &m.bytes_down);
+#if LIBCURL_VERSION_NUM >= 0x074800  // 7.72.0 起支持 CURLINFO_EFFECTIVE_METHOD
+    char *method = NULL;
+    if (curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_METHOD, &method) == CURLE_OK && method) {
+        snprintf(m.method, sizeof(m.method), "%s", method);
+    }
+#endif
+    if (label) {
+        m.label = strdup(label);
+    }
+
+    pthread_mutex_lock(&metrics_log.lock);
+    if (metrics_log.count == metrics_log.capacity) {
+        size_t capacity = metrics_log.capacity ? metrics_log.capacity * 2 : 64;
+        RequestMetric *items = realloc(metrics_log.items, capacity * sizeof(RequestMetric));
+        if (!items) {
+            pthread_mutex_unlock(&metrics_log.lock);
+            free(m.label);
+            return;
+        }
+        metrics_log.items = items;
+        metrics_log.capacity = capacity;
     }
+    metrics_log.items[metrics_log.count++] = m;
+    pthread_mutex_unlock(&metrics_log.lock);
+}
 
-    struct json_object *assets;
-    if (!json_object_object_get_ex(root, "assets", &assets) ||
-        !json_object_is_type(assets, json_type_array)) {
-        fprintf(stderr, "获取资产列表失败\n");
-        result = ERR_JSON_TYPE;
-        goto cleanup;
+static void freeMetrics(void) {
+    for (size_t i = 0; i < metrics_log.count; i++) {
+        free(metrics_log.items[i].label);
     }
+    free(metrics_log.items);
+    metrics_log.items = NULL;
+    metrics_log.count = 0;
+    metrics_log.capacity = 0;
+    metrics_log.enabled = 0;
+}
 
-    // 查找文件
-    int arraySize = json_object_array_length(assets);
-    for (int i = 0; i < arraySize; i++) {
-        struct json_object *asset = json_object_array_get_idx(assets, i);
-        struct json_object *name;
+static int metricFailed(const RequestMetric *m) {
+    return m->curl_code != CURLE_OK || m->http_status >= 400;
+}
 
-        if (json_object_object_get_ex(asset, "name", &name) &&
-            json_object_is_type(name, json_type_string) &&
-            strcmp(json_object_get_string(name), fileName) == 0) {
-            struct json_object *id;
-            if (json_object_object_get_ex(asset, "id", &id)) {
-                int id_value = json_object_get_int(id);
-                printf("找到文件 \"%s\" (ID: %d)，正在删除...\n", fileName, id_value);
+// 按文件（label）汇总的一行
+typedef struct {
+    const char *label;
+    int requests;
+    int retries;             // 重试发出的请求数
+    int failed;
+    curl_off_t bytes_up;
+    curl_off_t bytes_down;
+    curl_off_t total_us;     // 各请求耗时之和
+} MetricsGroup;
+
+static int compareMetricLabel(const void *a, const void *b) {
+    const RequestMetric *ma = *(const RequestMetric * const *)a;
+    const RequestMetric *mb = *(const RequestMetric * const *)b;
+    if (!ma->label || !mb->label) return (ma->label != NULL) - (mb->label != NULL);
+    return strcmp(ma->label, mb->label);
+}
 
-                // 动态分配ID字符串（避免静态缓冲区）
-                char *id_str = malloc(32);
-                if (!id_str) {
-                    fprintf(stderr, "内存分配失败\n");
-                    result = ERR_MEMORY;
-                    goto cleanup;
-                }
-                snprintf(id_str, 32, "%d", id_value);
+static int compareOffT(const void *a, const void *b) {
+    curl_off_t x = *(const curl_off_t *)a, y = *(const curl_off_t *)b;
+    return (x > y) - (x < y);
+}
 
-                ErrorCode ret = deleteAsset(id_str, fileName, config);
-                free(id_str);
+// 汇总后的报告数据
+typedef struct {
+    MetricsGroup *groups;
+    size_t group_count;
+    MetricsGroup total;
+    double wall_seconds;                          // 第一个请求开始到最后一个请求结束
+    curl_off_t percentiles[3][METRICS_TIME_FIELDS]; // p50/p95/p99
+} MetricsSummary;
 
-                if (ret == ERR_OK) {
-                    result = ERR_OK;
-                    found = 1;
-                    break;
-                } else {
-                    result = ret;
-                    goto cleanup;
-                }
-            }
-        }
+static const int metrics_percentiles[3] = {50, 95, 99};
+
+static double metricsMBps(curl_off_t bytes, double seconds) {
+    return seconds > 0 ? (double)bytes / seconds / 1e6 : 0;
+}
+
+static void metricsAccumulate(MetricsGroup *group, const RequestMetric *m) {
+    group->requests++;
+    if (m->attempt > 1) group->retries++;
+    if (metricFailed(m)) group->failed++;
+    group->bytes_up += m->bytes_up;
+    group->bytes_down += m->bytes_down;
+    group->total_us += m->total_us;
+}
+
+static ErrorCode summarizeMetrics(MetricsSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    size_t n = metrics_log.count;
+    if (n == 0) return ERR_OK;
+
+    const RequestMetric **sorted = malloc(n * sizeof(*sorted));
+    curl_off_t *values = malloc(n * sizeof(curl_off_t));
+    summary->groups = calloc(n, sizeof(MetricsGroup));
+    if (!sorted || !values || !summary->groups) {
+        free(sorted);
+        free(values);
+        free(summary->groups);
+        summary->groups = NULL;
+        return ERR_MEMORY;
     }
 
-    if (!found) {
-        fprintf(stderr, "错误：在Release中未找到名为 \"%s\" 的文件。\n", fileName);
-        result = ERR_NOT_FOUND;
+    double first_start = 0, last_end = 0;
+    for (size_t i = 0; i < n; i++) {
+        const RequestMetric *m = &metrics_log.items[i];
+        sorted[i] = m;
+        metricsAccumulate(&summary->total, m);
+        double start = m->finished - (double)m->total_us / 1e6;
+        if (i == 0 || start < first_start) first_start = start;
+        if (i == 0 || m->finished > last_end) last_end = m->finished;
+    }
+    summary->wall_seconds = last_end - first_start;
+
+    // 最近秩法取百分位
+    for (int f = 0; f < METRICS_TIME_FIELDS; f++) {
+        for (size_t i = 0; i < n; i++) values[i] = metricTime(&metrics_log.items[i], f);
+        qsort(values, n, sizeof(curl_off_t), compareOffT);
+        for (int p = 0; p < 3; p++) {
+            size_t rank = (n * (size_t)metrics_percentiles[p] + 99) / 100;
+            summary->percentiles[p][f] = values[rank > 0 ? rank - 1 : 0];
+        }
+    }
 
-        // 显示可用文件
-        if (arraySize > 0) {
-            printf("可用文件列表:\n");
-            for (int i = 0; i < arraySize; i++) {
-                struct json_object *asset = json_object_array_get_idx(assets, i);
-                struct json_object *name, *id;
-
-                if (json_object_object_get_ex(asset, "name", &name) &&
-                    json_object_is_type(name, json_type_string) &&
-                    json_object_object_get_ex(asset, "id", &id)) {
-                    printf("  - %s (ID: %d)\n",
-                           json_object_get_string(name),
-                           json_object_get_int(id));
-                }
-            }
-        } else {
-            printf("Release中没有文件。\n");
+    // 按文件分组，普通 API 请求（无 label）排在最前面
+    qsort(sorted, n, sizeof(*sorted), compareMetricLabel);
+    for (size_t i = 0; i < n; i++) {
+        if (summary->group_count == 0 || compareMetricLabel(&sorted[i], &sorted[i - 1]) != 0) {
+            summary->groups[summary->group_count++].label = sorted[i]->label;
         }
+        metricsAccumulate(&summary->groups[summary->group_count - 1], sorted[i]);
     }
 
-cleanup:
-    if (root) json_object_put(root);
-    if (chunk.memory) free(chunk.memory);
+    free(sorted);
+    free(values);
+    return ERR_OK;
+}
 
-    return result;
+static struct json_object* newJsonDouble(double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", value);
+    return json_object_new_double_s(value, buf);
 }
 
-// 列出所有文件
-ErrorCode listFiles(const Config *config) {
-    if (validate_config(config) != ERR_OK) {
-        return ERR_CONFIG;
+static struct json_object* metricsGroupJson(const MetricsGroup *group, double seconds) {
+    struct json_object *obj = json_object_new_object();
+    if (!obj) return NULL;
+    json_object_object_add(obj, "requests", json_object_new_int(group->requests));
+    json_object_object_add(obj, "retries", json_object_new_int(group->retries));
+    json_object_object_add(obj, "failed", json_object_new_int(group->failed));
+    json_object_object_add(obj, "bytes_up", json_object_new_int64(group->bytes_up));
+    json_object_object_add(obj, "bytes_down", json_object_new_int64(group->bytes_down));
+    json_object_object_add(obj, "mb_per_s", newJsonDouble(metricsMBps(group->bytes_up + group->bytes_down, seconds)));
+    return obj;
+}
+
+static ErrorCode writeMetricsJson(const char *path, const MetricsSummary *summary) {
+    struct json_object *root = json_object_new_object();
+    struct json_object *requests = json_object_new_array();
+    struct json_object *files = json_object_new_array();
+    struct json_object *total = metricsGroupJson(&summary->total, summary->wall_seconds);
+    struct json_object *latency = json_object_new_object();
+    if (!root || !requests || !files || !total || !latency) {
+        if (root) json_object_put(root);
+        if (requests) json_object_put(requests);
+        if (files) json_object_put(files);
+        if (total) json_object_put(total);
+        if (latency) json_object_put(latency);
+        return ERR_MEMORY;
+    }
+    json_object_object_add(root, "requests", requests);
+    json_object_object_add(root, "files", files);
+    json_object_object_add(root, "summary", total);
+
+    for (size_t i = 0; i < metrics_log.count; i++) {
+        const RequestMetric *m = &metrics_log.items[i];
+        struct json_object *row = json_object_new_object();
+        if (!row) continue;
+        json_object_object_add(row, "label", m->label ? json_object_new_string(m->label) : NULL);
+        json_object_object_add(row, "method", json_object_new_string(m->method));
+        json_object_object_add(row, "status", json_object_new_int64(m->http_status));
+        json_object_object_add(row, "curl_code", json_object_new_int(m->curl_code));
+        json_object_object_add(row, "attempt", json_object_new_int(m->attempt));
+        for (int f = 0; f < METRICS_TIME_FIELDS; f++) {
+            char key[16];
+            snprintf(key, sizeof(key), "%s_us", metrics_time_names[f]);
+            json_object_object_add(row, key, json_object_new_int64(metricTime(m, f)));
+        }
+        json_object_object_add(row, "bytes_up", json_object_new_int64(m->bytes_up));
+        json_object_object_add(row, "bytes_down", json_object_new_int64(m->bytes_down));
+        json_object_object_add(row, "mb_per_s",
+                               newJsonDouble(metricsMBps(m->bytes_up + m->bytes_down, (double)m->total_us / 1e6)));
+        json_object_array_add(requests, row);
+    }
+
+    for (size_t i = 0; i < summary->group_count; i++) {
+        const MetricsGroup *group = &summary->groups[i];
+        struct json_object *row = metricsGroupJson(group, (double)group->total_us / 1e6);
+        if (!row) continue;
+        json_object_object_add(row, "label", group->label ? json_object_new_string(group->label) : NULL);
+        json_object_object_add(row, "time_us", json_object_new_int64(group->total_us));
+        json_object_array_add(files, row);
+    }
+
+    json_object_object_add(total, "wall_time_us", json_object_new_int64((int64_t)(summary->wall_seconds * 1e6)));
+    for (int f = 0; f < METRICS_TIME_FIELDS; f++) {
+        struct json_object *pcts = json_object_new_object();
+        if (!pcts) continue;
+        for (int p = 0; p < 3; p++) {
+            char key[8];
+            snprintf(key, sizeof(key), "p%d", metrics_percentiles[p]);
+            json_object_object_add(pcts, key, json_object_new_int64(summary->percentiles[p][f]));
+        }
+        json_object_object_add(latency, metrics_time_names[f], pcts);
     }
+    json_object_object_add(total, "latency_us", latency);
 
-    struct MemoryStruct chunk = {NULL, 0};
-    struct json_object *root = NULL;
     ErrorCode result = ERR_OK;
+    if (json_object_to_file_ext(path, root, JSON_C_TO_STRING_PRETTY) != 0) {
+        fprintf(stderr, "写入指标报告失败: %s\n", path);
+        result = ERR_FILE_IO;
+    }
+    json_object_put(root);
+    return result;
+}
 
-    chunk.memory = malloc(1);
-    if (!chunk.memory) {
-        fprintf(stderr, "内存分配失败\n");
-        result = ERR_MEMORY;
-        goto cleanup;
+// CSV 字段：包含逗号、引号或换行时加引号转义
+static void csvField(FILE *fp, const char *value) {
+    if (!value) return;
+    if (!strpbrk(value, ",\"\r\n")) {
+        fputs(value, fp);
+        return;
+    }
+    fputc('"', fp);
+    for (const char *p = value; *p; p++) {
+        if (*p == '"') fputc('"', fp);
+        fputc(*p, fp);
     }
-    chunk.memory[0] = '\0';
-    chunk.size = 0;
+    fputc('"', fp);
+}
 
-    // 获取资产列表
-    if (getAssets(&chunk, config) != ERR_OK) {
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
+// 一个 CSV 文件里放三类行，用 type 列区分：request（每个请求）、file（每个文件汇总）、
+// p50/p95/p99（各阶段耗时的百分位）和 total（整批汇总，mb_per_s 为整批吞吐）
+static ErrorCode writeMetricsCsv(const char *path, const MetricsSummary *summary) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "无法写入指标报告: %s (%s)\n", path, strerror(errno));
+        return ERR_FILE_IO;
+    }
+
+    fprintf(fp, "type,label,method,status,curl_code,attempt,requests,retries,failed");
+    for (int f = 0; f < METRICS_TIME_FIELDS; f++) fprintf(fp, ",%s_us", metrics_time_names[f]);
+    fprintf(fp, ",bytes_up,bytes_down,mb_per_s\n");
+
+    for (size_t i = 0; i < metrics_log.count; i++) {
+        const RequestMetric *m = &metrics_log.items[i];
+        fputs("request,", fp);
+        csvField(fp, m->label);
+        fprintf(fp, ",%s,%ld,%d,%d,1,%d,%d", m->method, m->http_status, (int)m->curl_code, m->attempt,
+                m->attempt > 1, metricFailed(m));
+        for (int f = 0; f < METRICS_TIME_FIELDS; f++) {
+            fprintf(fp, ",%" CURL_FORMAT_CURL_OFF_T, metricTime(m, f));
+        }
+        fprintf(fp, ",%" CURL_FORMAT_CURL_OFF_T ",%" CURL_FORMAT_CURL_OFF_T ",%.3f\n", m->bytes_up, m->bytes_down,
+                metricsMBps(m->bytes_up + m->bytes_down, (double)m->total_us / 1e6));
     }
 
-    // 解析JSON
-    root = json_tokener_parse(chunk.memory);
-    if (!root) {
-        fprintf(stderr, "解析JSON失败\n");
-        result = ERR_JSON_PARSE;
-        goto cleanup;
+    for (size_t i = 0; i < summary->group_count; i++) {
+        const MetricsGroup *g = &summary->groups[i];
+        fputs("file,", fp);
+        csvField(fp, g->label);
+        fprintf(fp, ",,,,,%d,%d,%d,,,,,%" CURL_FORMAT_CURL_OFF_T, g->requests, g->retries, g->failed, g->total_us);
+        fprintf(fp, ",%" CURL_FORMAT_CURL_OFF_T ",%" CURL_FORMAT_CURL_OFF_T ",%.3f\n", g->bytes_up, g->bytes_down,
+                metricsMBps(g->bytes_up + g->bytes_down, (double)g->total_us / 1e6));
     }
 
-    struct json_object *assets;
-    if (!json_object_object_get_ex(root, "assets", &assets) ||
-        !json_object_is_type(assets, json_type_array)) {
-        fprintf(stderr, "获取资产列表失败\n");
-        result = ERR_JSON_TYPE;
-        goto cleanup;
+    for (int p = 0; p < 3; p++) {
+        fprintf(fp, "p%d,,,,,,,,", metrics_percentiles[p]);
+        for (int f = 0; f < METRICS_TIME_FIELDS; f++) {
+            fprintf(fp, ",%" CURL_FORMAT_CURL_OFF_T, summary->percentiles[p][f]);
+        }
+        fprintf(fp, ",,,\n");
     }
 
-    int arraySize = json_object_array_length(assets);
-    if (arraySize == 0) {
-        printf("Release中没有文件。\n");
+    const MetricsGroup *t = &summary->total;
+    fprintf(fp, "total,,,,,,%d,%d,%d,,,,,%lld", t->requests, t->retries, t->failed,
+            (long long)(summary->wall_seconds * 1e6));
+    fprintf(fp, ",%" CURL_FORMAT_CURL_OFF_T ",%" CURL_FORMAT_CURL_OFF_T ",%.3f\n", t->bytes_up, t->bytes_down,
+            metricsMBps(t->bytes_up + t->bytes_down, summary->wall_seconds));
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "写入指标报告失败: %s\n", path);
+        return ERR_FILE_IO;
+    }
+    return ERR_OK;
+}
+
+// 按扩展名选择格式：.csv 写 CSV，其余写 JSON
+static ErrorCode writeMetricsReport(const char *path) {
+    MetricsSummary summary;
+    ErrorCode result = summarizeMetrics(&summary);
+    if (result != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return result;
+    }
+
+    const char *ext = strrchr(path, '.');
+    if (ext && strcasecmp(ext, ".csv") == 0) {
+        result = writeMetricsCsv(path, &summary);
     } else {
-        printf("Release中的文件列表:\n");
-        printf("%-40s %15s %15s\n", "文件名", "大小(bytes)", "下载次数");
-        printf("--------------------------------------------------------------------------\n");
+        result = writeMetricsJson(path, &summary);
+    }
 
-        for (int i = 0; i < arraySize; i++) {
-            struct json_object *asset = json_object_array_get_idx(assets, i);
-            struct json_object *name_obj, *size_obj, *download_count_obj;
+    if (result == ERR_OK) {
+        log_info("指标报告已写入 %s（%zu 个请求，%.3f MB/s）", path, metrics_log.count,
+                 metricsMBps(summary.total.bytes_up + summary.total.bytes_down, summary.wall_seconds));
+    }
+    free(summary.groups);
+    return result;
+}
 
-            if (json_object_object_get_ex(asset, "name", &name_obj) &&
-                json_object_is_type(name_obj, json_type_string)) {
+// ==================== API 速率限制 ====================
 
-                const char *name = json_object_get_string(name_obj);
-                int size = 0, download_count = 0;
+// 根据每个响应的 X-RateLimit-Remaining / X-RateLimit-Reset / Retry-After 调整请求节奏：
+// 配额充足时不限速；剩余配额不多时用令牌桶把剩余请求均匀分布到重置前的时间窗口内；
+// 触发限流（Retry-After、配额耗尽、429）时暂停到允许的时间点
+typedef struct {
+    pthread_mutex_t lock;
+    long remaining;          // 最近一次响应报告的剩余配额，-1 表示未知
+    long long reset_epoch;   // 配额重置时间（Unix 时间戳），0 表示未知
+    double rate;             // 令牌补充速度（个/秒），0 表示不限速
+    double tokens;
+    double last_refill;      // 上次补充令牌的时间（单调时钟）
+    double blocked_until;    // 在此之前不发出任何请求（单调时钟）
+    int warned;              // 是否已经提示过正在限速
+} RateLimiter;
+
+static RateLimiter rate_limiter = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .remaining = -1,
+};
 
-                if (json_object_object_get_ex(asset, "size", &size_obj)) {
-                    size = json_object_get_int(size_obj);
-                }
+// 根据当前配额重新计算令牌速度（需持有锁）
+static void rateLimitRecompute(double now) {
+    RateLimiter *rl = &rate_limiter;
+    if (rl->remaining < 0 || rl->reset_epoch <= 0) {
+        return;
+    }
 
-                if (json_object_object_get_ex(asset, "download_count", &download_count_obj)) {
-                    download_count = json_object_get_int(download_count_obj);
-                }
+    long long window = rl->reset_epoch - (long long)time(NULL);
+    if (window < 1) window = 1;
 
-                printf("%-40s %15d %15d\n", name, size, download_count);
-            }
-        }
+    if (rl->remaining == 0) {
+        // 配额耗尽：等到重置时间（多留 1 秒余量）
+        double until = now + (double)window + 1;
+        if (until > rl->blocked_until) rl->blocked_until = until;
+        rl->rate = 0;
+        return;
     }
 
-cleanup:
-    if (root) json_object_put(root);
-    if (chunk.memory) free(chunk.memory);
+    if (rl->remaining > RATE_LIMIT_PACE_BELOW) {
+        rl->rate = 0;
+        rl->warned = 0;
+        return;
+    }
 
-    return result;
+    // 把剩余配额均匀分配到重置前的时间里
+    double rate = (double)rl->remaining / (double)window;
+    if (rl->rate == 0) {
+        rl->tokens = RATE_LIMIT_BURST;
+        rl->last_refill = now;
+    }
+    rl->rate = rate;
+    if (rl->tokens > rl->remaining) rl->tokens = (double)rl->remaining;
+    if (!rl->warned) {
+        log_warn("API 剩余配额 %ld，限速为每秒 %.2f 个请求（%lld 秒后重置）", rl->remaining, rate, window);
+        rl->warned = 1;
+    }
 }
 
-void showUsage() {
-    printf("用法:\n");
-    printf("  ./manage upload <文件路径> [文件路径2] [文件路径3 ...]\n");
-    printf("  ./manage delete <文件名> [文件名2] [文件名3 ...]\n");
-    printf("  ./manage list\n");
-    printf("  ./manage update <文件路径> [文件路径2] [文件路径3 ...]\n");
-    printf("  ./manage create-release <tag_name> [选项] [文件...]\n");
-    printf("  ./manage help         # 显示详细说明\n");
-    printf("\n批量操作（支持通配符）:\n");
-    printf("  ./manage upload *.zip\n");
-    printf("  ./manage update *.zip\n");
-    printf("  ./manage delete *.tmp\n");
-    printf("  ./manage upload file1.zip file2.zip file3.zip\n");
-    printf("\n环境变量:\n");
-    printf("  GITHUB_TOKEN: GitHub API 令牌（必需）\n");
-    printf("  GITHUB_OWNER: GitHub 仓库所有者（默认: nostalgia296）\n");
-    printf("  GITHUB_REPO:  GitHub 仓库名（默认: backup）\n");
-    printf("  GITHUB_TAG:   指定要操作的Release Tag（可选，未指定时使用最新的Release）\n");
+// 从响应头中读取速率限制信息，所有请求的 header 回调都会调用
+static void rateLimitObserveHeader(const char *buffer, size_t len) {
+    static const struct {
+        const char *name;
+        size_t len;
+    } keys[] = {
+        {"x-ratelimit-remaining:", 22},
+        {"x-ratelimit-reset:", 18},
+        {"retry-after:", 12},
+    };
+    size_t key = 0;
+    while (key < sizeof(keys) / sizeof(keys[0]) &&
+           !(len > keys[key].len && strncasecmp(buffer, keys[key].name, keys[key].len) == 0)) {
+        key++;
+    }
+    if (key == sizeof(keys) / sizeof(keys[0])) {
+        return;
+    }
+
+    char value[32];
+    size_t n = len - keys[key].len;
+    if (n >= sizeof(value)) n = sizeof(value) - 1;
+    memcpy(value, buffer + keys[key].len, n);
+    value[n] = '\0';
+
+    char *end = NULL;
+    long long number = strtoll(value, &end, 10);
+    if (end == value || number < 0) {
+        return;    // Retry-After 也可能是 HTTP 日期格式，GitHub 只使用秒数
+    }
+
+    double now = monotonicSeconds();
+    pthread_mutex_lock(&rate_limiter.lock);
+    if (key == 0) {
+        rate_limiter.remaining = (long)number;
+        rateLimitRecompute(now);
+    } else if (key == 1) {
+        rate_limiter.reset_epoch = number;
+        rateLimitRecompute(now);
+    } else {
+        double until = now + (double)number;
+        if (until > rate_limiter.blocked_until) rate_limiter.blocked_until = until;
+    }
+    pthread_mutex_unlock(&rate_limiter.lock);
 }
 
-void showDetailedUsage() {
-    printf("GitHub Release 管理工具 - 详细说明\n");
-    printf("=====================================\n\n");
+static size_t RateLimitHeaderCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    (void)userp;
+    rateLimitObserveHeader(buffer, size * nitems);
+    return size * nitems;
+}
 
-    printf("快速开始:\n");
-    printf("  export GITHUB_TOKEN=your_token_here\n");
-    printf("  ./manage list                      # 查看当前 Release 中的文件\n");
-    printf("  ./manage upload myfile.zip        # 上传文件\n");
-    printf("  ./manage update myfile.zip        # 更新文件\n");
-    printf("  ./manage create-release v1.0      # 创建新 Release\n\n");
+// 触发二级速率限制：响应头没有给出 Retry-After 时按 GitHub 文档至少等待一分钟
+static void rateLimitBlockSecondary(void) {
+    double now = monotonicSeconds();
+    pthread_mutex_lock(&rate_limiter.lock);
+    if (rate_limiter.blocked_until < now + 1) {
+        rate_limiter.blocked_until = now + RATE_LIMIT_SECONDARY_WAIT;
+    }
+    pthread_mutex_unlock(&rate_limiter.lock);
+}
 
-    printf("命令用法:\n");
-    printf("-----------\n\n");
+// 请求结束后检查状态码：429 一定是速率限制
+static void rateLimitObserveStatus(long response_code) {
+    if (response_code == 429) {
+        rateLimitBlockSecondary();
+    }
+}
 
-    printf("上传文件 (upload):\n");
-    printf("  ./manage upload <文件路径> [文件2] [文件3] ...\n");
-    printf("  示例:\n");
-    printf("    ./manage upload backup.zip\n");
-    printf("    ./manage upload *.zip\n");
-    printf("    ./manage upload file1.zip file2.zip file3.zip\n\n");
+// GitHub 的二级速率限制也可能返回 403，并且不带 Retry-After、剩余配额也不为 0，
+// 只能从响应内容判断；这种 403 和 429 一样等待后重试
+static void rateLimitObserveBody(long response_code, const char *body) {
+    if ((response_code != 403 && response_code != 429) || !body) {
+        return;
+    }
 
-    printf("删除文件 (delete):\n");
-    printf("  ./manage delete <文件名> [文件2] [文件3] ...\n");
-    printf("  示例:\n");
-    printf("    ./manage delete oldfile.zip\n");
-    printf("    ./manage delete *.tmp\n");
-    printf("    ./manage delete file1.tmp file2.tmp\n\n");
+    char lower[512];
+    size_t n = 0;
+    for (; body[n] && n < sizeof(lower) - 1; n++) {
+        lower[n] = (char)tolower((unsigned char)body[n]);
+    }
+    lower[n] = '\0';
+    if (strstr(lower, "rate limit")) {
+        rateLimitBlockSecondary();
+    }
+}
 
-    printf("列出文件 (list):\n");
-    printf("  ./manage list\n");
-    printf("  显示 Release 中的所有文件，包括大小和下载次数\n\n");
+// 距离下一个请求可以发出还需等待的秒数（需持有锁）
+static double rateLimitDelayLocked(double now) {
+    RateLimiter *rl = &rate_limiter;
+    double delay = rl->blocked_until > now ? rl->blocked_until - now : 0;
+
+    if (rl->rate > 0) {
+        rl->tokens += (now - rl->last_refill) * rl->rate;
+        if (rl->tokens > RATE_LIMIT_BURST) rl->tokens = RATE_LIMIT_BURST;
+        rl->last_refill = now;
+        if (rl->tokens < 1) {
+            double wait = (1 - rl->tokens) / rl->rate;
+            if (wait > delay) delay = wait;
+        }
+    }
+    return delay;
+}
 
-    printf("更新文件 (update):\n");
-    printf("  ./manage update <文件路径> [文件2] [文件3] ...\n");
-    printf("  先删除旧文件，再上传新文件（用于替换已存在文件）\n");
-    printf("  示例:\n");
-    printf("    ./manage update newbackup.zip\n");
-    printf("    ./manage update *.zip\n\n");
+// 不阻塞地查询需要等待的时间，供 curl_multi 事件循环安排任务
+static double rateLimitDelay(void) {
+    pthread_mutex_lock(&rate_limiter.lock);
+    double delay = rateLimitDelayLocked(monotonicSeconds());
+    pthread_mutex_unlock(&rate_limiter.lock);
+    return delay;
+}
 
-    printf("创建 Release (create-release):\n");
-    printf("  ./manage create-release <tag_name> [选项] [文件...]\n");
-    printf("  选项:\n");
-    printf("    -n, --name <name>        Release 名称（默认使用 tag_name）\n");
-    printf("    -d, --description <desc> Release 描述\n");
-    printf("    -p, --prerelease         标记为预发布版本\n");
-    printf("    [文件...]                创建 release 后要上传的文件（支持通配符）\n");
-    printf("  示例:\n");
-    printf("    ./manage create-release v1.0                           # 创建普通 release\n");
-    printf("    ./manage create-release v1.0 -n \"Version 1.0\"          # 创建指定名称的 release\n");
-    printf("    ./manage create-release v1.0 -d \"First stable release\" # 创建带描述的 release\n");
-    printf("    ./manage create-release v1.0-beta -p                   # 创建预发布版本\n");
-    printf("    ./manage create-release v1.0 *.zip                     # 创建 release 并上传所有 zip 文件\n");
-    printf("    ./manage create-release v1.0 file1.zip file2.zip       # 创建 release 并上传指定文件\n\n");
+// 等到允许发出请求，并消耗一个令牌
+static void rateLimitAcquire(void) {
+    for (;;) {
+        pthread_mutex_lock(&rate_limiter.lock);
+        double delay = rateLimitDelayLocked(monotonicSeconds());
+        if (delay <= 0) {
+            if (rate_limiter.rate > 0) rate_limiter.tokens -= 1;
+            pthread_mutex_unlock(&rate_limiter.lock);
+            return;
+        }
+        pthread_mutex_unlock(&rate_limiter.lock);
 
-    printf("环境变量配置:\n");
-    printf("-------------\n\n");
+        if (delay >= 1) {
+            log_warn("触发 GitHub API 速率限制，等待 %.0f 秒...", delay);
+        }
+        usleep((useconds_t)(delay * 1e6));
+    }
+}
 
-    printf("必须在运行前设置 GITHUB_TOKEN:\n");
-    printf("  export GITHUB_TOKEN=\"ghp_your_personal_access_token\"\n\n");
+// ==================== Release 元数据缓存 ====================
+
+// Release 中的单个资产
+struct ReleaseAsset {
+    long long id;
+    char *name;
+    char *label;
+    char *state;
+    char *digest;                // GitHub 提供的内容摘要，如 "sha256:..."（可能为空）
+    long long size;
+    long long download_count;
+    ReleaseAsset *bucket_next;   // 同一哈希桶中的下一个资产
+    ReleaseAsset *prev;          // 按 API 返回顺序排列的双向链表
+    ReleaseAsset *next;
+};
 
-    printf("可选环境变量:\n");
-    printf("  GITHUB_OWNER:  GitHub 用户名或组织名（默认: nostalgia296）\n");
-    printf("  GITHUB_REPO:   仓库名称（默认: backup）\n");
-    printf("  GITHUB_TAG:    指定要操作的 Release Tag（未指定时使用最新 Release）\n");
-    printf("  示例:\n");
-    printf("    export GITHUB_OWNER=\"myusername\"\n");
-    printf("    export GITHUB_REPO=\"my-backup\"\n");
-    printf("    export GITHUB_TAG=\"v1.0\"\n\n");
+// 每次命令只请求一次 Release 信息，之后由上传/删除响应就地更新
+struct ReleaseCache {
+    int loaded;
+    char *release_id;            // 缓存对应的 release id
+    char *tag_name;              // Release 的 tag，可能为 NULL
+    char *upload_url_template;
+    int upload_url_rebased;      // 模板已按 MANAGE_UPLOAD_URL 改写
+    ReleaseAsset **buckets;      // 资产名 → 资产 的哈希索引
+    size_t bucket_count;
+    size_t asset_count;
+    ReleaseAsset *head;
+    ReleaseAsset *tail;
+};
 
-    printf("获取 GitHub Token:\n");
-    printf("  1. 访问 https://github.com/settings/tokens\n");
-    printf("  2. 点击 \"Generate new token\" → \"Generate new token (classic)\"\n");
-    printf("  3. 选择 'repo' 作用域以访问私有仓库\n");
-    printf("  4. 生成并复制 token\n");
-    printf("  5. 在运行程序前设置环境变量\n\n");
+#define RELEASE_CACHE_MIN_BUCKETS 64
 
-    printf("注意事项:\n");
-    printf("-----------\n");
-    printf("  - 上传文件需要在 GitHub Release 中至少有一个 Release\n");
-    printf("  - 操作可能需要几秒到几十秒，取决于文件大小和网络状况\n");
-    printf("  - API 调用有速率限制，批量操作会自动添加延迟\n");
-    printf("  - 如果上传失败，请检查文件大小是否超过 GitHub 限制\n");
+// FNV-1a 字符串哈希
+static size_t hashAssetName(const char *name) {
+    size_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "错误：请提供命令和参数。\n");
-        showUsage();
-        return 1;
+static void freeReleaseAsset(ReleaseAsset *asset) {
+    if (!asset) return;
+    free(asset->name);
+    free(asset->label);
+    free(asset->state);
+    free(asset->digest);
+    free(asset);
+}
+
+// 清空缓存内容（缓存对象本身可以继续使用）
+static void releaseCacheClear(ReleaseCache *cache) {
+    if (!cache) return;
+
+    ReleaseAsset *asset = cache->head;
+    while (asset) {
+        ReleaseAsset *next = asset->next;
+        freeReleaseAsset(asset);
+        asset = next;
     }
 
-    Config config = {0};
-    // 显式初始化标记位
-    config.owner_allocated = 0;
-    config.repo_allocated = 0;
-    config.token_allocated = 0;
+    free(cache->buckets);
+    free(cache->release_id);
+    free(cache->tag_name);
+    free(cache->upload_url_template);
+    memset(cache, 0, sizeof(*cache));
+}
 
-    if (getConfig(&config) != ERR_OK) {
-        return 1;
+// 扩容哈希桶，保持负载因子不超过 1
+static ErrorCode releaseCacheGrow(ReleaseCache *cache) {
+    size_t new_count = cache->bucket_count ? cache->bucket_count * 2 : RELEASE_CACHE_MIN_BUCKETS;
+    ReleaseAsset **new_buckets = calloc(new_count, sizeof(ReleaseAsset *));
+    if (!new_buckets) {
+        return ERR_MEMORY;
     }
 
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+    for (ReleaseAsset *asset = cache->head; asset; asset = asset->next) {
+        size_t idx = hashAssetName(asset->name) & (new_count - 1);
+        asset->bucket_next = new_buckets[idx];
+        new_buckets[idx] = asset;
+    }
 
-    // 初始化随机数生成器（用于重试机制的随机抖动）
-    srand(time(NULL));
+    free(cache->buckets);
+    cache->buckets = new_buckets;
+    cache->bucket_count = new_count;
+    return ERR_OK;
+}
 
-    const char *command = argv[1];
-    ErrorCode result = ERR_OK;
+// 按名称查找资产，O(1)
+static ReleaseAsset* releaseCacheFind(const ReleaseCache *cache, const char *name) {
+    if (!cache || !cache->buckets || !name) return NULL;
 
-    // 处理不需要获取 release_id 的命令
-    if (strcmp(command, "help") == 0) {
-        showDetailedUsage();
-        goto cleanup;
+    size_t idx = hashAssetName(name) & (cache->bucket_count - 1);
+    for (ReleaseAsset *asset = cache->buckets[idx]; asset; asset = asset->bucket_next) {
+        if (strcmp(asset->name, name) == 0) {
+            return asset;
+        }
     }
+    return NULL;
+}
 
-    // 某些命令不需要预先获取 release_id
-    if (strcmp(command, "create-release") != 0) {
-        // 获取最新的release id（动态分配）- 只调用一次
-        if (getLatestReleaseId(&config) != ERR_OK) {
-            result = ERR_CONFIG;
-            goto cleanup;
+// 从缓存中移除指定名称的资产
+static void releaseCacheRemove(ReleaseCache *cache, const char *name) {
+    if (!cache || !cache->buckets || !name) return;
+
+    size_t idx = hashAssetName(name) & (cache->bucket_count - 1);
+    ReleaseAsset **link = &cache->buckets[idx];
+    while (*link) {
+        ReleaseAsset *asset = *link;
+        if (strcmp(asset->name, name) == 0) {
+            *link = asset->bucket_next;
+            if (asset->prev) asset->prev->next = asset->next;
+            else cache->head = asset->next;
+            if (asset->next) asset->next->prev = asset->prev;
+            else cache->tail = asset->prev;
+            cache->asset_count--;
+            freeReleaseAsset(asset);
+            return;
         }
+        link = &asset->bucket_next;
     }
+}
 
-    if (strcmp(command, "upload") == 0) {
-        if (argc < 3) {
-            fprintf(stderr, "错误：请提供文件路径。\n");
-            showUsage();
-            return 1;
-        }
+// 读取 JSON 字符串字段的副本，字段缺失时返回空字符串
+static char* dupJsonString(struct json_object *obj, const char *key) {
+    struct json_object *value;
+    if (json_object_object_get_ex(obj, key, &value) &&
+        json_object_is_type(value, json_type_string)) {
+        return strdup(json_object_get_string(value));
+    }
+    return strdup("");
+}
 
-        // 处理批量上传
-        int totalFiles = 0;
-        char **allFiles = NULL;
+static long long getJsonInt64(struct json_object *obj, const char *key) {
+    struct json_object *value;
+    if (json_object_object_get_ex(obj, key, &value)) {
+        return (long long)json_object_get_int64(value);
+    }
+    return 0;
+}
 
-        for (int i = 2; i < argc; i++) {
-            char **matchedFiles = NULL;
-            int fileCount = expandWildcards(argv[i], &matchedFiles);
+// 用 API 返回的资产对象（上传响应或 assets[] 元素）更新缓存
+static ErrorCode releaseCacheAddAsset(ReleaseCache *cache, struct json_object *asset_obj) {
+    struct json_object *name_obj;
+    if (!cache || !json_object_object_get_ex(asset_obj, "name", &name_obj) ||
+        !json_object_is_type(name_obj, json_type_string)) {
+        return ERR_JSON_TYPE;
+    }
 
-            if (fileCount > 0) {
-                char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
-                if (!newAllFiles) {
-                    fprintf(stderr, "内存分配失败\n");
-                    result = ERR_MEMORY;
-                    // 释放已分配的文件名
-                    if (allFiles) {
-                        for (int j = 0; j < totalFiles; j++) {
-                            free(allFiles[j]);
-                        }
-                        free(allFiles);
-                    }
-                    for (int j = 0; j < fileCount; j++) {
-                        free(matchedFiles[j]);
-                    }
-                    free(matchedFiles);
-                    goto cleanup;
-                }
-                allFiles = newAllFiles;
+    const char *name = json_object_get_string(name_obj);
 
-                for (int j = 0; j < fileCount; j++) {
-                    allFiles[totalFiles++] = matchedFiles[j];
-                }
-                free(matchedFiles);
-            }
-        }
+    // 同名资产以最新响应为准
+    releaseCacheRemove(cache, name);
 
-        if (totalFiles == 0) {
-            fprintf(stderr, "错误：找不到匹配的文件\n");
-            result = ERR_FILE_IO;
-        } else {
-            result = uploadMultipleFiles(totalFiles, allFiles, &config);
+    if (cache->asset_count + 1 > cache->bucket_count) {
+        if (releaseCacheGrow(cache) != ERR_OK) {
+            return ERR_MEMORY;
         }
+    }
 
-        // 清理文件列表
+    ReleaseAsset *asset = calloc(1, sizeof(ReleaseAsset));
+    if (!asset) {
+        return ERR_MEMORY;
+    }
+
+    asset->id = getJsonInt64(asset_obj, "id");
+    asset->size = getJsonInt64(asset_obj, "size");
+    asset->download_count = getJsonInt64(asset_obj, "download_count");
+    asset->name = strdup(name);
+    asset->label = dupJsonString(asset_obj, "label");
+    asset->state = dupJsonString(asset_obj, "state");
+    asset->digest = dupJsonString(asset_obj, "digest");
+    if (!asset->name || !asset->label || !asset->state || !asset->digest) {
+        freeReleaseAsset(asset);
+        return ERR_MEMORY;
+    }
+
+    size_t idx = hashAssetName(asset->name) & (cache->bucket_count - 1);
+    asset->bucket_next = cache->buckets[idx];
+    cache->buckets[idx] = asset;
+
+    asset->prev = cache->tail;
+    if (cache->tail) cache->tail->next = asset;
+    else cache->head = asset;
+    cache->tail = asset;
+    cache->asset_count++;
+
+    return ERR_OK;
+}
+
+// 用 Release 对象（GET /releases/{id} 或创建 Release 的响应）填充缓存
+static ErrorCode releaseCacheLoadJson(ReleaseCache *cache, const char *release_id,
+                                      struct json_object *release) {
+    releaseCacheClear(cache);
+
+    struct json_object *upload_url_item;
+    if (!json_object_object_get_ex(release, "upload_url", &upload_url_item) ||
+        !json_object_is_type(upload_url_item, json_type_string)) {
+        fprintf(stderr, "获取upload_url失败\n");
+        return ERR_JSON_TYPE;
+    }
+
+    cache->release_id = strdup(release_id);
+    cache->upload_url_template = strdup(json_object_get_string(upload_url_item));
+    if (!cache->release_id || !cache->upload_url_template || releaseCacheGrow(cache) != ERR_OK) {
+        releaseCacheClear(cache);
+        return ERR_MEMORY;
+    }
+
+    struct json_object *tag_item;
+    if (json_object_object_get_ex(release, "tag_name", &tag_item) &&
+        json_object_is_type(tag_item, json_type_string)) {
+        cache->tag_name = strdup(json_object_get_string(tag_item));
+    }
+
+    struct json_object *assets;
+    if (json_object_object_get_ex(release, "assets", &assets) &&
+        json_object_is_type(assets, json_type_array)) {
+        int arraySize = json_object_array_length(assets);
+        for (int i = 0; i < arraySize; i++) {
+            ErrorCode ret = releaseCacheAddAsset(cache, json_object_array_get_idx(assets, i));
+            if (ret == ERR_MEMORY) {
+                releaseCacheClear(cache);
+                return ERR_MEMORY;
+            }
+        }
+    }
+
+    cache->loaded = 1;
+    log_debug("已缓存 Release %s 的元数据（%zu 个资产）", release_id, cache->asset_count);
+    return ERR_OK;
+}
+
+// 确保缓存已加载当前 release 的元数据，整个命令只请求一次
+static ErrorCode ensureReleaseCache(const Config *config, ReleaseCache **out_cache) {
+    ReleaseCache *cache = config->release_cache;
+    *out_cache = NULL;
+
+    if (!cache) {
+        fprintf(stderr, "错误：未初始化 Release 缓存\n");
+        return ERR_CONFIG;
+    }
+
+    if (cache->loaded && strcmp(cache->release_id, config->release_id) == 0) {
+        *out_cache = cache;
+        return ERR_OK;
+    }
+
+    struct json_object *root = NULL;
+    long response_code = 0;
+    ErrorCode result = ERR_OK;
+
+    char *url = create_url(commandArena(config), "%s/repos/%s/%s/releases/%s",
+                           config->api_base, config->owner, config->repo, config->release_id);
+    if (!url) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    // 响应在接收过程中增量解析
+    result = githubGetJson(config, url, &root, &response_code, NULL);
+    if (result != ERR_OK) {
+        fprintf(stderr, "获取Release信息失败\n");
+        return result;
+    }
+
+    result = releaseCacheLoadJson(cache, config->release_id, root);
+    if (result == ERR_OK) {
+        *out_cache = cache;
+    }
+
+    json_object_put(root);
+    return result;
+}
+
+// 删除指定的资产
+ErrorCode deleteAsset(const char *assetId, const char *assetName, const Config *config) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    if (!assetId || !assetName) {
+        fprintf(stderr, "错误：assetId 和 assetName 不能为空\n");
+        return ERR_CONFIG;
+    }
+
+    CURL *curl = NULL;
+    struct curl_slist *headers = NULL;
+    ErrorCode result = ERR_OK;
+    char *url = NULL;
+
+    url = create_url(commandArena(config), "%s/repos/%s/%s/releases/assets/%s",
+                     config->api_base, config->owner, config->repo, assetId);
+    if (!url) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    curl = acquireCurlHandle();
+    if (!curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    headers = setGithubHeaders(commandArena(config), config->token, NULL);
+    ResponseBuffer *response = scratchResponse(config);
+    if (!response) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)response);
+
+    CURLcode res = performRequest(curl);
+    if (res != CURLE_OK) {
+        fprintf(stderr, "删除资产失败: %s\n", curl_easy_strerror(res));
+        result = ERR_CURL_PERFORM;
+        goto cleanup;
+    }
+
+    // 检查HTTP响应码
+    long response_code;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        fprintf(stderr, "删除资产失败，HTTP错误: %ld\n", response_code);
+        rateLimitObserveBody(response_code, response->data);
+        result = ERR_HTTP_ERROR;
+        goto cleanup;
+    }
+
+    printf("\n✅ 文件 \"%s\" 删除成功!\n", assetName);
+    result = ERR_OK;
+
+cleanup:
+    if (headers) curl_slist_free_all(headers);
+    if (curl) releaseCurlHandle(curl);
+
+    return result;
+}
+
+// 获取Release的上传URL模板（upload_url 字段），由 Release 缓存持有
+static ErrorCode getUploadUrlTemplate(const Config *config, const char **out_template) {
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+
+    // 配置了上传地址时，只在第一次取用时改写缓存中的模板
+    if (result == ERR_OK && config->upload_base && !cache->upload_url_rebased) {
+        char *rebased = rebaseUrl(config->upload_base, cache->upload_url_template);
+        if (!rebased) {
+            fprintf(stderr, "内存分配失败\n");
+            *out_template = NULL;
+            return ERR_MEMORY;
+        }
+        free(cache->upload_url_template);
+        cache->upload_url_template = rebased;
+        cache->upload_url_rebased = 1;
+    }
+
+    *out_template = (result == ERR_OK) ? cache->upload_url_template : NULL;
+    return result;
+}
+
+// 根据上传URL模板和文件名构建上传URL（从 arena 分配）。文件名需要转义，
+// 否则空格、&、# 等字符会让 URL 无效或截断资产名
+static char* buildUploadUrl(Arena *arena, const char *uploadUrlTemplate, const char *fileName) {
+    char *escaped = curl_easy_escape(NULL, fileName, 0);
+    if (!escaped) {
+        return NULL;
+    }
+
+    char *url;
+    const char *template_end = strstr(uploadUrlTemplate, "{?name,label}");
+    if (template_end) {
+        url = create_url(arena, "%.*s?name=%s", (int)(template_end - uploadUrlTemplate),
+                         uploadUrlTemplate, escaped);
+    } else {
+        url = create_url(arena, "%s?name=%s", uploadUrlTemplate, escaped);
+    }
+    curl_free(escaped);
+    return url;
+}
+
+// 为上传请求设置 curl 选项，请求体从 source 流式读取
+static void setUploadOptions(CURL *curl, const char *uploadUrl, struct curl_slist *headers,
+                             UploadSource *source, ResponseBuffer *response) {
+    source->position = 0;
+
+    curl_easy_setopt(curl, CURLOPT_URL, uploadUrl);
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, UploadReadCallback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, (void *)source);
+    curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, UploadSeekCallback);
+    curl_easy_setopt(curl, CURLOPT_SEEKDATA, (void *)source);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, source->size);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, UPLOAD_BUFFER_SIZE);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)response);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+}
+
+// 上传文件
+ErrorCode uploadFile(const char *filePath, const Config *config) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    if (!filePath) {
+        fprintf(stderr, "错误：文件路径不能为空\n");
+        return ERR_CONFIG;
+    }
+
+    CURL *curl = NULL;
+    ResponseBuffer *response = NULL;
+    struct curl_slist *headers = NULL;
+    struct json_object *uploadResponse = NULL;
+    UploadSource source = {-1, 0, 0, NULL, NULL, NULL, 0, 0, 0, 0, 0};
+    TransferProgress progress = {0};
+    const char *uploadUrlTemplate = NULL;
+    char *uploadUrl = NULL;
+    ErrorCode result = ERR_OK;
+
+    // 首先获取Release的上传地址（整个命令只请求一次）
+    // 失败时保留原来的错误码，认证失败、Release 不存在等不会被当作网络故障重试
+    result = getUploadUrlTemplate(config, &uploadUrlTemplate);
+    if (result != ERR_OK) {
+        goto cleanup;
+    }
+
+    const char *fileName = uploadAssetName(config, getFilenameFromPath(filePath));
+
+    // 动态构建上传URL，避免缓冲区溢出
+    uploadUrl = buildUploadUrl(commandArena(config), uploadUrlTemplate, fileName);
+    if (!uploadUrl) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    // 打开文件（内容在上传时流式读取，启用压缩时先压缩到内存）
+    result = openUploadSource(&source, filePath, config->compression);
+    if (result != ERR_OK) {
+        goto cleanup;
+    }
+    attachUploadHasher(config, &source);
+
+    printf("准备上传文件 \"%s\" (%" CURL_FORMAT_CURL_OFF_T " bytes)...\n", fileName, source.size);
+    printf("上传到: %s\n", uploadUrl);
+
+    // 准备上传
+    curl = acquireCurlHandle();
+    if (!curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        result = ERR_CURL_INIT;
+        goto cleanup;
+    }
+
+    headers = setGithubHeaders(commandArena(config), config->token, "application/octet-stream");
+    if (!headers) {
+        fprintf(stderr, "添加header失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    response = scratchResponse(config);
+    if (!response) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    setUploadOptions(curl, uploadUrl, headers, &source, response);
+    // 逐个上传时同一时刻只有这一个传输，直接交给 curl 限速
+    if (config->limit_rate > 0) {
+        curl_easy_setopt(curl, CURLOPT_MAX_SEND_SPEED_LARGE, config->limit_rate);
+    }
+    progressBegin(config, 1);
+    progressPlan(&progress, source.size);
+    progressAttach(curl, &progress, fileName, source.size);
+
+    CURLcode res = performRequest(curl);
+    progressFileDone(&progress, res == CURLE_OK);
+    progressEnd();
+    if (res != CURLE_OK) {
+        fprintf(stderr, "上传文件失败: %s\n", curl_easy_strerror(res));
+        result = ERR_CURL_PERFORM;
+        goto cleanup;
+    }
+
+    // 检查HTTP响应码
+    long response_code;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        fprintf(stderr, "上传文件失败，HTTP错误: %ld\n", response_code);
+        rateLimitObserveBody(response_code, response->data);
+        result = ERR_HTTP_ERROR;
+        goto cleanup;
+    }
+
+    // 解析上传响应
+    if (recordUploadChecksum(config, &source, filePath, fileName) != ERR_OK) {
+        log_warn("无法记录 %s 的校验和", fileName);
+    }
+
+    uploadResponse = json_tokener_parse(response->data);
+    if (uploadResponse) {
+        printf("\n✅ 文件上传成功!\n");
+
+        // 用上传响应更新缓存，后续操作无需重新获取资产列表
+        releaseCacheAddAsset(config->release_cache, uploadResponse);
+        uploadJournalComplete(config->journal, fileName, getJsonInt64(uploadResponse, "id"));
+
+        struct json_object *id;
+        if (json_object_object_get_ex(uploadResponse, "id", &id)) {
+            printf("   - Asset ID: %d\n", json_object_get_int(id));
+        }
+
+        struct json_object *url;
+        if (json_object_object_get_ex(uploadResponse, "browser_download_url", &url) &&
+            json_object_is_type(url, json_type_string)) {
+            printf("   - 下载链接: %s\n", json_object_get_string(url));
+        }
+    } else {
+        printf("上传成功，但无法解析响应\n");
+    }
+
+cleanup:
+    if (uploadResponse) json_object_put(uploadResponse);
+    closeUploadSource(&source);
+    if (headers) curl_slist_free_all(headers);
+    if (curl) releaseCurlHandle(curl);
+
+    return result;
+}
+
+// 删除文件
+ErrorCode deleteFile(const char *fileName, const Config *config) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    if (!fileName) {
+        fprintf(stderr, "错误：文件名不能为空\n");
+        return ERR_CONFIG;
+    }
+
+    // 检查文件名是否包含非法字符
+    if (strchr(fileName, '/') || strchr(fileName, '\\')) {
+        fprintf(stderr, "错误：文件名不能包含路径分隔符\n");
+        return ERR_INVALID_PATH;
+    }
+
+    // 从缓存的资产索引中查找，不再为每个文件重新获取列表
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    ReleaseAsset *asset = releaseCacheFind(cache, fileName);
+    if (!asset) {
+        fprintf(stderr, "错误：在Release中未找到名为 \"%s\" 的文件。\n", fileName);
+
+        // 显示可用文件
+        if (cache->asset_count > 0) {
+            printf("可用文件列表:\n");
+            for (ReleaseAsset *a = cache->head; a; a = a->next) {
+                printf("  - %s (ID: %lld)\n", a->name, a->id);
+            }
+        } else {
+            printf("Release中没有文件。\n");
+        }
+        return ERR_NOT_FOUND;
+    }
+
+    printf("找到文件 \"%s\" (ID: %lld)，正在删除...\n", fileName, asset->id);
+
+    char id_str[32];
+    snprintf(id_str, sizeof(id_str), "%lld", asset->id);
+
+    result = deleteAsset(id_str, fileName, config);
+    if (result == ERR_OK) {
+        releaseCacheRemove(cache, fileName);
+    }
+
+    return result;
+}
+
+// 列出所有文件
+ErrorCode listFiles(const Config *config) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return (result == ERR_MEMORY) ? ERR_MEMORY : ERR_CURL_PERFORM;
+    }
+
+    if (cache->asset_count == 0) {
+        printf("Release中没有文件。\n");
+    } else {
+        printf("Release中的文件列表:\n");
+        printf("%-40s %15s %15s\n", "文件名", "大小(bytes)", "下载次数");
+        printf("--------------------------------------------------------------------------\n");
+
+        for (ReleaseAsset *asset = cache->head; asset; asset = asset->next) {
+            printf("%-40s %15lld %15lld\n", asset->name, asset->size, asset->download_count);
+        }
+    }
+
+    return ERR_OK;
+}
+
+void showUsage() {
+    printf("用法:\n");
+    printf("  ./manage upload <文件路径> [文件路径2] [文件路径3 ...]\n");
+    printf("  ./manage delete [--match 通配符] [--regex 正则] [--dry-run] [文件名 ...]\n");
+    printf("  ./manage list [--format table|ndjson|json|csv] [--all-releases]\n");
+    printf("  ./manage update <文件路径> [文件路径2] [文件路径3 ...]\n");
+    printf("  ./manage sync [--delete] [--dry-run] <文件路径> [文件路径2 ...]\n");
+    printf("  ./manage download [-o 目录] <文件名> [文件名2 ...]\n");
+    printf("  ./manage create-release <tag_name> [选项] [文件...]\n");
+    printf("  ./manage apply [-j N] <任务文件>   # 一次上传到多个仓库/Release\n");
+    printf("  ./manage serve --socket <路径> [--cache-ttl 秒]\n");
+    printf("  ./manage help         # 显示详细说明\n");
+    printf("\n批量操作（支持通配符）:\n");
+    printf("  ./manage upload *.zip\n");
+    printf("  ./manage update *.zip\n");
+    printf("  ./manage delete *.tmp\n");
+    printf("  ./manage delete --match '*.tmp' -j 8   # 按 Release 中的文件名匹配，8 个并发删除\n");
+    printf("  ./manage upload file1.zip file2.zip file3.zip\n");
+    printf("  ./manage upload -j 8 *.zip          # 8 个文件并发上传\n");
+    printf("  ./manage upload --checksums *.zip   # 上传的同时生成 SHA256SUMS\n");
+    printf("  ./manage upload -j 8 'out/**/*.zip' # 递归上传目录中的文件，边扫描边上传\n");
+    printf("  ./manage upload --compress gzip *.log # 压缩后上传为 *.log.gz\n");
+    printf("  ./manage upload -j 4 --limit-rate 20M --priority '*.tar.gz' dist/*  # 共用 20 MB/s，先传 tar 包\n");
+    printf("  ./manage upload -j 8 --split 1G disk.img   # 切成 1 GiB 的分片并发上传\n");
+    printf("  ./manage download -j 8 disk.img            # 并发下载分片并拼接回 disk.img\n");
+    printf("\n全局选项:\n");
+    printf("  --metrics <文件>    把每个请求的耗时、字节数和整批统计写入报告（.csv 为 CSV，其余为 JSON）\n");
+    printf("\n环境变量:\n");
+    printf("  GITHUB_TOKEN: GitHub API 令牌（必需）\n");
+    printf("  GITHUB_OWNER: GitHub 仓库所有者（默认: nostalgia296）\n");
+    printf("  GITHUB_REPO:  GitHub 仓库名（默认: backup）\n");
+    printf("  GITHUB_TAG:   指定要操作的Release Tag（可选，未指定时使用最新的Release）\n");
+    printf("  MANAGE_CONCURRENCY: 批量上传的并发数（默认: 1，可被 -j 覆盖）\n");
+    printf("  MANAGE_DEADLINE: 单个操作含重试的总时限（秒，可被 --deadline 覆盖，遵守速率限制的等待不计入）\n");
+    printf("  MANAGE_LIMIT_RATE: 上传总带宽上限（字节/秒，可带 K/M/G，可被 --limit-rate 覆盖）\n");
+    printf("  MANAGE_SPEED_LIMIT / MANAGE_SPEED_TIME: 停滞检测的速率和秒数（可被 --speed-limit/--speed-time 覆盖）\n");
+    printf("  GITHUB_API_URL: API 地址（默认: %s）\n", DEFAULT_API_BASE);
+    printf("  MANAGE_UPLOAD_URL: 替换上传地址的协议和主机（默认使用 Release 返回的 upload_url）\n");
+    printf("  MANAGE_SOCKET: manage serve 的 socket 路径，设置后命令交给守护进程执行\n");
+}
+
+void showDetailedUsage() {
+    printf("GitHub Release 管理工具 - 详细说明\n");
+    printf("=====================================\n\n");
+
+    printf("快速开始:\n");
+    printf("  export GITHUB_TOKEN=your_token_here\n");
+    printf("  ./manage list                      # 查看当前 Release 中的文件\n");
+    printf("  ./manage upload myfile.zip        # 上传文件\n");
+    printf("  ./manage update myfile.zip        # 更新文件\n");
+    printf("  ./manage create-release v1.0      # 创建新 Release\n\n");
+
+    printf("命令用法:\n");
+    printf("-----------\n\n");
+
+    printf("上传文件 (upload):\n");
+    printf("  ./manage upload <文件路径> [文件2] [文件3] ...\n");
+    printf("  示例:\n");
+    printf("    ./manage upload backup.zip\n");
+    printf("    ./manage upload *.zip\n");
+    printf("    ./manage upload file1.zip file2.zip file3.zip\n");
+    printf("    ./manage upload -j 8 *.zip       # 最多 8 个文件同时上传\n");
+    printf("    ./manage upload -j 8 out         # 上传 out 目录下的全部文件（含子目录）\n");
+    printf("    ./manage upload 'out/**/*.zip'   # ** 匹配任意层目录，需加引号\n");
+    printf("  选项:\n");
+    printf("    -j, --jobs <N>           并发上传数（1-%d，默认读取 MANAGE_CONCURRENCY）\n", MAX_CONCURRENCY);
+    printf("    --deadline <秒>          每个文件含重试的总时限（默认读取 MANAGE_DEADLINE，0 表示不限）\n");
+    printf("    --journal                在当前目录记录上传日志 " UPLOAD_JOURNAL_FORMAT "，全部成功后自动删除；\n",
+           "<release_id>");
+    printf("                             中断或失败后可以用 --resume 继续\n");
+    printf("    --resume                 按上传日志续传（隐含 --journal）：跳过上次已完成的文件，清理中断留下的半成品资产\n");
+    printf("    --checksums[=算法]       上传时计算校验和，并上传 SHA256SUMS（blake2b 对应 B2SUMS）\n");
+    printf("                             算法可选 sha256、blake2b，用逗号分隔，默认 sha256\n");
+    printf("    --flatten <方式>         目录上传时的资产名：path（默认）用 \"%s\" 连接相对路径中的各级目录，\n",
+           DEFAULT_FLATTEN_SEPARATOR);
+    printf("                             path:<分隔符> 指定分隔符（不能含 / # & ? %% +），base 只保留文件名；\n");
+    printf("                             资产名冲突的文件会被跳过\n");
+    printf("    --compress <格式[:级别]>  上传前压缩，资产名追加 .gz 或 .zst；格式为 gzip（级别 1-9）\n");
+    printf("                             或 zstd（级别 1-22，多线程压缩，需用 make ZSTD=1 编译）\n");
+    printf("                             压缩结果暂存在内存中（GitHub 上传需要预先知道大小），不写临时文件\n");
+    printf("    --limit-rate <速率>      所有并发上传合计的带宽上限，如 500K、20M（字节/秒，默认读取\n");
+    printf("                             MANAGE_LIMIT_RATE，0 表示不限）；暂停的传输按队列顺序优先恢复\n");
+    printf("    --priority <通配符>      名字匹配的文件先上传，可重复，先写的优先级高\n");
+    printf("    --smallest-first         同一优先级内小文件先上传（默认保持命令行顺序）\n");
+    printf("    --speed-limit <速率>     传输速率持续低于该值（字节/秒，可带 K/M/G）达到 --speed-time 秒\n");
+    printf("    --speed-time <秒>        （默认 %d）时视为停滞，中止并重试\n", DEFAULT_SPEED_TIME);
+    printf("    --no-progress            不显示传输进度。stderr 是终端时显示一行实时进度（总进度、速率、\n");
+    printf("                             剩余时间，以及最晚完成的文件），否则每 %.0f 秒输出一组进度日志\n",
+           PROGRESS_LOG_INTERVAL);
+    printf("    --split <大小>           大于该大小的文件切成分片上传（<文件名>.part000、.part001 …，大小向下取整到\n");
+    printf("                             64K 的倍数，1M 以上、小于 2G），全部分片成功后上传分片清单\n");
+    printf("                             <文件名>" SPLIT_MANIFEST_SUFFIX "；用 download 下载时自动拼接。GitHub 单个资产不能\n");
+    printf("                             超过 2 GiB，更大的文件必须切分。不能与目录上传、--journal、--resume、--compress 同时使用\n");
+    printf("  目录参数和含 ** 或目录的通配符由 %d 个线程并行扫描，扫描到的文件立即开始上传；\n", WALK_THREADS);
+    printf("  跳过隐藏文件，不进入指向目录的符号链接；扫描到的文件按扫描顺序上传，不参与排序\n\n");
+
+    printf("删除文件 (delete):\n");
+    printf("  ./manage delete <文件名> [文件2] [文件3] ...\n");
+    printf("  示例:\n");
+    printf("    ./manage delete oldfile.zip\n");
+    printf("    ./manage delete *.tmp\n");
+    printf("    ./manage delete file1.tmp file2.tmp\n");
+    printf("    ./manage delete --match 'nightly-*.zip' --dry-run   # 先预览要删除的文件\n");
+    printf("    ./manage delete --regex '^build-[0-9]+\\.log$' -j 8\n");
+    printf("  选项:\n");
+    printf("    --match <通配符>         删除 Release 中名字匹配的文件（需加引号，避免被 shell 展开）\n");
+    printf("    --regex <正则>           同上，使用 POSIX 扩展正则表达式；可与 --match 和文件名混用\n");
+    printf("    --dry-run                只列出将要删除的文件和总大小，不执行删除\n");
+    printf("    -j, --jobs <N>           并发删除数（1-%d，默认读取 MANAGE_CONCURRENCY）\n", MAX_CONCURRENCY);
+    printf("    --deadline <秒>          每个文件含重试的总时限\n");
+    printf("  使用模式、--dry-run 或 -j 大于 1 时，资产列表只获取一次，本地匹配后并发删除\n\n");
+
+    printf("列出文件 (list):\n");
+    printf("  ./manage list [--format 格式] [--all-releases] [-j N]\n");
+    printf("  显示 Release 中的所有文件，包括大小和下载次数\n");
+    printf("  示例:\n");
+    printf("    ./manage list --format ndjson > assets.ndjson\n");
+    printf("    ./manage list --all-releases --format csv > inventory.csv\n");
+    printf("  选项:\n");
+    printf("    --format <格式>          table（默认）、ndjson、json 或 csv；后三种逐条输出完整记录\n");
+    printf("                             （release_id、release_tag、id、name、size、digest、download_count、\n");
+    printf("                             时间戳等），状态信息写到 stderr，stdout 只有数据\n");
+    printf("    --all-releases           列出所有 Release 的资产；得知总页数后并发获取各页，\n");
+    printf("                             不同页的记录可能交错输出\n");
+    printf("    -j, --jobs <N>           同时获取的页数（默认 %d）\n", LIST_PAGE_CONCURRENCY);
+    printf("    --deadline <秒>          每一页含重试的总时限\n\n");
+
+    printf("更新文件 (update):\n");
+    printf("  ./manage update <文件路径> [文件2] [文件3] ...\n");
+    printf("  先删除旧文件，再上传新文件（用于替换已存在文件）\n");
+    printf("  批量更新时，后一个文件的旧版本会在前一个文件上传期间删除\n");
+    printf("  示例:\n");
+    printf("    ./manage update newbackup.zip\n");
+    printf("    ./manage update *.zip\n");
+    printf("    ./manage update -j 4 *.zip       # 最多 4 个文件同时上传\n");
+    printf("  选项:\n");
+    printf("    -j, --jobs <N>           并发上传数\n");
+    printf("    --deadline <秒>          每个文件含重试的总时限\n");
+    printf("    --compress <格式[:级别]>  同 upload，替换的是带 .gz/.zst 后缀的资产\n");
+    printf("    --split <大小>           同 upload，替换同名的分片和分片清单（旧文件分片更多时，多出的分片不会删除）\n");
+    printf("    --limit-rate <速率>、--priority <通配符>、--smallest-first  同 upload\n");
+    printf("    --speed-limit <速率>、--speed-time <秒>、--no-progress  同 upload\n\n");
+
+    printf("增量同步 (sync):\n");
+    printf("  ./manage sync [选项] <文件路径> [文件2] [文件3] ...\n");
+    printf("  按大小和 SHA-256 比较本地文件与 Release 中的资产，只上传新增或内容变化的文件\n");
+    printf("  远端哈希依次取自 GitHub 的 digest 字段、\"sha256:...\" 形式的资产标签、本地清单\n");
+    printf("  选项:\n");
+    printf("    --delete                 删除 Release 中本地已不存在的文件\n");
+    printf("    --dry-run                只打印同步计划，不做修改\n");
+    printf("    --manifest <file>        本地哈希清单路径（默认: %s）\n", DEFAULT_SYNC_MANIFEST);
+    printf("    -j, --jobs <N>           并发上传数\n");
+    printf("    --deadline <秒>          每个文件含重试的总时限\n");
+    printf("  示例:\n");
+    printf("    ./manage sync --dry-run dist/*\n");
+    printf("    ./manage sync --delete -j 4 dist/*\n\n");
+
+    printf("下载文件 (download):\n");
+    printf("  ./manage download [选项] <文件名> [文件名2] ...\n");
+    printf("  并发下载 Release 中的文件。用 --split 上传的文件先下载分片清单，再并发下载全部分片，\n");
+    printf("  直接写入预先分配好大小的文件中各自的位置，并按清单校验每个分片的 SHA-256；\n");
+    printf("  普通资产在 GitHub 提供了 digest 时同样校验。下载过程中写入 <文件名>" DOWNLOAD_TEMP_SUFFIX "，\n");
+    printf("  全部成功后才改名，失败时删除\n");
+    printf("  选项:\n");
+    printf("    -o, --output <目录>      保存到的目录（默认当前目录）\n");
+    printf("    -j, --jobs <N>           同时下载的请求数\n");
+    printf("    --deadline <秒>          每个请求含重试的总时限\n");
+    printf("    --speed-limit <速率>、--speed-time <秒>、--no-progress  同 upload\n");
+    printf("  示例:\n");
+    printf("    ./manage download -j 8 -o restore disk.img\n\n");
+
+    printf("创建 Release (create-release):\n");
+    printf("  ./manage create-release <tag_name> [选项] [文件...]\n");
+    printf("  选项:\n");
+    printf("    -n, --name <name>        Release 名称（默认使用 tag_name）\n");
+    printf("    -d, --description <desc> Release 描述\n");
+    printf("    -p, --prerelease         标记为预发布版本\n");
+    printf("    -j, --jobs <N>           并发上传数\n");
+    printf("    --deadline <秒>          每个请求含重试的总时限\n");
+    printf("    --checksums[=算法]       上传时计算校验和，并上传 SHA256SUMS/B2SUMS\n");
+    printf("    [文件...]                创建 release 后要上传的文件（支持通配符）\n");
+    printf("  示例:\n");
+    printf("    ./manage create-release v1.0                           # 创建普通 release\n");
+    printf("    ./manage create-release v1.0 -n \"Version 1.0\"          # 创建指定名称的 release\n");
+    printf("    ./manage create-release v1.0 -d \"First stable release\" # 创建带描述的 release\n");
+    printf("    ./manage create-release v1.0-beta -p                   # 创建预发布版本\n");
+    printf("    ./manage create-release v1.0 *.zip                     # 创建 release 并上传所有 zip 文件\n");
+    printf("    ./manage create-release v1.0 file1.zip file2.zip       # 创建 release 并上传指定文件\n\n");
+
+    printf("批量任务 (apply):\n");
+    printf("  ./manage apply [-j N] [--deadline <秒>] [--limit-rate <速率>] [--speed-limit <速率>] <任务文件>\n");
+    printf("  按任务文件上传到多个仓库和 Release：先并发解析所有 Release，再把全部文件放进同一个\n");
+    printf("  上传队列，共用连接池和并发上限（-j 优先于文件中的 concurrency）\n");
+    printf("  任务文件是 JSON，jobs 中每一项为一个仓库的一个 Release:\n");
+    printf("    {\"concurrency\": 8, \"jobs\": [\n");
+    printf("      {\"repo\": \"owner/app\", \"tag\": \"v1.0\", \"files\": [\"app-*.zip\"]},\n");
+    printf("      {\"repo\": \"owner/mirror\", \"files\": \"app-*.zip\", \"replace\": true}]}\n");
+    printf("  repo 只写仓库名时 owner 取自 \"owner\" 字段或 GITHUB_OWNER；省略 tag 时取 GITHUB_TAG，\n");
+    printf("  都没有时使用最新 Release；replace 为 true 时先删除同名旧文件（同 update）\n");
+    printf("  某个 Release 解析失败时跳过其中的文件，其余照常上传，最后按 Release 汇总结果\n\n");
+
+    printf("守护进程 (serve):\n");
+    printf("  ./manage serve --socket <路径> [--cache-ttl <秒>]\n");
+    printf("  常驻进程，在 Unix socket（权限 0600）上逐个执行其他 manage 进程转交的命令。\n");
+    printf("  进程内保持配置、TCP/TLS 连接和最近解析的 Release 及资产索引，\n");
+    printf("  同一个 owner/repo/tag 在 --cache-ttl 秒内（默认 %d）不再请求 API 解析 Release；\n", SERVE_CACHE_TTL);
+    printf("  命令失败或执行 create-release 后缓存失效。收到 SIGINT/SIGTERM 时退出并删除 socket\n");
+    printf("  设置 MANAGE_SOCKET 后，其他命令都交给守护进程执行：输出直接写到调用者的\n");
+    printf("  stdout/stderr，在调用者的当前目录中执行，退出码相同；守护进程未运行时在本进程中执行。\n");
+    printf("  调用者的 GITHUB_OWNER、GITHUB_REPO、GITHUB_TAG、MANAGE_CONCURRENCY、MANAGE_DEADLINE、\n");
+    printf("  MANAGE_LIMIT_RATE 会随命令转发，token 和 API 地址使用守护进程自己的配置\n");
+    printf("  示例:\n");
+    printf("    ./manage serve --socket /run/user/$UID/manage.sock &\n");
+    printf("    export MANAGE_SOCKET=/run/user/$UID/manage.sock\n");
+    printf("    ./manage upload -j 8 dist/*.zip\n\n");
+
+    printf("全局选项:\n");
+    printf("-----------\n");
+    printf("  --metrics <文件>   可用于任何命令。记录每个请求的 DNS、连接、TLS、首字节和总耗时（微秒）、\n");
+    printf("                     上传/下载字节数、速度和第几次尝试，并按文件汇总，\n");
+    printf("                     附带各阶段耗时的 p50/p95/p99 和整批吞吐（MB/s）\n");
+    printf("                     文件扩展名为 .csv 时写 CSV（type 列区分明细和汇总行），否则写 JSON\n");
+    printf("  示例:\n");
+    printf("    ./manage upload -j 4 --metrics publish.json dist/*\n\n");
+
+    printf("环境变量配置:\n");
+    printf("-------------\n\n");
+
+    printf("必须在运行前设置 GITHUB_TOKEN:\n");
+    printf("  export GITHUB_TOKEN=\"ghp_your_personal_access_token\"\n\n");
+
+    printf("可选环境变量:\n");
+    printf("  GITHUB_OWNER:  GitHub 用户名或组织名（默认: nostalgia296）\n");
+    printf("  GITHUB_REPO:   仓库名称（默认: backup）\n");
+    printf("  GITHUB_TAG:    指定要操作的 Release Tag（未指定时使用最新 Release）\n");
+    printf("  MANAGE_CONCURRENCY: 批量上传的并发数（默认: 1）\n");
+    printf("  MANAGE_DEADLINE: 单个操作含重试的总时限，单位秒（默认: 0，不限）\n");
+    printf("  MANAGE_LIMIT_RATE: 上传总带宽上限，字节/秒，可带 K/M/G 后缀（默认: 0，不限）\n");
+    printf("  GITHUB_API_URL: API 地址（默认: %s），GitHub Enterprise 使用 https://<主机>/api/v3\n",
+           DEFAULT_API_BASE);
+    printf("  MANAGE_UPLOAD_URL: 上传地址的协议和主机，如 https://uploads.example.com（默认使用 upload_url）\n");
+    printf("  MANAGE_SOCKET: manage serve 守护进程的 socket，设置后命令交给守护进程执行\n");
+    printf("  示例:\n");
+    printf("    export GITHUB_OWNER=\"myusername\"\n");
+    printf("    export GITHUB_REPO=\"my-backup\"\n");
+    printf("    export GITHUB_TAG=\"v1.0\"\n\n");
+
+    printf("获取 GitHub Token:\n");
+    printf("  1. 访问 https://github.com/settings/tokens\n");
+    printf("  2. 点击 \"Generate new token\" → \"Generate new token (classic)\"\n");
+    printf("  3. 选择 'repo' 作用域以访问私有仓库\n");
+    printf("  4. 生成并复制 token\n");
+    printf("  5. 在运行程序前设置环境变量\n\n");
+
+    printf("注意事项:\n");
+    printf("-----------\n");
+    printf("  - 上传文件需要在 GitHub Release 中至少有一个 Release\n");
+    printf("  - 操作可能需要几秒到几十秒，取决于文件大小和网络状况\n");
+    printf("  - API 调用有速率限制，程序会根据剩余配额自动调整请求速度，触发限流时自动等待\n");
+    printf("  - 如果上传失败，请检查文件大小是否超过 GitHub 限制\n");
+}
+
+// 执行一条命令，argv[1] 为命令名。base 提供连接配置、Release 缓存和临时内存，
+// 命令行选项（并发数、校验和、压缩等）只作用于本次执行。resolvedReleaseId 非 NULL 时
+// 返回本次命令所用的 release id（调用者释放），命令没有用到 Release 或失败时为 NULL
+static ErrorCode runCommand(int argc, char **argv, const Config *base, char **resolvedReleaseId) {
+    if (resolvedReleaseId) {
+        *resolvedReleaseId = NULL;
+    }
+
+    // --metrics 对所有命令有效，先从参数中取出来，各命令的参数解析不需要关心它
+    const char *metricsPath = NULL;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误：--metrics 需要一个文件路径\n");
+                return ERR_CONFIG;
+            }
+            metricsPath = argv[++i];
+        } else if (strncmp(argv[i], "--metrics=", 10) == 0) {
+            metricsPath = argv[i] + 10;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    argv[argc] = NULL;
+    if (metricsPath) {
+        enableMetrics();
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "错误：请提供命令和参数。\n");
+        showUsage();
+        freeMetrics();
+        return ERR_CONFIG;
+    }
+
+    Config config = *base;
+    ChecksumSet checksum_set;
+    UploadCompression compression = { COMPRESS_NONE, 0 };
+    initChecksumSet(&checksum_set, 0);
+    config.release_id = NULL;
+    status_to_stderr = 0;
+
+    const char *command = argv[1];
+    ErrorCode result = ERR_OK;
+    int usedRelease = 0;
+
+    if (base->release_id) {
+        config.release_id = strdup(base->release_id);
+        if (!config.release_id) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    // 处理不需要获取 release_id 的命令
+    if (strcmp(command, "help") == 0) {
+        showDetailedUsage();
+        goto cleanup;
+    }
+
+    // list 的参数要在获取 release_id 之前解析：--all-releases 不需要 release_id，
+    // 机器可读格式下状态信息改写到 stderr
+    ListOptions listOptions = { LIST_TABLE, 0 };
+    if (strcmp(command, "list") == 0) {
+        if (parseListOptions(argc - 2, argv + 2, &listOptions, &config) != ERR_OK) {
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+        status_to_stderr = (listOptions.format != LIST_TABLE);
+    }
+
+    // 某些命令不需要预先获取 release_id
+    // apply 的每个任务各自指定仓库和 tag，不使用命令的 release_id
+    if (strcmp(command, "create-release") != 0 && strcmp(command, "apply") != 0 && !listOptions.all_releases) {
+        if (config.release_id) {
+            // 守护进程中同一个 tag 刚解析过，沿用它和已缓存的资产索引
+            fprintf(statusStream(), "使用Release ID: %s\n", config.release_id);
+        } else if (getLatestReleaseId(&config) != ERR_OK) {
+            // 获取最新的release id（动态分配）- 只调用一次
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+        usedRelease = 1;
+    }
+
+    if (strcmp(command, "upload") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "错误：请提供文件路径。\n");
+            showUsage();
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+
+        // 处理批量上传
+        int totalFiles = 0;
+        char **allFiles = NULL;
+        int journal = 0;   // --journal 或 --resume：记录上传日志
+        int resume = 0;
+        long long splitSize = 0;
+        WalkSpec *walkSpecs = calloc(argc, sizeof(WalkSpec));
+        int walkSpecCount = 0;
+        FlattenStyle flatten = { 1, DEFAULT_FLATTEN_SEPARATOR };
+        UploadOrder order = {0};
+
+        if (!walkSpecs) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--resume") == 0) {
+                resume = 1;
+                journal = 1;
+                continue;
+            }
+            if (strcmp(argv[i], "--journal") == 0) {
+                journal = 1;
+                continue;
+            }
+            int queueArgs = parseUploadQueueOption(argc, argv, i, &config, &order);
+            if (queueArgs < 0) {
+                result = ERR_CONFIG;
+                break;
+            }
+            if (queueArgs > 0) {
+                i += queueArgs - 1; // 跳过选项的参数
+                continue;
+            }
+            if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+                int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+                if (concurrency < 0) {
+                    fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.concurrency = concurrency;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strcmp(argv[i], "--deadline") == 0) {
+                double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+                if (deadline < 0) {
+                    fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.deadline = deadline;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strncmp(argv[i], "--checksums", 11) == 0 && (argv[i][11] == '\0' || argv[i][11] == '=')) {
+                int algorithms = parseChecksumAlgorithms(argv[i][11] == '=' ? argv[i] + 12 : NULL);
+                if (algorithms < 0) {
+                    fprintf(stderr, "错误：--checksums 只支持 sha256 和 blake2b\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                checksum_set.algorithms = algorithms;
+                config.checksums = &checksum_set;
+                continue;
+            }
+            if (strcmp(argv[i], "--compress") == 0) {
+                if (reportCompressionOption(i + 1 < argc ? argv[i + 1] : NULL, &compression) != 0) {
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.compression = &compression;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strcmp(argv[i], "--split") == 0) {
+                splitSize = (i + 1 < argc) ? parseSplitSize(argv[i + 1]) : -1;
+                if (splitSize < 0) {
+                    fprintf(stderr, "错误：--split 需要一个 1M 以上、小于 2G 的大小\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strcmp(argv[i], "--flatten") == 0) {
+                if (i + 1 >= argc || parseFlattenStyle(argv[i + 1], &flatten) != 0) {
+                    fprintf(stderr, "错误：--flatten 需要 base、path 或 path:<分隔符>（分隔符不能含 / # & ? %% +）\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                i++; // 跳过下一个参数
+                continue;
+            }
+
+            // 目录、** 和带目录的通配符交给扫描线程
+            int isTree = parseWalkSpec(argv[i], &walkSpecs[walkSpecCount]);
+            if (isTree < 0) {
+                result = ERR_INVALID_PATH;
+                break;
+            }
+            if (isTree > 0) {
+                walkSpecCount++;
+                continue;
+            }
+
+            char **matchedFiles = NULL;
+            int fileCount = expandWildcards(argv[i], &matchedFiles);
+
+            if (fileCount > 0) {
+                char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
+                if (!newAllFiles) {
+                    fprintf(stderr, "内存分配失败\n");
+                    result = ERR_MEMORY;
+                    for (int j = 0; j < fileCount; j++) {
+                        free(matchedFiles[j]);
+                    }
+                    free(matchedFiles);
+                    break;
+                }
+                allFiles = newAllFiles;
+
+                for (int j = 0; j < fileCount; j++) {
+                    allFiles[totalFiles++] = matchedFiles[j];
+                }
+                free(matchedFiles);
+            }
+        }
+
+        if (result == ERR_OK) {
+            if (walkSpecCount > 0 && journal) {
+                fprintf(stderr, "错误：--journal 和 --resume 暂不支持目录上传\n");
+                result = ERR_CONFIG;
+            } else if (splitSize > 0 && (walkSpecCount > 0 || journal || config.compression)) {
+                fprintf(stderr, "错误：--split 不能与目录上传、--journal、--resume 或 --compress 同时使用\n");
+                result = ERR_CONFIG;
+            } else if (walkSpecCount == 0 && totalFiles == 0) {
+                fprintf(stderr, "错误：找不到匹配的文件\n");
+                result = ERR_FILE_IO;
+            } else if ((result = orderUploadFiles(allFiles, totalFiles, &order)) == ERR_OK) {
+                if (walkSpecCount > 0) {
+                    result = uploadTree(totalFiles, allFiles, walkSpecs, walkSpecCount, &flatten, &config);
+                } else if (splitSize > 0) {
+                    result = uploadSplitFiles(totalFiles, allFiles, &config, splitSize, 0);
+                } else if (journal) {
+                    result = uploadFilesResumable(totalFiles, allFiles, &config, resume);
+                } else {
+                    result = uploadMultipleFiles(totalFiles, allFiles, &config);
+                }
+                if (config.checksums) {
+                    ErrorCode sumsResult = publishChecksums(&config);
+                    if (result == ERR_OK) result = sumsResult;
+                }
+            }
+        }
+
+        // 清理文件列表
+        if (allFiles) {
+            for (int i = 0; i < totalFiles; i++) {
+                free(allFiles[i]);
+            }
+            free(allFiles);
+        }
+        for (int i = 0; i < walkSpecCount; i++) {
+            freeWalkSpec(&walkSpecs[i]);
+        }
+        free(walkSpecs);
+    } else if (strcmp(command, "delete") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "错误：请提供文件名。\n");
+            showUsage();
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+
+        char **names = calloc(argc, sizeof(char *));
+        AssetPattern *patterns = calloc(argc, sizeof(AssetPattern));
+        int nameCount = 0;
+        int patternCount = 0;
+        int dryRun = 0;
+
+        if (!names || !patterns) {
+            fprintf(stderr, "内存分配失败\n");
+            free(names);
+            free(patterns);
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+
+        // 收集所有要删除的文件和匹配模式
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--match") == 0 || strcmp(argv[i], "--regex") == 0) {
+                if (i + 1 >= argc) {
+                    fprintf(stderr, "错误：%s 需要一个模式\n", argv[i]);
+                    result = ERR_CONFIG;
+                    break;
+                }
+                AssetPattern *pattern = &patterns[patternCount++];
+                pattern->is_regex = (argv[i][2] == 'r');
+                pattern->text = argv[++i];
+                if (pattern->is_regex) {
+                    int rc = regcomp(&pattern->regex, pattern->text, REG_EXTENDED | REG_NOSUB);
+                    if (rc != 0) {
+                        char message[256];
+                        regerror(rc, &pattern->regex, message, sizeof(message));
+                        fprintf(stderr, "错误：无效的正则表达式 \"%s\": %s\n", pattern->text, message);
+                        result = ERR_CONFIG;
+                        break;
+                    }
+                    pattern->compiled = 1;
+                }
+                continue;
+            } else if (strcmp(argv[i], "--dry-run") == 0) {
+                dryRun = 1;
+                continue;
+            } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+                int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+                if (concurrency < 0) {
+                    fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.concurrency = concurrency;
+                i++; // 跳过下一个参数
+                continue;
+            } else if (strcmp(argv[i], "--deadline") == 0) {
+                double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+                if (deadline < 0) {
+                    fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.deadline = deadline;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            names[nameCount++] = argv[i];
+        }
+
+        if (result == ERR_OK) {
+            if (nameCount == 0 && patternCount == 0) {
+                fprintf(stderr, "错误：请提供文件名或 --match/--regex 模式。\n");
+                result = ERR_CONFIG;
+            } else if (patternCount == 0 && !dryRun && config.concurrency <= 1) {
+                result = deleteMultipleFiles(nameCount, names, &config);
+            } else {
+                // 只获取一次资产列表，在本地匹配后并发删除
+                result = deleteMatchingAssets(nameCount, names, patternCount, patterns, dryRun, &config);
+            }
+        }
+
+        for (int i = 0; i < patternCount; i++) {
+            if (patterns[i].compiled) regfree(&patterns[i].regex);
+        }
+        free(patterns);
+        free(names);
+    } else if (strcmp(command, "update") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "错误：请提供文件路径。\n");
+            showUsage();
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+
+        // 处理批量更新
+        int totalFiles = 0;
+        char **allFiles = NULL;
+        long long splitSize = 0;
+        UploadOrder order = {0};
+
+        for (int i = 2; i < argc; i++) {
+            int queueArgs = parseUploadQueueOption(argc, argv, i, &config, &order);
+            if (queueArgs < 0) {
+                result = ERR_CONFIG;
+                if (allFiles) {
+                    for (int j = 0; j < totalFiles; j++) {
+                        free(allFiles[j]);
+                    }
+                    free(allFiles);
+                }
+                goto cleanup;
+            }
+            if (queueArgs > 0) {
+                i += queueArgs - 1; // 跳过选项的参数
+                continue;
+            }
+            if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+                int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+                if (concurrency < 0) {
+                    fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                    result = ERR_CONFIG;
+                    if (allFiles) {
+                        for (int j = 0; j < totalFiles; j++) {
+                            free(allFiles[j]);
+                        }
+                        free(allFiles);
+                    }
+                    goto cleanup;
+                }
+                config.concurrency = concurrency;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strcmp(argv[i], "--deadline") == 0) {
+                double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+                if (deadline < 0) {
+                    fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                    result = ERR_CONFIG;
+                    if (allFiles) {
+                        for (int j = 0; j < totalFiles; j++) {
+                            free(allFiles[j]);
+                        }
+                        free(allFiles);
+                    }
+                    goto cleanup;
+                }
+                config.deadline = deadline;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strcmp(argv[i], "--compress") == 0) {
+                if (reportCompressionOption(i + 1 < argc ? argv[i + 1] : NULL, &compression) != 0) {
+                    result = ERR_CONFIG;
+                    if (allFiles) {
+                        for (int j = 0; j < totalFiles; j++) {
+                            free(allFiles[j]);
+                        }
+                        free(allFiles);
+                    }
+                    goto cleanup;
+                }
+                config.compression = &compression;
+                i++; // 跳过下一个参数
+                continue;
+            }
+            if (strcmp(argv[i], "--split") == 0) {
+                splitSize = (i + 1 < argc) ? parseSplitSize(argv[i + 1]) : -1;
+                if (splitSize < 0) {
+                    fprintf(stderr, "错误：--split 需要一个 1M 以上、小于 2G 的大小\n");
+                    result = ERR_CONFIG;
+                    if (allFiles) {
+                        for (int j = 0; j < totalFiles; j++) {
+                            free(allFiles[j]);
+                        }
+                        free(allFiles);
+                    }
+                    goto cleanup;
+                }
+                i++; // 跳过下一个参数
+                continue;
+            }
+
+            char **matchedFiles = NULL;
+            int fileCount = expandWildcards(argv[i], &matchedFiles);
+
+            if (fileCount > 0) {
+                char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
+                if (!newAllFiles) {
+                    fprintf(stderr, "内存分配失败\n");
+                    result = ERR_MEMORY;
+                    // 释放已分配的文件名
+                    if (allFiles) {
+                        for (int j = 0; j < totalFiles; j++) {
+                            free(allFiles[j]);
+                        }
+                        free(allFiles);
+                    }
+                    for (int j = 0; j < fileCount; j++) {
+                        free(matchedFiles[j]);
+                    }
+                    free(matchedFiles);
+                    goto cleanup;
+                }
+                allFiles = newAllFiles;
+
+                for (int j = 0; j < fileCount; j++) {
+                    allFiles[totalFiles++] = matchedFiles[j];
+                }
+                free(matchedFiles);
+            }
+        }
+
+        if (totalFiles == 0) {
+            fprintf(stderr, "错误：找不到匹配的文件\n");
+            result = ERR_FILE_IO;
+        } else if (splitSize > 0 && config.compression) {
+            fprintf(stderr, "错误：--split 不能与 --compress 同时使用\n");
+            result = ERR_CONFIG;
+        } else if ((result = orderUploadFiles(allFiles, totalFiles, &order)) == ERR_OK) {
+            if (splitSize > 0) {
+                result = uploadSplitFiles(totalFiles, allFiles, &config, splitSize, 1);
+            } else {
+                result = updateMultipleFiles(totalFiles, allFiles, &config);
+            }
+        }
+
+        // 清理文件列表
+        if (allFiles) {
+            for (int i = 0; i < totalFiles; i++) {
+                free(allFiles[i]);
+            }
+            free(allFiles);
+        }
+    } else if (strcmp(command, "sync") == 0) {
+        int deleteOrphans = 0;
+        int dryRun = 0;
+        const char *manifestPath = DEFAULT_SYNC_MANIFEST;
+        int totalFiles = 0;
+        char **allFiles = NULL;
+
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--delete") == 0) {
+                deleteOrphans = 1;
+                continue;
+            } else if (strcmp(argv[i], "--dry-run") == 0) {
+                dryRun = 1;
+                continue;
+            } else if (strcmp(argv[i], "--manifest") == 0) {
+                if (i + 1 >= argc) {
+                    fprintf(stderr, "错误：--manifest 需要一个文件路径\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                manifestPath = argv[++i];
+                continue;
+            } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+                int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+                if (concurrency < 0) {
+                    fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.concurrency = concurrency;
+                i++; // 跳过下一个参数
+                continue;
+            } else if (strcmp(argv[i], "--deadline") == 0) {
+                double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+                if (deadline < 0) {
+                    fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                    result = ERR_CONFIG;
+                    break;
+                }
+                config.deadline = deadline;
+                i++; // 跳过下一个参数
+                continue;
+            }
+
+            char **matchedFiles = NULL;
+            int fileCount = expandWildcards(argv[i], &matchedFiles);
+            if (fileCount <= 0) {
+                continue;
+            }
+
+            char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
+            if (!newAllFiles) {
+                fprintf(stderr, "内存分配失败\n");
+                result = ERR_MEMORY;
+                for (int j = 0; j < fileCount; j++) {
+                    free(matchedFiles[j]);
+                }
+                free(matchedFiles);
+                break;
+            }
+            allFiles = newAllFiles;
+
+            for (int j = 0; j < fileCount; j++) {
+                allFiles[totalFiles++] = matchedFiles[j];
+            }
+            free(matchedFiles);
+        }
+
+        if (result == ERR_OK) {
+            if (totalFiles == 0) {
+                fprintf(stderr, "错误：找不到匹配的文件\n");
+                result = ERR_FILE_IO;
+            } else {
+                result = syncFiles(totalFiles, allFiles, &config, deleteOrphans, dryRun, manifestPath);
+            }
+        }
+
+        // 清理文件列表
         if (allFiles) {
             for (int i = 0; i < totalFiles; i++) {
                 free(allFiles[i]);
             }
-            free(allFiles);
+            free(allFiles);
+        }
+    } else if (strcmp(command, "download") == 0) {
+        result = downloadAssets(argc - 2, argv + 2, &config);
+    } else if (strcmp(command, "apply") == 0) {
+        result = applyJobFile(argc - 2, argv + 2, &config);
+    } else if (strcmp(command, "list") == 0) {
+        if (listOptions.format == LIST_TABLE && !listOptions.all_releases) {
+            result = listFiles(&config);
+        } else {
+            result = exportAssets(&listOptions, &config);
+        }
+    } else if (strcmp(command, "create-release") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "错误：请提供 tag_name。\n");
+            showUsage();
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+
+        // 创建新的 Release ID 用于接收函数返回值
+        char *new_release_id = NULL;
+
+        // 解析命令行参数
+        const char *tag_name = argv[2];
+        const char *release_name = NULL;
+        const char *description = NULL;
+        int is_prerelease = 0;
+
+        // 解析可选参数和文件参数
+        int file_argv_start = 3;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--name") == 0) {
+                if (i + 1 < argc) {
+                    release_name = argv[i + 1];
+                    i++; // 跳过下一个参数
+                } else {
+                    fprintf(stderr, "错误：-n 或 --name 需要一个参数\n");
+                    showUsage();
+                    result = ERR_CONFIG;
+                    goto cleanup;
+                }
+            } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--description") == 0) {
+                if (i + 1 < argc) {
+                    description = argv[i + 1];
+                    i++; // 跳过下一个参数
+                } else {
+                    fprintf(stderr, "错误：-d 或 --description 需要一个参数\n");
+                    showUsage();
+                    result = ERR_CONFIG;
+                    goto cleanup;
+                }
+            } else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--prerelease") == 0) {
+                is_prerelease = 1;
+            } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+                int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+                if (concurrency < 0) {
+                    fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                    showUsage();
+                    result = ERR_CONFIG;
+                    goto cleanup;
+                }
+                config.concurrency = concurrency;
+                i++; // 跳过下一个参数
+            } else if (strcmp(argv[i], "--deadline") == 0) {
+                double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+                if (deadline < 0) {
+                    fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                    showUsage();
+                    result = ERR_CONFIG;
+                    goto cleanup;
+                }
+                config.deadline = deadline;
+                i++; // 跳过下一个参数
+            } else if (strncmp(argv[i], "--checksums", 11) == 0 && (argv[i][11] == '\0' || argv[i][11] == '=')) {
+                int algorithms = parseChecksumAlgorithms(argv[i][11] == '=' ? argv[i] + 12 : NULL);
+                if (algorithms < 0) {
+                    fprintf(stderr, "错误：--checksums 只支持 sha256 和 blake2b\n");
+                    showUsage();
+                    result = ERR_CONFIG;
+                    goto cleanup;
+                }
+                checksum_set.algorithms = algorithms;
+                config.checksums = &checksum_set;
+            } else {
+                // 其余参数都是文件路径
+                file_argv_start = i;
+                break;
+            }
+        }
+
+        // 创建 Release
+        result = createRelease(tag_name, release_name, description, is_prerelease, &config, &new_release_id);
+
+        // 如果创建成功且有文件需要上传
+        if (result == ERR_OK && new_release_id && file_argv_start < argc) {
+            printf("\n准备上传文件到新创建的 Release...\n");
+
+            // 创建一个临时的配置对象，使用新的 release_id
+            Config upload_config = config;
+            upload_config.release_id = new_release_id;
+
+            // 处理所有文件模式
+            int totalFiles = 0;
+            char **allFiles = NULL;
+
+            for (int i = file_argv_start; i < argc; i++) {
+                char **matchedFiles = NULL;
+                int fileCount = expandWildcards(argv[i], &matchedFiles);
+
+                if (fileCount > 0) {
+                    char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
+                    if (!newAllFiles) {
+                        fprintf(stderr, "内存分配失败\n");
+                        result = ERR_MEMORY;
+                        // 清理已分配的文件名
+                        if (allFiles) {
+                            for (int j = 0; j < totalFiles; j++) {
+                                free(allFiles[j]);
+                            }
+                            free(allFiles);
+                        }
+                        for (int j = 0; j < fileCount; j++) {
+                            free(matchedFiles[j]);
+                        }
+                        free(matchedFiles);
+                        free(new_release_id);
+                        goto cleanup;
+                    }
+                    allFiles = newAllFiles;
+
+                    for (int j = 0; j < fileCount; j++) {
+                        allFiles[totalFiles++] = matchedFiles[j];
+                    }
+                    free(matchedFiles);
+                }
+            }
+
+            if (totalFiles == 0) {
+                fprintf(stderr, "错误：找不到匹配的文件\n");
+                result = ERR_FILE_IO;
+            } else {
+                result = uploadMultipleFiles(totalFiles, allFiles, &upload_config);
+                if (upload_config.checksums) {
+                    ErrorCode sumsResult = publishChecksums(&upload_config);
+                    if (result == ERR_OK) result = sumsResult;
+                }
+            }
+
+            // 清理文件列表
+            if (allFiles) {
+                for (int i = 0; i < totalFiles; i++) {
+                    free(allFiles[i]);
+                }
+                free(allFiles);
+            }
+
+            free(new_release_id);
+        } else if (new_release_id) {
+            free(new_release_id);
+        }
+    } else {
+        fprintf(stderr, "错误：未知命令 \"%s\"。\n", command);
+        showUsage();
+        result = ERR_CONFIG;
+    }
+
+cleanup:
+    stopChecksumWorker();
+    freeChecksumSet(&checksum_set);
+
+    if (resolvedReleaseId && usedRelease && result == ERR_OK) {
+        *resolvedReleaseId = config.release_id;
+        config.release_id = NULL;
+    }
+    free(config.release_id);
+
+    if (metricsPath) {
+        ErrorCode metricsResult = writeMetricsReport(metricsPath);
+        if (result == ERR_OK) result = metricsResult;
+        freeMetrics();
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "错误：请提供命令和参数。\n");
+        showUsage();
+        return 1;
+    }
+
+    // 设置了 MANAGE_SOCKET 时把命令交给 manage serve 守护进程执行，守护进程没有运行时在本进程中执行
+    const char *socketPath = getenv("MANAGE_SOCKET");
+    if (socketPath && *socketPath && strcmp(argv[1], "serve") != 0 && strcmp(argv[1], "help") != 0) {
+        int exitCode = 1;
+        ErrorCode forwarded = forwardToDaemon(socketPath, argc - 1, argv + 1, &exitCode);
+        if (forwarded == ERR_OK) {
+            return exitCode;
+        }
+        if (forwarded != ERR_NOT_FOUND) {
+            return 1;
+        }
+        log_warn("无法连接守护进程 %s，在本进程中执行", socketPath);
+    }
+
+    Config config = {0};
+    ReleaseCache release_cache = {0};
+    CommandScratch scratch = {0};
+    config.release_cache = &release_cache;
+    config.scratch = &scratch;
+    // 显式初始化标记位
+    config.owner_allocated = 0;
+    config.repo_allocated = 0;
+    config.token_allocated = 0;
+
+    if (getConfig(&config) != ERR_OK) {
+        return 1;
+    }
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    initHttpPool();
+
+    // 初始化随机数生成器（用于重试机制的随机抖动）
+    srand(time(NULL));
+
+    ErrorCode result;
+    if (strcmp(argv[1], "serve") == 0) {
+        result = serveJobs(argc - 2, argv + 2, &config);
+    } else {
+        result = runCommand(argc, argv, &config, NULL);
+    }
+
+    // 清理 Release 元数据缓存和临时内存
+    releaseCacheClear(&release_cache);
+    freeCommandScratch(&scratch);
+
+    // 清理字符串配置（使用标记位判断）
+    if (config.owner_allocated && config.owner) {
+        free((void *)config.owner);
+        config.owner = NULL;
+    }
+    if (config.repo_allocated && config.repo) {
+        free((void *)config.repo);
+        config.repo = NULL;
+    }
+    if (config.token_allocated && config.token) {
+        free((void *)config.token);
+        config.token = NULL;
+    }
+    free(config.api_base);
+    free(config.upload_base);
+
+    cleanupHttpPool();
+    curl_global_cleanup();
+
+    // 将 ErrorCode 转换为 main 的返回值
+    return (result == ERR_OK) ? 0 : 1;
+}
+
+// ==================== 重试机制实现 ====================
+
+// 执行一次阻塞请求，并记录结果供重试策略使用
+static CURLcode performRequest(CURL *curl) {
+    CURLcode res = curl_easy_perform(curl);
+    recordRequestStatus(&last_request_status, curl, res);
+    metricsRecordRequest(curl, res, request_label, request_failures + 1);
+    return res;
+}
+
+// 记录请求的 curl 结果和 HTTP 状态码
+static void recordRequestStatus(RequestStatus *status, CURL *curl, CURLcode res) {
+    status->curl_code = res;
+    status->http_status = 0;
+    status->transient = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status->http_status);
+}
+
+// 按操作剩余的时间设置请求超时，deadline 为 0 时不限制
+static void applyRequestDeadline(CURL *curl, double deadline) {
+    if (deadline <= 0) {
+        return;
+    }
+    long remainingMs = (long)((deadline - monotonicSeconds()) * 1000);
+    // 0 在 curl 中表示不限时，时间已用完时也至少给 1 毫秒，让请求立即超时
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, remainingMs > 0 ? remainingMs : 1L);
+}
+
+// 网络层的瞬时故障，重新连接通常就能恢复
+static int isTransientCurlError(CURLcode code) {
+    switch (code) {
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// 判断哪些错误需要重试：只重试服务端过载、限流和网络瞬时故障，
+// 4xx（认证失败、资源不存在、名称冲突等）重试也不会成功
+static int shouldRetryError(ErrorCode error, const RequestStatus *status) {
+    switch (error) {
+        case ERR_CURL_PERFORM:
+            // 没有记录到 curl 结果时无法判断原因，按瞬时故障处理；curl 成功时只有调用者
+            // 明确标记为瞬时的失败才重试
+            return !status || status->transient || isTransientCurlError(status->curl_code);
+        case ERR_HTTP_ERROR: {
+            long code = status ? status->http_status : 0;
+            if (code == 0 || code == 408 || code == 429) {
+                return 1;
+            }
+            if (code == 403) {
+                // GitHub 用 403 表示超出速率限制，此时限流器已经记录了等待时间
+                return rateLimitDelay() > 0;
+            }
+            return code >= 500 && code != 501;
+        }
+        default:
+            // 其他错误（配置错误、文件IO错误等）不需要重试
+            return 0;
+    }
+}
+
+// 去相关抖动（decorrelated jitter）退避：在 [base, 上一次等待 * 3] 之间随机取值，
+// 比固定指数退避更能把同时失败的请求错开
+static long computeRetryDelayMs(long previousMs) {
+    if (previousMs < RETRY_BASE_MS) {
+        previousMs = RETRY_BASE_MS;
+    }
+    long upper = previousMs * 3;
+    if (upper > RETRY_CAP_MS) {
+        upper = RETRY_CAP_MS;
+    }
+    double unit = (double)rand() / ((double)RAND_MAX + 1.0);
+    return RETRY_BASE_MS + (long)(unit * (double)(upper - RETRY_BASE_MS + 1));
+}
+
+// 开始一个新操作，deadlineSeconds 为 0 时不限时
+static void initRetryState(RetryState *state, double deadlineSeconds) {
+    state->attempts = 0;
+    state->rate_limited = 0;
+    state->delay_ms = 0;
+    state->deadline = deadlineSeconds > 0 ? monotonicSeconds() + deadlineSeconds : 0;
+}
+
+// 一次尝试失败后决定是否重试。需要重试时返回 ERR_OK，out_wait 为重试前应等待的秒数
+// （被限流时为 0，由 rateLimitAcquire 等到允许的时间）；否则返回操作的最终错误码。
+// 请求本身被速率限制拒绝（403/429）时只计入 rate_limited，不占用重试次数，
+// 等待的时间也不计入操作时限：遵守了 Retry-After 的请求不应因此失败
+static ErrorCode planRetry(RetryState *state, ErrorCode error, const RequestStatus *status,
+                           int maxRetries, const char *opName, double *out_wait) {
+    *out_wait = 0;
+    if (!shouldRetryError(error, status)) {
+        return error;
+    }
+
+    double limited = rateLimitDelay();
+    double wait = limited;
+    if (limited > 0 && status && (status->http_status == 429 || status->http_status == 403)) {
+        state->rate_limited++;
+        if (state->rate_limited > MAX_RATE_LIMIT_WAITS) {
+            log_error("%s 被速率限制拒绝 %d 次，不再重试", opName, state->rate_limited);
+            return ERR_RETRY_EXHAUSTED;
+        }
+        if (state->deadline > 0) {
+            state->deadline += limited;
+        }
+    } else {
+        state->attempts++;
+        if (state->attempts > maxRetries) {
+            log_error("%s 在 %d 次尝试后仍然失败", opName, state->attempts);
+            return ERR_RETRY_EXHAUSTED;
+        }
+        if (limited <= 0) {
+            state->delay_ms = computeRetryDelayMs(state->delay_ms);
+            wait = (double)state->delay_ms / 1000.0;
+        }
+    }
+    if (state->deadline > 0 && monotonicSeconds() + wait >= state->deadline) {
+        log_error("%s 失败，已超过操作时限，不再重试", opName);
+        return ERR_DEADLINE;
+    }
+
+    char reason[64];
+    if (error == ERR_CURL_PERFORM && status && status->curl_code != CURLE_OK) {
+        snprintf(reason, sizeof(reason), "%s", curl_easy_strerror(status->curl_code));
+    } else if (status && status->http_status > 0) {
+        snprintf(reason, sizeof(reason), "HTTP %ld", status->http_status);
+    } else {
+        snprintf(reason, sizeof(reason), "错误码 %d", error);
+    }
+
+    if (limited > 0) {
+        log_warn("%s 失败 (%s): 触发速率限制，%.0f 秒后重试...", opName, reason, limited);
+    } else {
+        log_warn("%s 失败 (%s)，%.1f 秒后重试...", opName, reason, wait);
+        *out_wait = wait;
+    }
+    return ERR_OK;
+}
+
+// 核心重试逻辑：deadlineSeconds 限制整个操作（含全部重试）的耗时，0 表示不限
+static ErrorCode performWithRetry(ErrorCode (*operation)(const void *), const void *param,
+                                  int maxRetries, double deadlineSeconds, const char *opName) {
+    RetryState state;
+    initRetryState(&state, deadlineSeconds);
+
+    // 操作内部的每个请求都按剩余时间设置超时，并在指标中归到该操作名下
+    double savedDeadline = request_deadline;
+    const char *savedLabel = request_label;
+    int savedFailures = request_failures;
+    request_deadline = state.deadline;
+    request_label = opName;
+
+    ErrorCode result;
+    for (;;) {
+        log_debug("尝试 %s (尝试 %d/%d)", opName, state.attempts + 1, maxRetries + 1);
+
+        last_request_status.http_status = 0;
+        last_request_status.curl_code = CURLE_OK;
+        last_request_status.transient = 0;
+        request_failures = state.attempts;
+        ErrorCode lastError = operation(param);
+
+        if (lastError == ERR_OK) {
+            // 操作成功
+            if (state.attempts > 0) {
+                log_info("%s 在第 %d 次尝试后成功", opName, state.attempts + 1);
+            }
+            result = ERR_OK;
+            break;
+        }
+
+        double wait = 0;
+        result = planRetry(&state, lastError, &last_request_status, maxRetries, opName, &wait);
+        if (result != ERR_OK) {
+            break;
+        }
+        if (wait > 0) {
+            usleep((useconds_t)(wait * 1e6));
+        }
+    }
+
+    request_deadline = savedDeadline;
+    request_label = savedLabel;
+    request_failures = savedFailures;
+    return result;
+}
+
+// 带重试的操作包装器
+static ErrorCode retryableOperationWrapper(const void *param) {
+    const RetryWrapperParam *wrapperParam = (const RetryWrapperParam *)param;
+    return wrapperParam->operation(wrapperParam->param1, wrapperParam->config);
+}
+
+// 重试包装函数：上传文件
+static ErrorCode uploadFileWithRetry(const char *filePath, const Config *config, int maxRetries) {
+    RetryWrapperParam param = {
+        .operation = uploadFile,
+        .param1 = filePath,
+        .config = config,
+        .opName = "文件上传"
+    };
+    const char *fileName = uploadAssetName(config, getFilenameFromPath(filePath));
+    log_info("开始上传文件: %s (最多重试 %d 次)", fileName, maxRetries);
+    return performWithRetry(retryableOperationWrapper, &param, maxRetries, config->deadline, fileName);
+}
+
+// 重试包装函数：删除文件
+static ErrorCode deleteFileWithRetry(const char *fileName, const Config *config, int maxRetries) {
+    RetryWrapperParam param = {
+        .operation = deleteFile,
+        .param1 = fileName,
+        .config = config,
+        .opName = "文件删除"
+    };
+    log_info("开始删除文件: %s (最多重试 %d 次)", fileName, maxRetries);
+    return performWithRetry(retryableOperationWrapper, &param, maxRetries, config->deadline, fileName);
+}
+
+// 重试包装函数：更新文件
+static ErrorCode updateFileWithRetry(const char *filePath, const Config *config, int maxRetries) {
+    RetryWrapperParam param = {
+        .operation = updateFile,
+        .param1 = filePath,
+        .config = config,
+        .opName = "文件更新"
+    };
+    const char *fileName = uploadAssetName(config, getFilenameFromPath(filePath));
+    log_info("开始更新文件: %s (最多重试 %d 次)", fileName, maxRetries);
+    return performWithRetry(retryableOperationWrapper, &param, maxRetries, config->deadline, fileName);
+}
+
+// 创建新的 GitHub Release，返回新创建的 release_id（动态分配）
+static ErrorCode createRelease(const char *tag_name, const char *release_name, const char *description,
+                               int is_prerelease, const Config *config, char **out_release_id) {
+    // 验证配置（跳过 release_id 检查，因为创建 release 时 release_id 还未生成）
+    if (!config) {
+        log_error("配置为空");
+        return ERR_CONFIG;
+    }
+
+    if (!config->token) {
+        log_error("未设置 token");
+        return ERR_CONFIG;
+    }
+
+    if (!config->owner) {
+        log_error("未设置 owner");
+        return ERR_CONFIG;
+    }
+
+    if (!config->repo) {
+        log_error("未设置 repo");
+        return ERR_CONFIG;
+    }
+
+    if (!tag_name) {
+        log_error("tag_name 不能为空");
+        return ERR_CONFIG;
+    }
+
+    CURL *curl = NULL;
+    struct curl_slist *headers = NULL;
+    ResponseBuffer *chunk = NULL;
+    struct json_object *json_request = NULL;
+    struct json_object *response = NULL;
+    char *url = NULL;
+    char *post_data = NULL;
+    ErrorCode result = ERR_OK;
+
+    // 构建请求体
+    json_request = json_object_new_object();
+    if (!json_request) {
+        log_error("创建 JSON 对象失败");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    json_object_object_add(json_request, "tag_name", json_object_new_string(tag_name));
+
+    // 如果提供了 release_name，则使用它，否则使用 tag_name
+    if (release_name && strlen(release_name) > 0) {
+        json_object_object_add(json_request, "name", json_object_new_string(release_name));
+    } else {
+        json_object_object_add(json_request, "name", json_object_new_string(tag_name));
+    }
+
+    // 添加描述
+    if (description && strlen(description) > 0) {
+        json_object_object_add(json_request, "body", json_object_new_string(description));
+    } else {
+        json_object_object_add(json_request, "body", json_object_new_string("Release created by manage tool"));
+    }
+
+    // 是否为预发布
+    json_object_object_add(json_request, "prerelease", json_object_new_boolean(is_prerelease));
+
+    // 设置为公开或私有（默认公开）
+    json_object_object_add(json_request, "draft", json_object_new_boolean(0));
+
+    // 获取 JSON 字符串
+    const char *json_str = json_object_to_json_string(json_request);
+    if (!json_str) {
+        log_error("生成 JSON 字符串失败");
+        result = ERR_JSON_PARSE;
+        goto cleanup;
+    }
+
+    // 复制 JSON 字符串以便 curl 使用
+    post_data = strdup(json_str);
+    if (!post_data) {
+        log_error("内存分配失败");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    // 创建 URL
+    url = create_url(commandArena(config), "%s/repos/%s/%s/releases", config->api_base, config->owner,
+                     config->repo);
+    if (!url) {
+        log_error("URL 分配失败");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    curl = acquireCurlHandle();
+    if (!curl) {
+        log_error("初始化 CURL 失败");
+        result = ERR_CURL_INIT;
+        goto cleanup;
+    }
+
+    headers = setGithubHeaders(commandArena(config), config->token, "application/json");
+
+    chunk = scratchResponse(config);
+    if (!chunk) {
+        log_error("内存分配失败");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    // 设置 POST 数据
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(post_data));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)chunk);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+
+    printf("正在创建新的 Release，标签: %s...\n", tag_name);
+
+    CURLcode res = performRequest(curl);
+    if (res != CURLE_OK) {
+        fprintf(stderr, "创建 Release 失败: %s\n", curl_easy_strerror(res));
+        result = ERR_CURL_PERFORM;
+        goto cleanup;
+    }
+
+    // 检查 HTTP 响应码
+    long response_code;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        log_error("创建 Release 失败，HTTP错误: %ld", response_code);
+        log_error("响应内容: %s", chunk->data);
+        rateLimitObserveBody(response_code, chunk->data);
+        result = ERR_HTTP_ERROR;
+        goto cleanup;
+    }
+
+    // 解析响应以获取新创建的 Release 信息
+    response = json_tokener_parse(chunk->data);
+    if (!response) {
+        log_error("解析创建 Release 的响应失败");
+        result = ERR_JSON_PARSE;
+        goto cleanup;
+    }
+
+    struct json_object *id_obj;
+    if (!json_object_object_get_ex(response, "id", &id_obj) ||
+        !json_object_is_type(id_obj, json_type_int)) {
+        log_error("无法从响应中获取 release id");
+        result = ERR_JSON_TYPE;
+        goto cleanup;
+    }
+
+    int id_value = json_object_get_int(id_obj);
+    struct json_object *tag_obj;
+    const char *created_tag = tag_name;
+    if (json_object_object_get_ex(response, "tag_name", &tag_obj) &&
+        json_object_is_type(tag_obj, json_type_string)) {
+        created_tag = json_object_get_string(tag_obj);
+    }
+
+    char temp_id[32];
+    snprintf(temp_id, sizeof(temp_id), "%d", id_value);
+
+    // 创建响应就是完整的 Release 对象，直接填充缓存，后续上传无需再查询
+    if (config->release_cache) {
+        releaseCacheLoadJson(config->release_cache, temp_id, response);
+    }
+
+    // 将 release_id 返回给调用者
+    if (out_release_id) {
+        *out_release_id = strdup(temp_id);
+        if (!*out_release_id) {
+            log_error("内存分配失败");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    printf("✅ Release 创建成功!\n");
+    printf("   - 标签: %s\n", created_tag);
+    printf("   - ID: %d\n", id_value);
+
+cleanup:
+    if (response) json_object_put(response);
+    if (post_data) free(post_data);
+    if (json_request) json_object_put(json_request);
+    if (headers) curl_slist_free_all(headers);
+    if (curl) releaseCurlHandle(curl);
+
+    return result;
+}
+
+// ==================== 并发请求驱动 ====================
+
+// 在一个 multi 句柄上执行一组相互独立的请求，同时最多 ops->concurrency 个。受速率限制时暂不发出
+// 新请求，失败的请求按 planRetry 的策略在 notBefore 之后重新排队；请求的内容和结果的处理由回调决定。
+// 只有 multi 本身出错或 done 要求中止时返回错误，单个请求的结果由 done 记录
+static ErrorCode runMultiRequests(const MultiRequestOps *ops) {
+    int concurrency = ops->concurrency > 0 ? ops->concurrency : 1;
+    int active = 0;
+    int firstPending = 0;
+    ErrorCode result = ERR_OK;
+
+    CURLM *multi = curl_multi_init();
+    if (!multi) {
+        fprintf(stderr, "初始化 CURL multi 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    for (;;) {
+        int count = ops->count(ops->ctx);
+        double now = monotonicSeconds();
+        double nextWake = 0;
+
+        while (firstPending < count && ops->request(ops->ctx, firstPending)->state != REQUEST_PENDING) {
+            firstPending++;
+        }
+        if (firstPending >= count && active == 0) {
+            break;
+        }
+
+        for (int i = firstPending; i < count && active < concurrency; i++) {
+            MultiRequest *req = ops->request(ops->ctx, i);
+            if (req->state != REQUEST_PENDING) continue;
+
+            // 受速率限制时暂不发出新请求，已在进行的请求不受影响
+            double limited = rateLimitDelay();
+            if (limited > 0) {
+                if (nextWake == 0 || now + limited < nextWake) {
+                    nextWake = now + limited;
+                }
+                break;
+            }
+            if (req->notBefore > now) {
+                if (nextWake == 0 || req->notBefore < nextWake) {
+                    nextWake = req->notBefore;
+                }
+                continue;
+            }
+
+            CURL *curl = NULL;
+            req->index = i;
+            ErrorCode startResult = ops->start(multi, req->item, ops->ctx, &curl);
+            if (startResult == ERR_OK) {
+                curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)req);
+                req->state = REQUEST_ACTIVE;
+                active++;
+                continue;
+            }
+
+            // 本地错误（内存不足、文件读取失败等）不进入重试
+            ops->release(multi, req->item);
+            req->state = REQUEST_DONE;
+            result = ops->done(req->item, startResult, ops->ctx);
+            if (result != ERR_OK) goto cleanup;
+        }
+
+        if (active == 0) {
+            // 剩余的请求都在等待重试
+            if (nextWake > now) {
+                usleep((useconds_t)((nextWake - now) * 1e6));
+            }
+            continue;
+        }
+
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc != CURLM_OK) {
+            fprintf(stderr, "curl_multi_perform 失败: %s\n", curl_multi_strerror(mc));
+            result = ERR_CURL_PERFORM;
+            goto cleanup;
+        }
+
+        CURLMsg *msg;
+        int msgsLeft = 0;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            // 槽位空出或请求重新排队，下一轮立即填充
+            nextWake = now;
+
+            MultiRequest *req = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&req);
+            CURLcode res = msg->data.result;
+
+            recordRequestStatus(&req->status, msg->easy_handle, res);
+            metricsRecordRequest(msg->easy_handle, res, req->label,
+                                 req->retry.attempts + req->retry.rate_limited + 1);
+            ErrorCode reqResult = ops->finish(req->item, res, ops->ctx);
+            ops->release(multi, req->item);
+            active--;
+
+            if (reqResult != ERR_OK) {
+                double wait = 0;
+                reqResult = planRetry(&req->retry, reqResult, &req->status, MAX_RETRIES, req->label, &wait);
+                if (reqResult == ERR_OK) {
+                    req->notBefore = monotonicSeconds() + wait;
+                    req->state = REQUEST_PENDING;
+                    if (req->index < firstPending) {
+                        firstPending = req->index;
+                    }
+                    continue;
+                }
+            } else if (req->retry.attempts > 0) {
+                log_info("%s 在第 %d 次尝试后成功", req->label, req->retry.attempts + 1);
+            }
+
+            req->state = REQUEST_DONE;
+            result = ops->done(req->item, reqResult, ops->ctx);
+            if (result != ERR_OK) goto cleanup;
+        }
+
+        // 等待网络事件；有请求等待重试时不要睡过头
+        int timeoutMs = 1000;
+        if (nextWake > 0) {
+            int untilWake = (int)((nextWake - monotonicSeconds()) * 1000) + 1;
+            if (untilWake < timeoutMs) timeoutMs = untilWake > 0 ? untilWake : 0;
+        }
+        curl_multi_poll(multi, NULL, 0, timeoutMs, NULL);
+    }
+
+cleanup:
+    // 中止时释放仍在进行的请求
+    for (int i = 0, count = ops->count(ops->ctx); i < count; i++) {
+        MultiRequest *req = ops->request(ops->ctx, i);
+        if (req->state == REQUEST_ACTIVE) {
+            ops->release(multi, req->item);
+            req->state = REQUEST_PENDING;
+        }
+    }
+    curl_multi_cleanup(multi);
+    return result;
+}
+
+// ==================== 并发上传引擎 ====================
+
+// 单调时钟（秒），用于计算重试等待时间
+static double monotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// 解析并发数参数，无效时返回 -1
+static int parseConcurrency(const char *value) {
+    if (!value || !*value) {
+        return -1;
+    }
+
+    char *end = NULL;
+    errno = 0;
+    long n = strtol(value, &end, 10);
+    if (errno != 0 || *end != '\0' || n < 1 || n > MAX_CONCURRENCY) {
+        return -1;
+    }
+    return (int)n;
+}
+
+// 解析操作时限（秒，可带小数，0 表示不限），无效时返回 -1
+static double parseDeadline(const char *value) {
+    if (!value || !*value) {
+        return -1;
+    }
+
+    char *end = NULL;
+    errno = 0;
+    double seconds = strtod(value, &end);
+    if (errno != 0 || *end != '\0' || !(seconds >= 0) || seconds > 86400.0 * 365) {
+        return -1;
+    }
+    return seconds;
+}
+
+// 上传任务状态
+typedef enum {
+    UPLOAD_PENDING = 0,
+    UPLOAD_DELETING,     // 正在删除同名旧资产（update）
+    UPLOAD_COMPRESSING,  // 后台线程正在压缩（--compress）
+    UPLOAD_ACTIVE,
+    UPLOAD_DONE
+} UploadTaskState;
+
+// 单个文件的上传任务
+typedef struct {
+    const char *filePath;
+    const char *fileName;
+    const Config *config;       // 文件所属的仓库和 Release（apply 时每个任务可以不同）
+    UploadTaskState state;
+    CURL *curl;
+    struct curl_slist *headers;
+    ResponseBuffer response;    // 每次尝试前重置，复用同一块内存
+    char *uploadUrl;            // 从命令 arena 分配
+    UploadSource source;
+    curl_off_t partOffset;       // --split 的分片在文件中的位置和大小，partSize 为 0 时上传整个文件
+    curl_off_t partSize;
+    long long replaceAssetId;    // 上传前需要删除的同名资产，0 表示无需删除
+    TransferProgress progress;
+    MultiRequest req;    // 重试状态；req.state 只在批量删除（runMultiRequests）时使用，上传引擎用 state
+    ErrorCode result;
+    int index;           // 在任务列表中的位置
+} UploadTask;
+
+// 释放一次上传尝试占用的 curl 资源（文件保持打开供重试使用）
+static void releaseUploadAttempt(CURLM *multi, UploadTask *task) {
+    uploadRateRelease(&task->source);
+    progressDetach(&task->progress);
+    if (task->curl) {
+        curl_multi_remove_handle(multi, task->curl);
+        releaseCurlHandle(task->curl);
+        task->curl = NULL;
+    }
+    if (task->headers) {
+        curl_slist_free_all(task->headers);
+        task->headers = NULL;
+    }
+    responseBufferReset(&task->response);
+}
+
+// 释放上传任务的全部资源
+static void freeUploadTask(CURLM *multi, UploadTask *task) {
+    releaseUploadAttempt(multi, task);
+    closeUploadSource(&task->source);
+    responseBufferFree(&task->response);
+}
+
+// 操作时限从文件的第一个请求（删除旧资产或上传）发出时开始计算，重试不会重新计时
+static void startTaskClock(UploadTask *task, const Config *config) {
+    if (config->deadline > 0 && task->req.retry.deadline == 0) {
+        task->req.retry.deadline = monotonicSeconds() + config->deadline;
+    }
+}
+
+// 计入总进度的大小：分片取分片大小，其余取文件当前的大小（读不到时为 0，上传时再报告错误）
+static curl_off_t uploadTaskPlannedSize(const UploadTask *task) {
+    struct stat st;
+    if (task->partSize > 0) {
+        return task->partSize;
+    }
+    return stat(task->filePath, &st) == 0 ? (curl_off_t)st.st_size : 0;
+}
+
+// 为上传任务创建 curl 句柄并加入 multi 事件循环
+static ErrorCode startUploadTask(CURLM *multi, UploadTask *task) {
+    const Config *config = task->config;
+
+    if (!task->uploadUrl) {
+        // 同一 Release 的上传地址模板已在缓存中，只有第一次取用时可能发出请求
+        const char *uploadUrlTemplate = NULL;
+        ErrorCode templateResult = getUploadUrlTemplate(config, &uploadUrlTemplate);
+        if (templateResult != ERR_OK) {
+            return templateResult;
+        }
+        task->uploadUrl = buildUploadUrl(commandArena(config), uploadUrlTemplate, task->fileName);
+        if (!task->uploadUrl) {
+            fprintf(stderr, "内存分配失败\n");
+            return ERR_MEMORY;
+        }
+    }
+
+    if (task->source.fd < 0) {
+        ErrorCode openResult = task->partSize > 0
+            ? openUploadRange(&task->source, task->filePath, NULL, task->partOffset, task->partSize)
+            : openUploadSource(&task->source, task->filePath, config->compression);
+        if (openResult != ERR_OK) {
+            return openResult;
+        }
+        attachUploadHasher(config, &task->source);
+    }
+
+    responseBufferReset(&task->response);
+    if (responseBufferReserve(&task->response, 0) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    task->curl = acquireCurlHandle();
+    if (!task->curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    task->headers = setGithubHeaders(commandArena(config), config->token, "application/octet-stream");
+    if (!task->headers) {
+        fprintf(stderr, "添加header失败\n");
+        return ERR_MEMORY;
+    }
+
+    setUploadOptions(task->curl, task->uploadUrl, task->headers, &task->source, &task->response);
+    progressAttach(task->curl, &task->progress, task->fileName, task->source.size);
+    task->source.pausable = 1;
+    curl_easy_setopt(task->curl, CURLOPT_PRIVATE, (void *)task);
+    startTaskClock(task, config);
+    applyRequestDeadline(task->curl, task->req.retry.deadline);
+
+    if (curl_multi_add_handle(multi, task->curl) != CURLM_OK) {
+        fprintf(stderr, "添加传输任务失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    log_debug("开始上传 %s (%" CURL_FORMAT_CURL_OFF_T " bytes，第 %d 次尝试)", task->fileName,
+              task->source.size, task->req.retry.attempts + 1);
+    task->state = UPLOAD_ACTIVE;
+    return ERR_OK;
+}
+
+// 检查已完成传输的结果
+static ErrorCode finishUploadTask(UploadTask *task, CURLcode res, long *assetId) {
+    const Config *config = task->config;
+    *assetId = 0;
+
+    if (res != CURLE_OK) {
+        fprintf(stderr, "上传文件 \"%s\" 失败: %s\n", task->fileName, curl_easy_strerror(res));
+        return ERR_CURL_PERFORM;
+    }
+
+    long response_code = 0;
+    curl_easy_getinfo(task->curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        fprintf(stderr, "上传文件 \"%s\" 失败，HTTP错误: %ld\n", task->fileName, response_code);
+        rateLimitObserveBody(response_code, task->response.data);
+        return ERR_HTTP_ERROR;
+    }
+
+    if (recordUploadChecksum(config, &task->source, task->filePath, task->fileName) != ERR_OK) {
+        log_warn("无法记录 %s 的校验和", task->fileName);
+    }
+
+    struct json_object *uploadResponse = json_tokener_parse(task->response.data);
+    if (uploadResponse) {
+        struct json_object *id;
+        if (json_object_object_get_ex(uploadResponse, "id", &id)) {
+            *assetId = (long)json_object_get_int64(id);
+        }
+        releaseCacheAddAsset(config->release_cache, uploadResponse);
+        uploadJournalComplete(config->journal, task->fileName, *assetId);
+        json_object_put(uploadResponse);
+    }
+
+    return ERR_OK;
+}
+
+// 发起删除旧资产的请求（update 时在上传前执行）
+static ErrorCode startDeleteTask(CURLM *multi, UploadTask *task) {
+    const Config *config = task->config;
+    char *url = create_url(commandArena(config), "%s/repos/%s/%s/releases/assets/%lld",
+                           config->api_base, config->owner, config->repo, task->replaceAssetId);
+    if (!url) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    responseBufferReset(&task->response);
+    if (responseBufferReserve(&task->response, 0) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    task->curl = acquireCurlHandle();
+    if (!task->curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    task->headers = setGithubHeaders(commandArena(config), config->token, NULL);
+    if (!task->headers) {
+        fprintf(stderr, "添加header失败\n");
+        return ERR_MEMORY;
+    }
+
+    curl_easy_setopt(task->curl, CURLOPT_URL, url);
+    curl_easy_setopt(task->curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    curl_easy_setopt(task->curl, CURLOPT_HTTPHEADER, task->headers);
+    curl_easy_setopt(task->curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(task->curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(task->curl, CURLOPT_WRITEDATA, (void *)&task->response);
+    curl_easy_setopt(task->curl, CURLOPT_PRIVATE, (void *)task);
+    startTaskClock(task, config);
+    applyRequestDeadline(task->curl, task->req.retry.deadline);
+
+    if (curl_multi_add_handle(multi, task->curl) != CURLM_OK) {
+        fprintf(stderr, "添加传输任务失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    log_debug("删除旧资产 %s (ID: %lld)", task->fileName, task->replaceAssetId);
+    task->state = UPLOAD_DELETING;
+    return ERR_OK;
+}
+
+// 检查删除请求的结果；资产已不存在（404）也视为成功
+static ErrorCode finishDeleteTask(UploadTask *task, CURLcode res) {
+    if (res != CURLE_OK) {
+        fprintf(stderr, "删除旧文件 \"%s\" 失败: %s\n", task->fileName, curl_easy_strerror(res));
+        return ERR_CURL_PERFORM;
+    }
+
+    long response_code = 0;
+    curl_easy_getinfo(task->curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400 && response_code != 404) {
+        fprintf(stderr, "删除旧文件 \"%s\" 失败，HTTP错误: %ld\n", task->fileName, response_code);
+        rateLimitObserveBody(response_code, task->response.data);
+        return ERR_HTTP_ERROR;
+    }
+
+    releaseCacheRemove(task->config->release_cache, task->fileName);
+    task->replaceAssetId = 0;
+    return ERR_OK;
+}
+
+// 后台压缩任务（--compress）：在单独的线程中打开并压缩文件，与其他文件的上传并行进行，
+// 完成后唤醒 multi 事件循环
+typedef struct {
+    pthread_t thread;
+    UploadTask *task;            // NULL 表示空闲
+    const UploadCompression *compression;
+    CURLM *multi;
+    int done;
+    ErrorCode result;
+} CompressJob;
+
+static pthread_mutex_t compress_job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void* compressJobMain(void *arg) {
+    CompressJob *job = arg;
+    ErrorCode result = openUploadSource(&job->task->source, job->task->filePath, job->compression);
+
+    pthread_mutex_lock(&compress_job_lock);
+    job->result = result;
+    job->done = 1;
+    pthread_mutex_unlock(&compress_job_lock);
+    curl_multi_wakeup(job->multi);
+    return NULL;
+}
+
+// 在空闲的槽位上启动压缩线程
+static ErrorCode startCompressJob(CompressJob *jobs, int slots, UploadTask *task,
+                                  const UploadCompression *compression, CURLM *multi) {
+    for (int i = 0; i < slots; i++) {
+        CompressJob *job = &jobs[i];
+        if (job->task) continue;
+
+        job->task = task;
+        job->compression = compression;
+        job->multi = multi;
+        job->done = 0;
+        job->result = ERR_OK;
+        if (pthread_create(&job->thread, NULL, compressJobMain, job) != 0) {
+            job->task = NULL;
+            fprintf(stderr, "无法创建压缩线程\n");
+            return ERR_MEMORY;
+        }
+        log_debug("开始压缩 %s", task->fileName);
+        task->state = UPLOAD_COMPRESSING;
+        return ERR_OK;
+    }
+    return ERR_MEMORY;
+}
+
+// 回收已完成的压缩线程；wait 非 0 时等待所有线程结束（清理时使用）
+static UploadTask* reapCompressJob(CompressJob *jobs, int slots, int wait, ErrorCode *result) {
+    for (int i = 0; i < slots; i++) {
+        CompressJob *job = &jobs[i];
+        if (!job->task) continue;
+
+        pthread_mutex_lock(&compress_job_lock);
+        int done = job->done;
+        pthread_mutex_unlock(&compress_job_lock);
+        if (!done && !wait) continue;
+
+        pthread_join(job->thread, NULL);
+        UploadTask *task = job->task;
+        job->task = NULL;
+        *result = job->result;
+        return task;
+    }
+    return NULL;
+}
+
+// 上传任务列表；任务单独分配，列表扩容时地址不变
+typedef struct {
+    UploadTask **items;
+    int count;
+    int capacity;
+} UploadTaskList;
+
+// 在任务列表末尾追加一个上传到 config 所指 Release 的文件
+static UploadTask* appendUploadTask(UploadTaskList *list, const Config *config,
+                                    const char *filePath, const char *fileName) {
+    if (list->count >= list->capacity) {
+        int newCapacity = list->capacity ? list->capacity * 2 : 16;
+        UploadTask **grown = realloc(list->items, newCapacity * sizeof(UploadTask *));
+        if (!grown) return NULL;
+        list->items = grown;
+        list->capacity = newCapacity;
+    }
+
+    UploadTask *task = calloc(1, sizeof(UploadTask));
+    if (!task) return NULL;
+    task->filePath = filePath;
+    task->fileName = fileName;
+    task->config = config;
+    task->state = UPLOAD_PENDING;
+    task->source.fd = -1;
+    task->result = ERR_CURL_PERFORM;  // 引擎提前退出时，没有执行完的任务按失败统计
+    task->index = list->count;
+    list->items[list->count++] = task;
+    return task;
+}
+
+static void freeUploadTaskList(UploadTaskList *list) {
+    for (int i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+// 批量 update：任务上传前先删除 Release 中的同名资产。
+// 同名资产只删除一次（批次中重复的文件名由上传时的 422 报告）
+static void markReplacedAsset(UploadTaskList *list, const ReleaseCache *cache, UploadTask *task) {
+    ReleaseAsset *asset = releaseCacheFind(cache, task->fileName);
+    if (!asset) {
+        return;
+    }
+    for (int j = 0; j < task->index; j++) {
+        if (list->items[j]->replaceAssetId == asset->id) {
+            return;
+        }
+    }
+    task->replaceAssetId = asset->id;
+}
+
+// 上传引擎：在一个 multi 句柄上执行任务列表，同时最多 config->concurrency 个传输。
+// 任务各自带有所属的 Release（task->config），因此一批任务可以跨多个仓库和 Release，
+// 共用连接池、并发上限和限流状态。设置了 replaceAssetId 的任务先删除旧资产再上传。
+// walk 非 NULL 时扫描线程发现的文件陆续追加到 list，上传到 config 所指的 Release。
+// 结束时释放任务占用的连接和文件，任务本身由调用者释放
+static ErrorCode runUploadTasks(UploadTaskList *list, UploadWalk *walk, const Config *config,
+                                const char *verb) {
+    int walking = (walk != NULL);
+    CompressJob *compressJobs = NULL;
+    int compressing = 0;
+    CURLM *multi = NULL;
+    int success = 0;
+    int failed = 0;
+    int completed = 0;
+    int active = 0;
+    int deleting = 0;
+    int firstPending = 0;
+    int concurrency = config->concurrency;
+    ErrorCode result = ERR_OK;
+
+    if (!walk && list->count < concurrency) concurrency = list->count;
+    if (concurrency < 1) concurrency = 1;
+    if (config->compression) {
+        compressJobs = calloc(concurrency, sizeof(CompressJob));
+        if (!compressJobs) {
+            fprintf(stderr, "内存分配失败\n");
+            return ERR_MEMORY;
+        }
+    }
+    if (walk) {
+        printf("准备批量%s（并发数: %d），边扫描目录边%s...\n\n", verb, concurrency, verb);
+    } else {
+        printf("准备批量%s %d 个文件（并发数: %d）...\n\n", verb, list->count, concurrency);
+    }
+    uploadRateStart(config->limit_rate);
+    progressBegin(config, concurrency);
+    for (int i = 0; i < list->count; i++) {
+        progressPlan(&list->items[i]->progress, uploadTaskPlannedSize(list->items[i]));
+    }
+
+    multi = curl_multi_init();
+    if (!multi) {
+        fprintf(stderr, "初始化 CURL multi 失败\n");
+        result = ERR_CURL_INIT;
+        goto cleanup;
+    }
+    if (walk) {
+        uploadWalkAttach(walk, multi);
+    }
+
+    while (completed < list->count || walking) {
+        double now = monotonicSeconds();
+        double nextWake = 0;
+
+        // 取出扫描线程新发现的文件
+        if (walking) {
+            const char *path = NULL;
+            const char *name = NULL;
+            int next;
+            while ((next = uploadWalkNext(walk, &path, &name)) > 0) {
+                UploadTask *task = appendUploadTask(list, config, path, uploadAssetName(config, name));
+                if (!task) {
+                    fprintf(stderr, "内存分配失败\n");
+                    result = ERR_MEMORY;
+                    goto cleanup;
+                }
+                progressPlan(&task->progress, uploadTaskPlannedSize(task));
+            }
+            walking = (next == 0);
+        }
+
+        // 压缩完成的文件排队等待上传
+        UploadTask *compressed;
+        ErrorCode compressResult;
+        while (compressing > 0 &&
+               (compressed = reapCompressJob(compressJobs, concurrency, 0, &compressResult)) != NULL) {
+            compressing--;
+            if (compressResult == ERR_OK) {
+                attachUploadHasher(config, &compressed->source);
+                compressed->state = UPLOAD_PENDING;
+                if (compressed->index < firstPending) {
+                    firstPending = compressed->index;
+                }
+                continue;
+            }
+            freeUploadTask(multi, compressed);
+            progressFileDone(&compressed->progress, 0);
+            progressClear();
+            compressed->state = UPLOAD_DONE;
+            compressed->result = compressResult;
+            completed++;
+            failed++;
+            printf("[%d/%d] ❌ 文件 \"%s\" %s失败\n", completed, list->count, compressed->filePath, verb);
+        }
+
+        // 填满空闲的传输槽位
+        while (firstPending < list->count && list->items[firstPending]->state != UPLOAD_PENDING) {
+            firstPending++;
+        }
+        // 队首之后 lookahead 个文件内可以提前删除旧资产
+        int lookahead = 0;
+        int budgetFull = 0;
+        for (int i = firstPending; i < list->count && (active < concurrency || lookahead < concurrency); i++) {
+            UploadTask *task = list->items[i];
+            if (task->state != UPLOAD_PENDING) continue;
+
+            // 受速率限制时暂不发出新请求，已在进行的传输不受影响
+            double limited = rateLimitDelay();
+            if (limited > 0) {
+                if (nextWake == 0 || now + limited < nextWake) {
+                    nextWake = now + limited;
+                }
+                break;
+            }
+
+            if (task->req.notBefore > now) {
+                if (nextWake == 0 || task->req.notBefore < nextWake) {
+                    nextWake = task->req.notBefore;
+                }
+                continue;
+            }
+
+            ErrorCode startResult;
+            if (task->replaceAssetId) {
+                if (lookahead >= concurrency || deleting >= concurrency) {
+                    lookahead++;
+                    continue;
+                }
+                lookahead++;
+                startResult = startDeleteTask(multi, task);
+                if (startResult == ERR_OK) {
+                    deleting++;
+                    continue;
+                }
+            } else if (config->compression && task->source.fd < 0) {
+                // 先在后台压缩，压缩期间其他文件照常上传
+                if (lookahead >= concurrency || compressing >= concurrency || budgetFull) {
+                    lookahead++;
+                    continue;
+                }
+                lookahead++;
+                // 压缩内存超出预算时按顺序等前面的缓冲区释放，后面的小文件不能抢先
+                if (!task->source.budget && !compressBudgetTake(&task->source, uploadTaskPlannedSize(task))) {
+                    budgetFull = 1;
+                    continue;
+                }
+                startResult = startCompressJob(compressJobs, concurrency, task, config->compression, multi);
+                if (startResult == ERR_OK) {
+                    compressing++;
+                    continue;
+                }
+            } else {
+                if (active >= concurrency) {
+                    lookahead++;
+                    continue;
+                }
+                startResult = startUploadTask(multi, task);
+                if (startResult == ERR_OK) {
+                    active++;
+                    continue;
+                }
+            }
+
+            // 本地错误（文件读取失败等）不进入重试
+            freeUploadTask(multi, task);
+            progressFileDone(&task->progress, 0);
+            progressClear();
+            task->state = UPLOAD_DONE;
+            task->result = startResult;
+            completed++;
+            failed++;
+            printf("[%d/%d] ❌ 文件 \"%s\" %s失败\n", completed, list->count, task->filePath, verb);
+        }
+
+        if (active == 0 && deleting == 0) {
+            if (completed >= list->count && !walking) break;
+            if (walking || compressing > 0) {
+                // 等待扫描线程发现新文件或压缩完成，两者都会唤醒 multi
+                int timeoutMs = 1000;
+                if (nextWake > 0) {
+                    int untilWake = (int)((nextWake - now) * 1000) + 1;
+                    if (untilWake < timeoutMs) timeoutMs = untilWake > 0 ? untilWake : 0;
+                }
+                curl_multi_poll(multi, NULL, 0, timeoutMs, NULL);
+            } else if (nextWake > now) {
+                // 所有剩余任务都在等待重试
+                usleep((useconds_t)((nextWake - now) * 1e6));
+            }
+            continue;
+        }
+
+        // 限速令牌补足后恢复暂停的传输，按队列顺序，排在前面的文件先拿到令牌
+        if (uploadRatePaused() > 0) {
+            double wait = uploadRateWait();
+            if (wait <= 0) {
+                for (int i = 0; i < list->count; i++) {
+                    UploadTask *task = list->items[i];
+                    if (task->state == UPLOAD_ACTIVE && task->source.paused) {
+                        uploadRateRelease(&task->source);
+                        curl_easy_pause(task->curl, CURLPAUSE_CONT);
+                    }
+                }
+            } else if (nextWake == 0 || now + wait < nextWake) {
+                nextWake = now + wait;
+            }
+        }
+
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc != CURLM_OK) {
+            fprintf(stderr, "curl_multi_perform 失败: %s\n", curl_multi_strerror(mc));
+            result = ERR_CURL_PERFORM;
+            goto cleanup;
+        }
+
+        CURLMsg *msg;
+        int msgsLeft = 0;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            // 槽位空出或任务重新排队，下一轮立即填充，不在 poll 中空等
+            nextWake = now;
+            // 接下来可能打印结果或错误，先清除进度行
+            progressClear();
+
+            UploadTask *task = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&task);
+            CURLcode res = msg->data.result;
+            long assetId = 0;
+            ErrorCode taskResult;
+
+            recordRequestStatus(&task->req.status, msg->easy_handle, res);
+            metricsRecordRequest(msg->easy_handle, res, task->fileName,
+                                 task->req.retry.attempts + task->req.retry.rate_limited + 1);
+            if (task->state == UPLOAD_DELETING) {
+                taskResult = finishDeleteTask(task, res);
+                releaseUploadAttempt(multi, task);
+                deleting--;
+                if (taskResult == ERR_OK) {
+                    // 旧资产已删除，排队等待上传
+                    task->state = UPLOAD_PENDING;
+                    if (task->index < firstPending) {
+                        firstPending = task->index;
+                    }
+                    continue;
+                }
+            } else {
+                taskResult = finishUploadTask(task, res, &assetId);
+                releaseUploadAttempt(multi, task);
+                active--;
+            }
+
+            if (taskResult == ERR_OK) {
+                if (task->req.retry.attempts > 0) {
+                    log_info("%s 在第 %d 次尝试后成功", task->fileName, task->req.retry.attempts + 1);
+                }
+                freeUploadTask(multi, task);
+                progressFileDone(&task->progress, 1);
+                task->state = UPLOAD_DONE;
+                task->result = ERR_OK;
+                completed++;
+                success++;
+                printf("[%d/%d] ✅ 文件 \"%s\" %s成功 (Asset ID: %ld)\n",
+                       completed, list->count, task->fileName, verb, assetId);
+                continue;
+            }
+
+            double wait = 0;
+            taskResult = planRetry(&task->req.retry, taskResult, &task->req.status, MAX_RETRIES,
+                                   task->fileName, &wait);
+            if (taskResult == ERR_OK) {
+                // 被限流时 wait 为 0，启动前的限流检查会推迟任务
+                task->req.notBefore = monotonicSeconds() + wait;
+                task->state = UPLOAD_PENDING;
+                if (task->index < firstPending) {
+                    firstPending = task->index;
+                }
+                continue;
+            }
+
+            freeUploadTask(multi, task);
+            progressFileDone(&task->progress, 0);
+            task->state = UPLOAD_DONE;
+            task->result = taskResult;
+            completed++;
+            failed++;
+            printf("[%d/%d] ❌ 文件 \"%s\" %s失败\n", completed, list->count, task->filePath, verb);
+        }
+        if (completed >= list->count && !walking) break;
+
+        // 等待网络事件；有任务等待重试时不要睡过头
+        int timeoutMs = 1000;
+        if (nextWake > 0) {
+            int untilWake = (int)((nextWake - monotonicSeconds()) * 1000) + 1;
+            if (untilWake < timeoutMs) timeoutMs = untilWake > 0 ? untilWake : 0;
+        }
+        curl_multi_poll(multi, NULL, 0, timeoutMs, NULL);
+    }
+
+    if (walk && list->count == 0) {
+        fprintf(stderr, "错误：找不到匹配的文件\n");
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
+
+    progressClear();
+    printf("\n===================================\n");
+    printf("批量%s完成:\n", verb);
+    printf("  成功: %d\n", success);
+    printf("  失败: %d\n", failed);
+    printf("===================================\n");
+
+    result = (failed == 0) ? ERR_OK : ERR_CURL_PERFORM;
+
+cleanup:
+    if (compressJobs) {
+        ErrorCode ignored;
+        while (reapCompressJob(compressJobs, concurrency, 1, &ignored)) {
+        }
+        free(compressJobs);
+    }
+    for (int i = 0; i < list->count; i++) {
+        freeUploadTask(multi, list->items[i]);
+    }
+    if (walk) {
+        uploadWalkAttach(walk, NULL);
+    }
+    if (multi) curl_multi_cleanup(multi);
+    uploadRateStop();
+    progressEnd();
+
+    return result;
+}
+
+// 使用 curl_multi 并发上传多个文件，同时最多 config->concurrency 个传输
+// 失败的文件按照 planRetry 的重试策略重新排队
+//
+// replaceExisting 非 0 时用于批量 update：根据预先获取的资产索引先删除同名旧资产。
+// 删除请求最多提前 concurrency 个文件发出，与前面文件的上传重叠进行，
+// 总耗时基本只取决于上传数据本身
+//
+// walk 非 NULL 时（目录上传），扫描线程发现的文件会在扫描过程中陆续加入队列
+static ErrorCode uploadMultipleFilesConcurrent(int fileCount, char **filePaths, UploadWalk *walk,
+                                               const Config *config, int replaceExisting) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    UploadTaskList list = {0};
+    const char *uploadUrlTemplate = NULL;
+    ReleaseCache *cache = NULL;
+    ErrorCode result;
+
+    // 上传地址和资产索引对整批文件相同，开始前获取一次
+    result = getUploadUrlTemplate(config, &uploadUrlTemplate);
+    if (result != ERR_OK) {
+        return result;
+    }
+    result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    for (int i = 0; i < fileCount; i++) {
+        UploadTask *task = appendUploadTask(&list, config, filePaths[i],
+                                            uploadAssetName(config, getFilenameFromPath(filePaths[i])));
+        if (!task) {
+            fprintf(stderr, "内存分配失败\n");
+            freeUploadTaskList(&list);
+            return ERR_MEMORY;
+        }
+        if (replaceExisting) {
+            markReplacedAsset(&list, cache, task);
+        }
+    }
+
+    result = runUploadTasks(&list, walk, config, replaceExisting ? "更新" : "上传");
+    freeUploadTaskList(&list);
+    return result;
+}
+
+// ==================== 上传限速与排序 ====================
+
+// 全局上传限速（--limit-rate）：所有并发传输共享一个令牌桶，令牌按速率持续补充，最多积累
+// UPLOAD_RATE_BURST 秒的量。读回调都在 multi 事件循环所在的线程中调用，不需要加锁；
+// 令牌用完时读回调暂停传输，事件循环在令牌补足后恢复
+typedef struct {
+    double rate;        // 字节/秒，0 表示不限
+    double tokens;
+    double burst;
+    double updated;     // 上次补充令牌的时间（单调时钟）
+    int paused;         // 因令牌不足而暂停的传输数
+} UploadRateLimit;
+
+static UploadRateLimit upload_rate = {0};
+
+// 解析字节数或速率，可带 K/M/G 后缀（按 1024 换算），无效时返回 -1
+static long long parseByteSize(const char *value) {
+    if (!value || !*value) {
+        return -1;
+    }
+
+    char *end = NULL;
+    errno = 0;
+    double n = strtod(value, &end);
+    if (errno != 0 || end == value || !(n >= 0)) {
+        return -1;
+    }
+
+    double unit = 1;
+    switch (toupper((unsigned char)*end)) {
+        case 'K': unit = 1024.0; end++; break;
+        case 'M': unit = 1024.0 * 1024; end++; break;
+        case 'G': unit = 1024.0 * 1024 * 1024; end++; break;
+        default: break;
+    }
+    if (toupper((unsigned char)*end) == 'B') end++;
+    if (*end != '\0' || n * unit >= 9e18) {
+        return -1;
+    }
+    return (long long)(n * unit);
+}
+
+// 解析 upload/update/apply 共用的限速、排序以及进度选项。argv[i] 是其中之一时返回占用的参数个数，
+// 不是时返回 0，出错时打印原因并返回 -1。order 为 NULL 时不接受排序选项
+static int parseUploadQueueOption(int argc, char **argv, int i, Config *config, UploadOrder *order) {
+    int transferArgs = parseTransferOption(argc, argv, i, config);
+    if (transferArgs != 0) {
+        return transferArgs;
+    }
+    if (strcmp(argv[i], "--limit-rate") == 0) {
+        long long rate = (i + 1 < argc) ? parseByteSize(argv[i + 1]) : -1;
+        if (rate < 1024) {
+            fprintf(stderr, "错误：--limit-rate 需要一个不小于 1K 的速率（字节/秒，可带 K/M/G 后缀）\n");
+            return -1;
+        }
+        config->limit_rate = (curl_off_t)rate;
+        return 2;
+    }
+    if (!order) {
+        return 0;
+    }
+    if (strcmp(argv[i], "--priority") == 0) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "错误：--priority 需要一个文件名通配符\n");
+            return -1;
+        }
+        if (order->pattern_count >= UPLOAD_MAX_PRIORITIES) {
+            fprintf(stderr, "错误：--priority 最多指定 %d 个\n", UPLOAD_MAX_PRIORITIES);
+            return -1;
+        }
+        order->patterns[order->pattern_count++] = argv[i + 1];
+        return 2;
+    }
+    if (strcmp(argv[i], "--smallest-first") == 0) {
+        order->smallest_first = 1;
+        return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    char *path;
+    int rank;            // 匹配的第一个 --priority 模式的序号，都不匹配时为模式数
+    long long size;
+    int index;           // 原来的位置，条件相同时保持原顺序
+} UploadOrderKey;
+
+static int compareUploadOrder(const void *a, const void *b) {
+    const UploadOrderKey *x = a;
+    const UploadOrderKey *y = b;
+    if (x->rank != y->rank) return x->rank < y->rank ? -1 : 1;
+    if (x->size != y->size) return x->size < y->size ? -1 : 1;
+    return x->index < y->index ? -1 : (x->index > y->index);
+}
+
+// 按 --priority 和 --smallest-first 重新排列待上传的文件。上传引擎按列表顺序启动传输，
+// 限速时也按这个顺序分配带宽，因此排在前面的文件最先可用
+static ErrorCode orderUploadFiles(char **files, int count, const UploadOrder *order) {
+    if (count < 2 || (order->pattern_count == 0 && !order->smallest_first)) {
+        return ERR_OK;
+    }
+
+    UploadOrderKey *keys = malloc(count * sizeof(UploadOrderKey));
+    if (!keys) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const char *name = getFilenameFromPath(files[i]);
+        keys[i].path = files[i];
+        keys[i].index = i;
+        keys[i].rank = order->pattern_count;
+        for (int j = 0; j < order->pattern_count; j++) {
+            if (fnmatch(order->patterns[j], name, 0) == 0) {
+                keys[i].rank = j;
+                break;
+            }
+        }
+        // 读不到大小的文件留在原位置附近，上传时再报告错误
+        struct stat st;
+        keys[i].size = (order->smallest_first && stat(files[i], &st) == 0) ? (long long)st.st_size : 0;
+    }
+
+    qsort(keys, count, sizeof(UploadOrderKey), compareUploadOrder);
+    for (int i = 0; i < count; i++) {
+        files[i] = keys[i].path;
+    }
+    free(keys);
+    return ERR_OK;
+}
+
+static void uploadRateStart(curl_off_t rate) {
+    memset(&upload_rate, 0, sizeof(upload_rate));
+    if (rate <= 0) {
+        return;
+    }
+    upload_rate.rate = (double)rate;
+    upload_rate.burst = upload_rate.rate * UPLOAD_RATE_BURST;
+    if (upload_rate.burst < UPLOAD_RATE_MIN_CHUNK) {
+        upload_rate.burst = UPLOAD_RATE_MIN_CHUNK;
+    }
+    upload_rate.tokens = upload_rate.burst;
+    upload_rate.updated = monotonicSeconds();
+    log_debug("上传限速: %.0f 字节/秒（所有传输合计）", upload_rate.rate);
+}
+
+static void uploadRateStop(void) {
+    memset(&upload_rate, 0, sizeof(upload_rate));
+}
+
+static void uploadRateRefill(void) {
+    double now = monotonicSeconds();
+    upload_rate.tokens += (now - upload_rate.updated) * upload_rate.rate;
+    if (upload_rate.tokens > upload_rate.burst) {
+        upload_rate.tokens = upload_rate.burst;
+    }
+    upload_rate.updated = now;
+}
+
+// 读回调取用令牌，返回本次可以发送的字节数；返回 0 时传输被标记为暂停
+static size_t uploadRateTake(UploadSource *source, size_t want) {
+    if (upload_rate.rate <= 0) {
+        return want;
+    }
+
+    uploadRateRefill();
+    if (upload_rate.tokens < 1) {
+        if (!source->paused) {
+            source->paused = 1;
+            upload_rate.paused++;
+        }
+        return 0;
+    }
+    if ((double)want > upload_rate.tokens) {
+        want = (size_t)upload_rate.tokens;
+    }
+    upload_rate.tokens -= (double)want;
+    return want;
+}
+
+// 传输恢复或结束时清除暂停标记
+static void uploadRateRelease(UploadSource *source) {
+    if (source->paused) {
+        source->paused = 0;
+        upload_rate.paused--;
+    }
+}
+
+// 暂停的传输可以恢复时返回 0，否则返回还需要等待的秒数
+static double uploadRateWait(void) {
+    if (upload_rate.rate <= 0) {
+        return 0;
+    }
+    uploadRateRefill();
+    double need = (upload_rate.burst < UPLOAD_RATE_MIN_CHUNK ? upload_rate.burst : UPLOAD_RATE_MIN_CHUNK)
+                  - upload_rate.tokens;
+    return need > 0 ? need / upload_rate.rate : 0;
+}
+
+static int uploadRatePaused(void) {
+    return upload_rate.paused;
+}
+
+// ==================== 传输进度 ====================
+
+// 传输进度：每个 curl 句柄的 XFERINFOFUNCTION 更新自己的 TransferProgress，这里汇总所有进行中的
+// 传输。stderr 是终端时每 PROGRESS_TTY_INTERVAL 秒重绘一行（总进度和最慢的文件），否则每
+// PROGRESS_LOG_INTERVAL 秒打印一组日志（总进度和每个文件）。与限速一样只在 multi 事件循环或
+// 发起请求的线程中使用，不需要加锁。--speed-limit 交给 curl 的 LOW_SPEED 选项，停滞的传输以
+// 超时结束，按瞬时故障重试
+typedef enum {
+    PROGRESS_OFF = 0,
+    PROGRESS_TTY,
+    PROGRESS_LOG
+} ProgressMode;
+
+static struct {
+    ProgressMode mode;
+    int depth;                  // 嵌套的 progressBegin 次数，只有最外层生效
+    double started;
+    double rendered;            // 上次输出的时间
+    double sampled;             // 上次采样总速率的时间
+    curl_off_t sampledMoved;
+    double rate;                // 平滑后的总速率（字节/秒）
+    curl_off_t moved;           // 实际传输的字节数，包括失败的尝试
+    curl_off_t planned;         // 预计传输的总字节数
+    curl_off_t finished;        // 已成功的文件的字节数
+    int files;
+    int filesDone;
+    curl_off_t speedLimit;
+    long speedTime;
+    TransferProgress *active;
+} transfer_progress = {0};
+
+// 解析 --speed-time 的秒数，无效时返回 -1
+static long parseSpeedTime(const char *value) {
+    char *end = NULL;
+    errno = 0;
+    long seconds = value ? strtol(value, &end, 10) : -1;
+    if (!value || errno != 0 || end == value || *end != '\0' || seconds < 1 || seconds > 86400) {
+        return -1;
+    }
+    return seconds;
+}
+
+// 解析 upload/update/apply/download 共用的进度和停滞检测选项，返回值同 parseUploadQueueOption
+static int parseTransferOption(int argc, char **argv, int i, Config *config) {
+    if (strcmp(argv[i], "--speed-limit") == 0) {
+        long long speed = (i + 1 < argc) ? parseByteSize(argv[i + 1]) : -1;
+        if (speed < 1) {
+            fprintf(stderr, "错误：--speed-limit 需要一个正的速率（字节/秒，可带 K/M/G 后缀）\n");
+            return -1;
+        }
+        config->speed_limit = (curl_off_t)speed;
+        return 2;
+    }
+    if (strcmp(argv[i], "--speed-time") == 0) {
+        long seconds = (i + 1 < argc) ? parseSpeedTime(argv[i + 1]) : -1;
+        if (seconds < 0) {
+            fprintf(stderr, "错误：--speed-time 需要一个 1-86400 之间的秒数\n");
+            return -1;
+        }
+        config->speed_time = seconds;
+        return 2;
+    }
+    if (strcmp(argv[i], "--no-progress") == 0) {
+        config->show_progress = 0;
+        return 1;
+    }
+    return 0;
+}
+
+// 开始一批传输。rateShares 是共享 --limit-rate 的并发传输数（下载不受其限制时为 0）：
+// 每个传输分到的速率低于停滞阈值时，排队等令牌的传输会被误判为停滞，此时不做停滞检测
+static void progressBegin(const Config *config, int rateShares) {
+    if (transfer_progress.depth++ > 0) {
+        return;
+    }
+    memset(&transfer_progress, 0, sizeof(transfer_progress));
+    transfer_progress.depth = 1;
+    transfer_progress.started = monotonicSeconds();
+    transfer_progress.sampled = transfer_progress.started;
+    transfer_progress.rendered = transfer_progress.started;
+    if (config->show_progress) {
+        transfer_progress.mode = isatty(STDERR_FILENO) ? PROGRESS_TTY : PROGRESS_LOG;
+        if (transfer_progress.mode == PROGRESS_TTY) {
+            transfer_progress.rendered = 0;  // 终端上第一次回调就显示
+        }
+    }
+
+    transfer_progress.speedLimit = config->speed_limit;
+    transfer_progress.speedTime = config->speed_time;
+    if (config->speed_limit > 0 && rateShares > 0 && config->limit_rate > 0 &&
+        config->speed_limit * rateShares > config->limit_rate) {
+        log_warn("--speed-limit 乘以并发数超过了 --limit-rate，本次传输不做停滞检测");
+        transfer_progress.speedLimit = 0;
+    }
+}
+
+static void progressEnd(void) {
+    if (transfer_progress.depth == 0 || --transfer_progress.depth > 0) {
+        return;
+    }
+    progressClear();
+    for (TransferProgress *t = transfer_progress.active; t; t = t->next) {
+        t->linked = 0;
+    }
+    memset(&transfer_progress, 0, sizeof(transfer_progress));
+}
+
+// 把一个文件计入总进度，bytes 未知时为 0
+static void progressPlan(TransferProgress *t, curl_off_t bytes) {
+    t->planned = bytes;
+    transfer_progress.planned += bytes;
+    transfer_progress.files++;
+}
+
+// 文件上传完成（ok 非 0）或最终失败，不再重试
+static void progressFileDone(TransferProgress *t, int ok) {
+    progressDetach(t);
+    transfer_progress.filesDone++;
+    if (ok) {
+        transfer_progress.finished += t->planned;
+    } else {
+        transfer_progress.planned -= t->planned;
+    }
+}
+
+// 以十进制单位格式化字节数，与 MB/s 一致
+static void formatProgressBytes(char *buf, size_t size, double bytes) {
+    if (bytes >= 1e9) {
+        snprintf(buf, size, "%.2f GB", bytes / 1e9);
+    } else if (bytes >= 1e6) {
+        snprintf(buf, size, "%.1f MB", bytes / 1e6);
+    } else {
+        snprintf(buf, size, "%.0f KB", bytes / 1e3);
+    }
+}
+
+// 剩余时间格式化为 mm:ss 或 h:mm:ss，超过 99 小时显示 --:--
+static void formatProgressEta(char *buf, size_t size, double seconds) {
+    if (seconds < 0 || seconds > 359999) {
+        snprintf(buf, size, "--:--");
+        return;
+    }
+
+    // 上面已限定范围，各字段按 unsigned 取值，编译器也能确认输出不会截断
+    unsigned s = (unsigned)seconds;
+    unsigned hours = s / 3600 % 100, minutes = s / 60 % 60, secs = s % 60;
+    if (hours > 0) {
+        snprintf(buf, size, "%u:%02u:%02u", hours, minutes, secs);
+    } else {
+        snprintf(buf, size, "%02u:%02u", minutes, secs);
+    }
+}
+
+// 单个传输的速率和剩余时间（未知时为 -1）
+static double progressTransferRate(const TransferProgress *t, double now) {
+    double elapsed = now - t->started;
+    return elapsed > 0 ? (double)t->now / elapsed : 0;
+}
+
+static double progressTransferEta(const TransferProgress *t, double now) {
+    double rate = progressTransferRate(t, now);
+    if (t->total <= 0 || rate <= 0) {
+        return -1;
+    }
+    return (double)(t->total - t->now) / rate;
+}
+
+// 进行中的传输按 planned 计入总进度（压缩后的 total 与 planned 不同）
+static double progressDoneBytes(void) {
+    double done = (double)transfer_progress.finished;
+    for (TransferProgress *t = transfer_progress.active; t; t = t->next) {
+        if (t->total > 0 && t->planned > 0) {
+            done += (double)t->now * (double)t->planned / (double)t->total;
+        } else {
+            done += (double)t->now;
+        }
+    }
+    return done;
+}
+
+// 更新平滑后的总速率：时间常数为 PROGRESS_RATE_WINDOW 的指数平均，第一次采样直接取瞬时值
+static void progressSample(double now) {
+    double elapsed = now - transfer_progress.sampled;
+    if (elapsed <= 0) {
+        return;
+    }
+    double instant = (double)(transfer_progress.moved - transfer_progress.sampledMoved) / elapsed;
+    if (transfer_progress.sampledMoved == 0 && transfer_progress.rate == 0) {
+        transfer_progress.rate = instant;
+    } else {
+        double alpha = elapsed / (elapsed + PROGRESS_RATE_WINDOW);
+        transfer_progress.rate += (instant - transfer_progress.rate) * alpha;
+    }
+    transfer_progress.sampled = now;
+    transfer_progress.sampledMoved = transfer_progress.moved;
+}
+
+// 进度行中的文件名截断到 PROGRESS_NAME_WIDTH 字节，不切断 UTF-8 字符
+static int progressNameLength(const char *name) {
+    int len = (int)strlen(name);
+    if (len <= PROGRESS_NAME_WIDTH) {
+        return len;
+    }
+    len = PROGRESS_NAME_WIDTH;
+    while (len > 0 && ((unsigned char)name[len] & 0xC0) == 0x80) {
+        len--;
+    }
+    return len;
+}
+
+static void progressRender(double now) {
+    char done[16], planned[16], eta[16];
+    double doneBytes = progressDoneBytes();
+    double remaining = (double)transfer_progress.planned - doneBytes;
+    double rate = transfer_progress.rate;
+
+    formatProgressBytes(done, sizeof(done), doneBytes);
+    formatProgressBytes(planned, sizeof(planned), (double)transfer_progress.planned);
+    formatProgressEta(eta, sizeof(eta), (transfer_progress.planned > 0 && rate > 0) ? remaining / rate : -1);
+    int percent = transfer_progress.planned > 0 ? (int)(doneBytes * 100 / (double)transfer_progress.planned) : 0;
+    if (percent > 100) percent = 100;
+
+    if (transfer_progress.mode == PROGRESS_LOG) {
+        log_info("进度: %d/%d 个文件，%s/%s (%d%%)，%.1f MB/s，预计剩余 %s",
+                 transfer_progress.filesDone, transfer_progress.files, done, planned, percent, rate / 1e6, eta);
+        for (TransferProgress *t = transfer_progress.active; t; t = t->next) {
+            char sent[16], total[16], fileEta[16];
+            formatProgressBytes(sent, sizeof(sent), (double)t->now);
+            formatProgressBytes(total, sizeof(total), (double)t->total);
+            formatProgressEta(fileEta, sizeof(fileEta), progressTransferEta(t, now));
+            log_info("  %s: %s/%s，%.1f MB/s，预计剩余 %s", t->name, sent, total,
+                     progressTransferRate(t, now) / 1e6, fileEta);
+        }
+        return;
+    }
+
+    // 终端上只有一行：总进度，以及预计最晚完成的文件
+    TransferProgress *slowest = NULL;
+    double slowestEta = -2;
+    int activeCount = 0;
+    for (TransferProgress *t = transfer_progress.active; t; t = t->next) {
+        double fileEta = progressTransferEta(t, now);
+        if (fileEta < 0) fileEta = 1e9;
+        if (fileEta > slowestEta) {
+            slowest = t;
+            slowestEta = fileEta;
+        }
+        activeCount++;
+    }
+
+    pthread_mutex_lock(&progress_line_lock);
+    fprintf(stderr, "\r\033[K%d/%d %s/%s %d%% %.1f MB/s 剩余 %s",
+            transfer_progress.filesDone, transfer_progress.files, done, planned, percent, rate / 1e6, eta);
+    if (slowest) {
+        char fileEta[16];
+        int filePercent = slowest->total > 0 ? (int)(slowest->now * 100 / slowest->total) : 0;
+        formatProgressEta(fileEta, sizeof(fileEta), progressTransferEta(slowest, now));
+        fprintf(stderr, " | %.*s %d%% %.1f MB/s 剩余 %s", progressNameLength(slowest->name), slowest->name,
+                filePercent, progressTransferRate(slowest, now) / 1e6, fileEta);
+        if (activeCount > 1) {
+            fprintf(stderr, " (+%d)", activeCount - 1);
+        }
+    }
+    fflush(stderr);
+    progress_line_shown = 1;
+    pthread_mutex_unlock(&progress_line_lock);
+}
+
+// curl 的进度回调：更新本传输的字节数，到了刷新间隔时输出汇总
+static int ProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                            curl_off_t ultotal, curl_off_t ulnow) {
+    TransferProgress *t = clientp;
+    (void)dltotal;
+    (void)ultotal;
+
+    // 上传时 dlnow 只是很小的响应体，下载时 ulnow 为 0
+    curl_off_t now = ulnow > dlnow ? ulnow : dlnow;
+    if (now > t->now) {
+        transfer_progress.moved += now - t->now;
+    }
+    t->now = now;
+
+    if (transfer_progress.mode == PROGRESS_OFF) {
+        return 0;
+    }
+    double clock = monotonicSeconds();
+    double interval = transfer_progress.mode == PROGRESS_TTY ? PROGRESS_TTY_INTERVAL : PROGRESS_LOG_INTERVAL;
+    if (clock - transfer_progress.rendered < interval) {
+        return 0;
+    }
+    transfer_progress.rendered = clock;
+    progressSample(clock);
+    progressRender(clock);
+    return 0;
+}
+
+// 开始一次传输尝试：挂上进度回调和停滞检测，计入进行中的传输
+static void progressAttach(CURL *curl, TransferProgress *t, const char *name, curl_off_t total) {
+    progressDetach(t);
+    t->name = name;
+    t->total = total;
+    t->now = 0;
+    t->started = monotonicSeconds();
+
+    if (transfer_progress.depth == 0) {
+        return;
+    }
+    t->prev = NULL;
+    t->next = transfer_progress.active;
+    if (t->next) t->next->prev = t;
+    transfer_progress.active = t;
+    t->linked = 1;
+
+    if (transfer_progress.mode != PROGRESS_OFF) {
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, (void *)t);
+    }
+    if (transfer_progress.speedLimit > 0) {
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, (long)transfer_progress.speedLimit);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, transfer_progress.speedTime);
+    }
+}
+
+// 一次尝试结束（成功、失败或即将重试），不再计入进行中的传输
+static void progressDetach(TransferProgress *t) {
+    if (!t->linked) {
+        return;
+    }
+    if (t->prev) {
+        t->prev->next = t->next;
+    } else {
+        transfer_progress.active = t->next;
+    }
+    if (t->next) t->next->prev = t->prev;
+    t->prev = NULL;
+    t->next = NULL;
+    t->linked = 0;
+}
+
+// 清除终端上的进度行，之后的输出从行首开始，下次回调时重新绘制
+static void progressClear(void) {
+    pthread_mutex_lock(&progress_line_lock);
+    progressClearLocked();
+    pthread_mutex_unlock(&progress_line_lock);
+}
+
+// ==================== 目录递归上传 ====================
+
+// 待扫描的目录
+typedef struct WalkDir {
+    struct WalkDir *next;
+    char *path;
+    int spec;
+    int depth;
+} WalkDir;
+
+// 扫描到的文件，整个上传过程中保持有效，上传任务直接引用其中的路径和资产名
+typedef struct WalkItem {
+    struct WalkItem *next;
+    struct WalkItem *name_next;   // 资产名哈希链
+    char *path;
+    char *name;
+} WalkItem;
+
+// 多个线程共享一个目录队列并行扫描，发现的文件立即交给上传引擎
+struct UploadWalk {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    const WalkSpec *specs;
+    FlattenStyle style;
+    WalkDir *dirs;           // 待扫描的目录（栈）
+    int busy;                // 正在扫描目录的线程数
+    int stopping;
+    int finished;            // 所有扫描线程都已退出
+    int exited;
+    int thread_count;
+    pthread_t threads[WALK_THREADS];
+    WalkItem *head;
+    WalkItem *tail;
+    WalkItem *cursor;        // 最后一个交给上传引擎的文件
+    WalkItem *names[WALK_NAME_BUCKETS];
+    int errors;
+    CURLM *multi;            // 发现文件或扫描结束时唤醒
+};
+
+// 支持 ** 的路径匹配：** 作为完整的一段时匹配零个或多个目录，其余按 fnmatch(FNM_PATHNAME) 匹配
+static int globstarMatch(const char *pattern, const char *path) {
+    const char *star = strstr(pattern, "**");
+    if (!star || (star != pattern && star[-1] != '/') || (star[2] != '\0' && star[2] != '/')) {
+        return fnmatch(pattern, path, FNM_PATHNAME) == 0;
+    }
+
+    // ** 之前的每一段匹配路径开头同样多的目录
+    if (star != pattern) {
+        const char *rest = path;
+        for (const char *p = pattern; p < star; p++) {
+            if (*p != '/') continue;
+            rest = strchr(rest, '/');
+            if (!rest) return 0;
+            rest++;
+        }
+        char *head = strndup(pattern, (size_t)(star - pattern - 1));
+        char *pathHead = strndup(path, (size_t)(rest - path - 1));
+        int matched = head && pathHead && fnmatch(head, pathHead, FNM_PATHNAME) == 0;
+        free(head);
+        free(pathHead);
+        if (!matched) return 0;
+        path = rest;
+    }
+
+    const char *tail = star + 2;
+    if (*tail == '\0') return 1;
+    tail++;
+
+    for (const char *p = path;;) {
+        if (globstarMatch(tail, p)) return 1;
+        p = strchr(p, '/');
+        if (!p) return 0;
+        p++;
+    }
+}
+
+static int hasWildcard(const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '*' || s[i] == '?' || s[i] == '[') return 1;
+    }
+    return 0;
+}
+
+// 解析 upload 的一个参数：目录、含 ** 或带目录的通配符由扫描线程处理。
+// 返回 1 表示已填好 spec，0 表示普通文件或当前目录下的通配符，-1 表示参数无效
+static int parseWalkSpec(const char *arg, WalkSpec *spec) {
+    memset(spec, 0, sizeof(*spec));
+    size_t len = strlen(arg);
+    int wildcard = hasWildcard(arg, len);
+    struct stat st;
+
+    if (!wildcard) {
+        if (stat(arg, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            return 0;
+        }
+    } else if (!strstr(arg, "**") && !strchr(arg, '/')) {
+        return 0;
+    }
+
+    if (!is_safe_path(arg)) {
+        fprintf(stderr, "无效的文件路径: %s\n", arg);
+        return -1;
+    }
+
+    while (len > 1 && arg[len - 1] == '/') len--;
+
+    // 起始目录为开头不含通配符的若干段，其余部分作为相对它的模式；目录参数匹配其中的全部文件
+    size_t rootLen = len;
+    size_t patternStart = len;
+    if (wildcard) {
+        patternStart = 0;
+        for (size_t i = 0; i < len; i++) {
+            if (arg[i] != '/') continue;
+            if (hasWildcard(arg + patternStart, i - patternStart)) break;
+            patternStart = i + 1;
+        }
+        rootLen = patternStart > 0 ? patternStart - 1 : 0;
+    }
+
+    spec->root = rootLen ? strndup(arg, rootLen) : strdup(".");
+    spec->pattern = wildcard ? strndup(arg + patternStart, len - patternStart) : strdup("**");
+    if (!spec->root || !spec->pattern) {
+        freeWalkSpec(spec);
+        fprintf(stderr, "内存分配失败\n");
+        return -1;
+    }
+
+    spec->max_depth = -1;
+    if (!strstr(spec->pattern, "**")) {
+        spec->max_depth = 0;
+        for (const char *p = spec->pattern; *p; p++) {
+            if (*p == '/') spec->max_depth++;
+        }
+    }
+    spec->rel_offset = strcmp(spec->root, ".") == 0 ? 0 : strlen(spec->root) + 1;
+    return 1;
+}
+
+static void freeWalkSpec(WalkSpec *spec) {
+    free(spec->root);
+    free(spec->pattern);
+    spec->root = NULL;
+    spec->pattern = NULL;
+}
+
+// 解析 --flatten：base 只保留文件名，path[:分隔符] 用分隔符连接相对路径中的各级目录
+static int parseFlattenStyle(const char *value, FlattenStyle *style) {
+    if (strcmp(value, "base") == 0) {
+        style->keep_path = 0;
+        style->separator = DEFAULT_FLATTEN_SEPARATOR;
+        return 0;
+    }
+    if (strncmp(value, "path", 4) != 0 || (value[4] != '\0' && value[4] != ':')) {
+        return -1;
+    }
+    // 分隔符不能含 / 和 URL 中有特殊含义的字符，避免资产名在各处的 URL 里被误解
+    const char *separator = value[4] == ':' ? value + 5 : DEFAULT_FLATTEN_SEPARATOR;
+    if (!*separator || strpbrk(separator, "/#&?%+")) {
+        return -1;
+    }
+    style->keep_path = 1;
+    style->separator = separator;
+    return 0;
+}
+
+// 由相对路径生成资产名
+static char* flattenAssetName(const FlattenStyle *style, const char *relPath) {
+    if (!style->keep_path) {
+        return strdup(getFilenameFromPath(relPath));
+    }
+
+    size_t separatorLen = strlen(style->separator);
+    size_t len = 0;
+    for (const char *p = relPath; *p; p++) {
+        len += (*p == '/') ? separatorLen : 1;
+    }
+
+    char *name = malloc(len + 1);
+    if (!name) return NULL;
+    char *out = name;
+    for (const char *p = relPath; *p; p++) {
+        if (*p == '/') {
+            memcpy(out, style->separator, separatorLen);
+            out += separatorLen;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+    return name;
+}
+
+static char* joinWalkPath(const char *dir, const char *name) {
+    if (strcmp(dir, ".") == 0) {
+        return strdup(name);
+    }
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (path) snprintf(path, len, "%s/%s", dir, name);
+    return path;
+}
+
+// 调用时已持有 walk->lock
+static void wakeUploadEngine(UploadWalk *walk) {
+    if (walk->multi) {
+        curl_multi_wakeup(walk->multi);
+    }
+}
+
+static int pushWalkDir(UploadWalk *walk, char *path, int spec, int depth) {
+    WalkDir *dir = malloc(sizeof(WalkDir));
+    if (!dir) {
+        free(path);
+        return -1;
+    }
+    dir->path = path;
+    dir->spec = spec;
+    dir->depth = depth;
+
+    pthread_mutex_lock(&walk->lock);
+    dir->next = walk->dirs;
+    walk->dirs = dir;
+    pthread_cond_signal(&walk->cond);
+    pthread_mutex_unlock(&walk->lock);
+    return 0;
+}
+
+// 把扫描到的文件加入上传队列（接管 path）。不同文件得到相同的资产名时跳过后者；
+// 同一个文件被多个参数匹配到时只上传一次
+static void addWalkFile(UploadWalk *walk, char *path, const char *relPath) {
+    WalkItem *item = calloc(1, sizeof(WalkItem));
+    char *name = flattenAssetName(&walk->style, relPath);
+    if (!item || !name) {
+        fprintf(stderr, "内存分配失败\n");
+        free(item);
+        free(name);
+        free(path);
+        pthread_mutex_lock(&walk->lock);
+        walk->errors++;
+        pthread_mutex_unlock(&walk->lock);
+        return;
+    }
+    item->path = path;
+    item->name = name;
+
+    size_t bucket = hashAssetName(name) % WALK_NAME_BUCKETS;
+    pthread_mutex_lock(&walk->lock);
+    for (WalkItem *other = walk->names[bucket]; other; other = other->name_next) {
+        if (strcmp(other->name, name) != 0) continue;
+        if (strcmp(other->path, path) != 0) {
+            fprintf(stderr, "错误：%s 和 %s 对应同一个资产名 \"%s\"，跳过后者（可用 --flatten 调整命名）\n",
+                    other->path, path, name);
+            walk->errors++;
+        }
+        pthread_mutex_unlock(&walk->lock);
+        free(item->path);
+        free(item->name);
+        free(item);
+        return;
+    }
+    item->name_next = walk->names[bucket];
+    walk->names[bucket] = item;
+    if (walk->tail) walk->tail->next = item;
+    else walk->head = item;
+    walk->tail = item;
+    wakeUploadEngine(walk);
+    pthread_mutex_unlock(&walk->lock);
+}
+
+// 扫描一个目录：子目录放回队列由空闲线程处理，匹配的文件立即加入上传队列。
+// 跳过隐藏文件，不进入指向目录的符号链接（避免循环）
+static void walkDirectory(UploadWalk *walk, const WalkDir *dir) {
+    const WalkSpec *spec = &walk->specs[dir->spec];
+    DIR *handle = opendir(dir->path);
+    if (!handle) {
+        fprintf(stderr, "无法打开目录 %s: %s\n", dir->path, strerror(errno));
+        pthread_mutex_lock(&walk->lock);
+        walk->errors++;
+        pthread_mutex_unlock(&walk->lock);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        int isDir = (entry->d_type == DT_DIR);
+        int isFile = (entry->d_type == DT_REG);
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            int flags = entry->d_type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW;
+            if (fstatat(dirfd(handle), entry->d_name, &st, flags) == 0) {
+                isFile = S_ISREG(st.st_mode);
+                isDir = S_ISDIR(st.st_mode) && entry->d_type != DT_LNK;
+            }
+        }
+        if (!isDir && !isFile) continue;
+        if (isDir && spec->max_depth >= 0 && dir->depth >= spec->max_depth) continue;
+
+        char *path = joinWalkPath(dir->path, entry->d_name);
+        if (!path) {
+            fprintf(stderr, "内存分配失败\n");
+            pthread_mutex_lock(&walk->lock);
+            walk->errors++;
+            pthread_mutex_unlock(&walk->lock);
+            continue;
+        }
+
+        if (isDir) {
+            pushWalkDir(walk, path, dir->spec, dir->depth + 1);
+        } else if (globstarMatch(spec->pattern, path + spec->rel_offset)) {
+            addWalkFile(walk, path, path + spec->rel_offset);
+        } else {
+            free(path);
+        }
+    }
+    closedir(handle);
+}
+
+static void* uploadWalkWorker(void *arg) {
+    UploadWalk *walk = arg;
+
+    pthread_mutex_lock(&walk->lock);
+    for (;;) {
+        // 队列为空且没有线程在扫描（不会再产生新目录）时结束
+        while (!walk->dirs && walk->busy > 0 && !walk->stopping) {
+            pthread_cond_wait(&walk->cond, &walk->lock);
+        }
+        WalkDir *dir = walk->dirs;
+        if (!dir || walk->stopping) {
+            break;
+        }
+        walk->dirs = dir->next;
+        walk->busy++;
+        pthread_mutex_unlock(&walk->lock);
+
+        walkDirectory(walk, dir);
+        free(dir->path);
+        free(dir);
+
+        pthread_mutex_lock(&walk->lock);
+        walk->busy--;
+        if (!walk->dirs && walk->busy == 0) {
+            pthread_cond_broadcast(&walk->cond);
+        }
+    }
+    if (++walk->exited == walk->thread_count) {
+        walk->finished = 1;
+        wakeUploadEngine(walk);
+    }
+    pthread_mutex_unlock(&walk->lock);
+    return NULL;
+}
+
+// 把每个参数的起始目录放入队列并启动扫描线程，specs 和 style 需在扫描结束前保持有效
+static ErrorCode startUploadWalk(const WalkSpec *specs, int specCount, const FlattenStyle *style,
+                                 UploadWalk **out_walk) {
+    *out_walk = NULL;
+    UploadWalk *walk = calloc(1, sizeof(UploadWalk));
+    if (!walk) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    pthread_mutex_init(&walk->lock, NULL);
+    pthread_cond_init(&walk->cond, NULL);
+    walk->specs = specs;
+    walk->style = *style;
+
+    for (int i = 0; i < specCount; i++) {
+        char *root = strdup(specs[i].root);
+        if (!root || pushWalkDir(walk, root, i, 0) != 0) {
+            fprintf(stderr, "内存分配失败\n");
+            finishUploadWalk(walk);
+            return ERR_MEMORY;
+        }
+    }
+
+    pthread_mutex_lock(&walk->lock);
+    for (int i = 0; i < WALK_THREADS; i++) {
+        if (pthread_create(&walk->threads[i], NULL, uploadWalkWorker, walk) != 0) {
+            break;
+        }
+        walk->thread_count++;
+    }
+    pthread_mutex_unlock(&walk->lock);
+
+    if (walk->thread_count == 0) {
+        fprintf(stderr, "无法创建扫描线程\n");
+        finishUploadWalk(walk);
+        return ERR_MEMORY;
+    }
+
+    *out_walk = walk;
+    return ERR_OK;
+}
+
+// 设置扫描线程发现文件时要唤醒的 multi 句柄；multi 清理前需传入 NULL
+static void uploadWalkAttach(UploadWalk *walk, CURLM *multi) {
+    pthread_mutex_lock(&walk->lock);
+    walk->multi = multi;
+    pthread_mutex_unlock(&walk->lock);
+}
+
+// 取下一个扫描到的文件，不阻塞。返回 1 表示取到，0 表示暂时没有，-1 表示扫描已结束且全部取完
+static int uploadWalkNext(UploadWalk *walk, const char **path, const char **name) {
+    int result;
+    pthread_mutex_lock(&walk->lock);
+    WalkItem *item = walk->cursor ? walk->cursor->next : walk->head;
+    if (item) {
+        walk->cursor = item;
+        *path = item->path;
+        *name = item->name;
+        result = 1;
+    } else {
+        result = walk->finished ? -1 : 0;
+    }
+    pthread_mutex_unlock(&walk->lock);
+    return result;
+}
+
+// 停止并等待扫描线程，释放扫描结果，返回扫描过程中的错误数
+static int finishUploadWalk(UploadWalk *walk) {
+    pthread_mutex_lock(&walk->lock);
+    walk->stopping = 1;
+    walk->multi = NULL;
+    pthread_cond_broadcast(&walk->cond);
+    pthread_mutex_unlock(&walk->lock);
+
+    for (int i = 0; i < walk->thread_count; i++) {
+        pthread_join(walk->threads[i], NULL);
+    }
+
+    int errors = walk->errors;
+    while (walk->dirs) {
+        WalkDir *dir = walk->dirs;
+        walk->dirs = dir->next;
+        free(dir->path);
+        free(dir);
+    }
+    while (walk->head) {
+        WalkItem *item = walk->head;
+        walk->head = item->next;
+        free(item->path);
+        free(item->name);
+        free(item);
+    }
+    pthread_cond_destroy(&walk->cond);
+    pthread_mutex_destroy(&walk->lock);
+    free(walk);
+    return errors;
+}
+
+// 上传普通文件和目录参数，目录边扫描边上传
+static ErrorCode uploadTree(int fileCount, char **filePaths, const WalkSpec *specs, int specCount,
+                            const FlattenStyle *style, const Config *config) {
+    UploadWalk *walk = NULL;
+    ErrorCode result = startUploadWalk(specs, specCount, style, &walk);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    result = uploadMultipleFilesConcurrent(fileCount, filePaths, walk, config, 0);
+
+    int walkErrors = finishUploadWalk(walk);
+    if (result == ERR_OK && walkErrors > 0) {
+        result = ERR_FILE_IO;
+    }
+    return result;
+}
+
+// ==================== 上传压缩 ====================
+
+// 压缩输出缓冲区的增长步长下限
+#define COMPRESS_OUTPUT_CHUNK (256L * 1024)
+
+// 并发上传时同时放在内存中的压缩结果总量上限。每个压缩结果都要完整放在内存中（最大接近 2 GiB），
+// -j 个大文件同时压缩可能占用十几 GB；超出预算时后面的文件等前面的缓冲区释放后再开始压缩
+#define COMPRESS_MEMORY_BUDGET (2LL * 1024 * 1024 * 1024)
+
+// 压缩缓冲区占用的预算：由上传调度循环申请，数据源关闭时归还（压缩失败时在压缩线程中）
+static struct {
+    pthread_mutex_t lock;
+    curl_off_t used;
+} compress_budget = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// 压缩 size 字节最多需要的输出空间：不可压缩的数据压缩后会略微变大
+static curl_off_t compressOutputBound(curl_off_t size) {
+    curl_off_t bound = size + size / 64 + COMPRESS_OUTPUT_CHUNK;
+    return bound < MAX_ASSET_SIZE ? bound : MAX_ASSET_SIZE;
+}
+
+// 为即将压缩的文件申请预算；其他缓冲区已经占用、再加上它会超出预算时返回 0，稍后再试。
+// 没有其他占用时总是成功，单个文件最多占用 MAX_ASSET_SIZE，不会超过预算
+static int compressBudgetTake(UploadSource *source, curl_off_t fileSize) {
+    curl_off_t need = compressOutputBound(fileSize);
+    pthread_mutex_lock(&compress_budget.lock);
+    int ok = compress_budget.used == 0 || compress_budget.used + need <= COMPRESS_MEMORY_BUDGET;
+    if (ok) {
+        compress_budget.used += need;
+        source->budget = need;
+    }
+    pthread_mutex_unlock(&compress_budget.lock);
+    return ok;
+}
+
+// 归还 source 占用的预算中超出 keep 字节的部分
+static void compressBudgetShrink(UploadSource *source, curl_off_t keep) {
+    if (source->budget <= keep) {
+        return;
+    }
+    pthread_mutex_lock(&compress_budget.lock);
+    compress_budget.used -= source->budget - keep;
+    pthread_mutex_unlock(&compress_budget.lock);
+    source->budget = keep;
+}
+
+// 解析 --compress 的值：gzip[:1-9] 或 zstd[:1-22]。返回 0 成功，-1 无效，-2 编译时未启用 zstd
+static int parseCompression(const char *value, UploadCompression *out) {
+    const char *level = strchr(value, ':');
+    size_t nameLen = level ? (size_t)(level - value) : strlen(value);
+    int maxLevel;
+
+    if (nameLen == 4 && strncmp(value, "gzip", 4) == 0) {
+        out->type = COMPRESS_GZIP;
+        out->level = Z_DEFAULT_COMPRESSION;
+        maxLevel = 9;
+    } else if (nameLen == 4 && strncmp(value, "zstd", 4) == 0) {
+#ifdef MANAGE_WITH_ZSTD
+        out->type = COMPRESS_ZSTD;
+        out->level = ZSTD_CLEVEL_DEFAULT;
+        maxLevel = ZSTD_maxCLevel();
+#else
+        return -2;
+#endif
+    } else {
+        return -1;
+    }
+
+    if (level) {
+        char *end = NULL;
+        errno = 0;
+        long n = strtol(level + 1, &end, 10);
+        if (errno != 0 || end == level + 1 || *end != '\0' || n < 1 || n > maxLevel) {
+            return -1;
+        }
+        out->level = (int)n;
+    }
+    return 0;
+}
+
+// 解析命令行中 --compress 的值，无效时打印错误并返回 -1
+static int reportCompressionOption(const char *value, UploadCompression *out) {
+    int parsed = value ? parseCompression(value, out) : -1;
+    if (parsed == -2) {
+        fprintf(stderr, "错误：编译时未启用 zstd（使用 make ZSTD=1 重新编译），可改用 --compress gzip\n");
+    } else if (parsed != 0) {
+        fprintf(stderr, "错误：--compress 需要 gzip[:1-9] 或 zstd[:1-22]\n");
+    }
+    return parsed == 0 ? 0 : -1;
+}
+
+static const char* compressionSuffix(const UploadCompression *compression) {
+    switch (compression->type) {
+        case COMPRESS_GZIP: return ".gz";
+        case COMPRESS_ZSTD: return ".zst";
+        default: return "";
+    }
+}
+
+// 上传时使用的资产名：启用压缩时在文件名后追加压缩格式的后缀
+static const char* uploadAssetName(const Config *config, const char *fileName) {
+    if (!config->compression) {
+        return fileName;
+    }
+    const char *name = arenaPrintf(commandArena(config), "%s%s", fileName,
+                                   compressionSuffix(config->compression));
+    return name ? name : fileName;
+}
+
+// 保证输出缓冲区至少还有 need 字节空间；压缩结果不能超过 GitHub 的单个资产上限。
+// bound 是预计的最大输出（compressOutputBound），翻倍扩容时不超过它，缓冲区不会比预算占用的大
+static ErrorCode reserveCompressOutput(unsigned char **data, size_t *capacity, size_t len, size_t need,
+                                       size_t bound) {
+    if (*capacity - len >= need) {
+        return ERR_OK;
+    }
+    if (len + need >= (size_t)MAX_ASSET_SIZE) {
+        printf("压缩后的文件仍然过大（GitHub 单个文件需小于 2 GiB）\n");
+        return ERR_FILE_IO;
+    }
+
+    size_t grown = *capacity * 2;
+    if (grown > bound) grown = bound;
+    if (grown < len + need) grown = len + need;
+    if (grown > (size_t)MAX_ASSET_SIZE) grown = (size_t)MAX_ASSET_SIZE;
+    unsigned char *buffer = realloc(*data, grown);
+    if (!buffer) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    *data = buffer;
+    *capacity = grown;
+    return ERR_OK;
+}
+
+// 顺序读取下一块原始数据，返回读到的字节数，出错或文件被截断时返回 -1
+static ssize_t readCompressInput(UploadSource *source, unsigned char *buffer, curl_off_t offset) {
+    size_t want = UPLOAD_BUFFER_SIZE;
+    if ((curl_off_t)want > source->size - offset) {
+        want = (size_t)(source->size - offset);
+    }
+
+    ssize_t n;
+    do {
+        n = pread(source->fd, buffer, want, (off_t)offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        log_error("读取上传文件失败: %s", n < 0 ? strerror(errno) : "文件被截断");
+        return -1;
+    }
+    return n;
+}
+
+static ErrorCode gzipUploadSource(UploadSource *source, int level, unsigned char *input,
+                                  unsigned char **data, size_t *capacity, size_t *len) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits 加 16 输出 gzip 格式（带文件头和 CRC）
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "初始化 gzip 压缩失败\n");
+        return ERR_MEMORY;
+    }
+
+    ErrorCode result = ERR_OK;
+    size_t bound = (size_t)compressOutputBound(source->size);
+    curl_off_t offset = 0;
+    int status = Z_OK;
+    while (status != Z_STREAM_END) {
+        int flush = Z_FINISH;
+        if (offset < source->size) {
+            ssize_t n = readCompressInput(source, input, offset);
+            if (n < 0) {
+                result = ERR_FILE_IO;
+                break;
+            }
+            offset += n;
+            stream.next_in = input;
+            stream.avail_in = (uInt)n;
+            flush = offset < source->size ? Z_NO_FLUSH : Z_FINISH;
+        }
+
+        do {
+            result = reserveCompressOutput(data, capacity, *len, COMPRESS_OUTPUT_CHUNK, bound);
+            if (result != ERR_OK) break;
+            stream.next_out = *data + *len;
+            stream.avail_out = (uInt)(*capacity - *len);
+            status = deflate(&stream, flush);
+            *len = *capacity - stream.avail_out;
+        } while (status == Z_OK && (stream.avail_in > 0 || (flush == Z_FINISH && stream.avail_out == 0)));
+
+        if (result != ERR_OK) break;
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+            fprintf(stderr, "gzip 压缩失败: %d\n", status);
+            result = ERR_FILE_IO;
+            break;
+        }
+    }
+
+    deflateEnd(&stream);
+    return result;
+}
+
+#ifdef MANAGE_WITH_ZSTD
+static ErrorCode zstdUploadSource(UploadSource *source, int level, unsigned char *input,
+                                  unsigned char **data, size_t *capacity, size_t *len) {
+    ZSTD_CCtx *cctx = ZSTD_createCCtx();
+    if (!cctx) {
+        fprintf(stderr, "初始化 zstd 压缩失败\n");
+        return ERR_MEMORY;
+    }
+
+    // 多线程压缩：libzstd 未启用多线程时设置会失败，退回单线程
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+    if (workers > 1) {
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, (int)workers);
+    }
+    ZSTD_CCtx_setPledgedSrcSize(cctx, (unsigned long long)source->size);
+
+    ErrorCode result = ERR_OK;
+    size_t bound = (size_t)compressOutputBound(source->size);
+    curl_off_t offset = 0;
+    int finished = 0;
+    while (!finished) {
+        ZSTD_inBuffer in = { input, 0, 0 };
+        ZSTD_EndDirective mode = ZSTD_e_end;
+        if (offset < source->size) {
+            ssize_t n = readCompressInput(source, input, offset);
+            if (n < 0) {
+                result = ERR_FILE_IO;
+                break;
+            }
+            offset += n;
+            in.size = (size_t)n;
+            mode = offset < source->size ? ZSTD_e_continue : ZSTD_e_end;
+        }
+
+        do {
+            result = reserveCompressOutput(data, capacity, *len, COMPRESS_OUTPUT_CHUNK, bound);
+            if (result != ERR_OK) break;
+            ZSTD_outBuffer out = { *data + *len, *capacity - *len, 0 };
+            size_t remaining = ZSTD_compressStream2(cctx, &out, &in, mode);
+            *len += out.pos;
+            if (ZSTD_isError(remaining)) {
+                fprintf(stderr, "zstd 压缩失败: %s\n", ZSTD_getErrorName(remaining));
+                result = ERR_FILE_IO;
+                break;
+            }
+            finished = (mode == ZSTD_e_end && remaining == 0);
+        } while (mode == ZSTD_e_end ? !finished : in.pos < in.size);
+
+        if (result != ERR_OK) break;
+    }
+
+    ZSTD_freeCCtx(cctx);
+    return result;
+}
+#endif
+
+// 把文件压缩到内存，之后由读回调从内存上传。GitHub 的上传接口要求预先给出 Content-Length，
+// 因此压缩结果需要完整放在内存中；文件只读取一遍，不写临时文件
+static ErrorCode compressUploadSource(UploadSource *source, const UploadCompression *compression,
+                                      const char *filename) {
+    unsigned char *input = malloc(UPLOAD_BUFFER_SIZE);
+    unsigned char *data = NULL;
+    size_t capacity = 0;
+    size_t len = 0;
+    ErrorCode result;
+
+    if (!input) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    // 按大约一半的压缩率预留输出空间，不够时再扩容
+    size_t estimate = (size_t)(source->size / 2) + COMPRESS_OUTPUT_CHUNK;
+    if (estimate >= (size_t)MAX_ASSET_SIZE) estimate = (size_t)MAX_ASSET_SIZE - 1;
+    result = reserveCompressOutput(&data, &capacity, 0, estimate, estimate);
+    if (result == ERR_OK) {
+#ifdef MANAGE_WITH_ZSTD
+        if (compression->type == COMPRESS_ZSTD) {
+            result = zstdUploadSource(source, compression->level, input, &data, &capacity, &len);
+        } else
+#endif
+        result = gzipUploadSource(source, compression->level, input, &data, &capacity, &len);
+    }
+    free(input);
+
+    if (result != ERR_OK) {
+        free(data);
+        return result;
+    }
+
+    log_info("已压缩 %s: %" CURL_FORMAT_CURL_OFF_T " → %zu bytes (%.1f%%)", filename, source->size, len,
+             source->size > 0 ? 100.0 * (double)len / (double)source->size : 0.0);
+    // 等待上传期间只保留实际的压缩结果，多余的空间和预算还给后面的文件
+    if (capacity > len) {
+        unsigned char *trimmed = realloc(data, len ? len : 1);
+        if (trimmed) data = trimmed;
+    }
+    compressBudgetShrink(source, (curl_off_t)len);
+    source->data = data;
+    source->size = (curl_off_t)len;
+    return ERR_OK;
+}
+
+// ==================== 资产清单导出 ====================
+
+// 每条记录中从资产对象原样复制的字段，JSON 和 CSV 输出共用这份列表
+static const char *const ASSET_RECORD_FIELDS[] = {
+    "id", "name", "label", "size", "digest", "download_count", "state", "content_type",
+    "created_at", "updated_at", "browser_download_url"
+};
+#define ASSET_RECORD_FIELD_COUNT (sizeof(ASSET_RECORD_FIELDS) / sizeof(ASSET_RECORD_FIELDS[0]))
+
+// 边解析边输出资产记录，内存中不保留完整列表
+typedef struct {
+    ListFormat format;
+    int all_releases;    // 表格中加上 Release 列
+    FILE *out;
+    long records;
+} AssetWriter;
+
+typedef struct ListExport ListExport;
+
+// 一页列表请求：GET .../releases 或 .../releases/{id}/assets
+typedef struct {
+    ListExport *listing;
+    char *url;
+    int number;              // 页码，用于提示信息
+    MultiRequest req;
+    CURL *curl;
+    struct curl_slist *headers;
+    JsonSink sink;
+    ResponseHeaders links;
+    long seen;               // 本次尝试已解析的元素数
+    long emitted;            // 已输出的元素数，重试时跳过，避免重复的记录
+} ListPage;
+
+struct ListExport {
+    AssetWriter writer;
+    int releases_mode;       // 元素是 Release（--all-releases），否则是资产
+    long long release_id;    // 单个 Release 时每条记录的 release_id / release_tag
+    const char *release_tag;
+    ListPage **pages;
+    int page_count;
+    int page_capacity;
+    int last_known;          // 已从第 1 页的 Link rel="last" 得知总页数
+    const char *base_url;    // 分页地址的前缀，后续页在其后加上 &page=N
+    const Config *config;
+    int failed;              // 重试后仍然失败的页数
+    ErrorCode result;        // 第一个失败页的错误
+};
+
+static int parseListFormat(const char *value) {
+    if (strcmp(value, "table") == 0) return LIST_TABLE;
+    if (strcmp(value, "ndjson") == 0) return LIST_NDJSON;
+    if (strcmp(value, "json") == 0) return LIST_JSON;
+    if (strcmp(value, "csv") == 0) return LIST_CSV;
+    return -1;
+}
+
+// 解析 list 的参数：--format、--all-releases、-j、--deadline
+static ErrorCode parseListOptions(int argc, char **argv, ListOptions *options, Config *config) {
+    for (int i = 0; i < argc; i++) {
+        const char *formatValue = NULL;
+        if (strcmp(argv[i], "--format") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误：--format 需要一个格式（table、ndjson、json 或 csv）\n");
+                return ERR_CONFIG;
+            }
+            formatValue = argv[++i];
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            formatValue = argv[i] + 9;
+        }
+        if (formatValue) {
+            int format = parseListFormat(formatValue);
+            if (format < 0) {
+                fprintf(stderr, "错误：不支持的输出格式 \"%s\"（可选: table、ndjson、json、csv）\n", formatValue);
+                return ERR_CONFIG;
+            }
+            options->format = (ListFormat)format;
+            continue;
+        }
+        if (strcmp(argv[i], "--all-releases") == 0) {
+            options->all_releases = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+            if (concurrency < 0) {
+                fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                return ERR_CONFIG;
+            }
+            config->concurrency = concurrency;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--deadline") == 0) {
+            double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+            if (deadline < 0) {
+                fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                return ERR_CONFIG;
+            }
+            config->deadline = deadline;
+            i++;
+            continue;
+        }
+        fprintf(stderr, "错误：未知的 list 参数 \"%s\"\n", argv[i]);
+        return ERR_CONFIG;
+    }
+    return ERR_OK;
+}
+
+static void assetWriterBegin(AssetWriter *writer) {
+    switch (writer->format) {
+        case LIST_TABLE:
+            if (writer->all_releases) {
+                fprintf(writer->out, "%-20s %-40s %15s %15s\n", "Release", "文件名", "大小(bytes)", "下载次数");
+                fprintf(writer->out, "-----------------------------------------------------------------------------------------------\n");
+            } else {
+                fprintf(writer->out, "%-40s %15s %15s\n", "文件名", "大小(bytes)", "下载次数");
+                fprintf(writer->out, "--------------------------------------------------------------------------\n");
+            }
+            break;
+        case LIST_JSON:
+            fputc('[', writer->out);
+            break;
+        case LIST_CSV:
+            fputs("release_id,release_tag", writer->out);
+            for (size_t i = 0; i < ASSET_RECORD_FIELD_COUNT; i++) {
+                fprintf(writer->out, ",%s", ASSET_RECORD_FIELDS[i]);
+            }
+            fputc('\n', writer->out);
+            break;
+        case LIST_NDJSON:
+        default:
+            break;
+    }
+}
+
+static void assetWriterEnd(AssetWriter *writer) {
+    if (writer->format == LIST_JSON) {
+        fputs(writer->records > 0 ? "\n]\n" : "]\n", writer->out);
+    } else if (writer->format == LIST_TABLE && writer->records == 0) {
+        fprintf(writer->out, "没有找到任何文件。\n");
+    }
+    fflush(writer->out);
+}
+
+// 输出一条资产记录；字段值直接引用解析出的 JSON 对象，不做复制
+static ErrorCode writeAssetRecord(AssetWriter *writer, long long releaseId, const char *releaseTag,
+                                  struct json_object *asset) {
+    struct json_object *value;
+
+    if (writer->format == LIST_TABLE) {
+        const char *name = json_object_object_get_ex(asset, "name", &value) ? json_object_get_string(value) : NULL;
+        long long size = json_object_object_get_ex(asset, "size", &value) ? (long long)json_object_get_int64(value) : 0;
+        long long downloads = json_object_object_get_ex(asset, "download_count", &value)
+                              ? (long long)json_object_get_int64(value) : 0;
+        if (writer->all_releases) {
+            fprintf(writer->out, "%-20s ", releaseTag ? releaseTag : "");
+        }
+        fprintf(writer->out, "%-40s %15lld %15lld\n", name ? name : "", size, downloads);
+        writer->records++;
+        return ERR_OK;
+    }
+
+    if (writer->format == LIST_CSV) {
+        fprintf(writer->out, "%lld,", releaseId);
+        csvField(writer->out, releaseTag);
+        for (size_t i = 0; i < ASSET_RECORD_FIELD_COUNT; i++) {
+            fputc(',', writer->out);
+            if (json_object_object_get_ex(asset, ASSET_RECORD_FIELDS[i], &value) && value) {
+                csvField(writer->out, json_object_get_string(value));
+            }
+        }
+        fputc('\n', writer->out);
+        writer->records++;
+        return ERR_OK;
+    }
+
+    struct json_object *record = json_object_new_object();
+    if (!record) {
+        return ERR_MEMORY;
+    }
+    json_object_object_add(record, "release_id", json_object_new_int64(releaseId));
+    json_object_object_add(record, "release_tag", releaseTag ? json_object_new_string(releaseTag) : NULL);
+    for (size_t i = 0; i < ASSET_RECORD_FIELD_COUNT; i++) {
+        value = NULL;
+        json_object_object_get_ex(asset, ASSET_RECORD_FIELDS[i], &value);
+        json_object_object_add(record, ASSET_RECORD_FIELDS[i], json_object_get(value));
+    }
+
+    const char *text = json_object_to_json_string_ext(record, JSON_C_TO_STRING_PLAIN);
+    if (writer->format == LIST_JSON) {
+        fputs(writer->records > 0 ? ",\n" : "\n", writer->out);
+        fputs(text, writer->out);
+    } else {
+        fprintf(writer->out, "%s\n", text);
+    }
+    json_object_put(record);
+    writer->records++;
+    return ERR_OK;
+}
+
+// 列表页中每个元素的回调：资产直接输出，Release 则输出其中的全部资产
+static int exportListElement(struct json_object *element, void *userp) {
+    ListPage *page = (ListPage *)userp;
+    ListExport *listing = page->listing;
+    ErrorCode result = ERR_OK;
+
+    // 重试时跳过上一次尝试已经输出过的元素
+    if (page->seen++ < page->emitted) {
+        return 0;
+    }
+    page->emitted++;
+
+    if (!listing->releases_mode) {
+        result = writeAssetRecord(&listing->writer, listing->release_id, listing->release_tag, element);
+    } else {
+        struct json_object *value;
+        long long releaseId = json_object_object_get_ex(element, "id", &value)
+                              ? (long long)json_object_get_int64(value) : 0;
+        const char *tag = json_object_object_get_ex(element, "tag_name", &value)
+                          ? json_object_get_string(value) : NULL;
+        struct json_object *assets;
+        if (json_object_object_get_ex(element, "assets", &assets) &&
+            json_object_is_type(assets, json_type_array)) {
+            int count = json_object_array_length(assets);
+            for (int i = 0; i < count && result == ERR_OK; i++) {
+                result = writeAssetRecord(&listing->writer, releaseId, tag, json_object_array_get_idx(assets, i));
+            }
+        }
+    }
+
+    if (result != ERR_OK) {
+        page->sink.error = result;
+        return 1;
+    }
+    return 0;
+}
+
+static ListPage* addListPage(ListExport *listing, const char *url, int number, const Config *config) {
+    if (listing->page_count == listing->page_capacity) {
+        int capacity = listing->page_capacity ? listing->page_capacity * 2 : 16;
+        ListPage **pages = realloc(listing->pages, capacity * sizeof(ListPage *));
+        if (!pages) {
+            return NULL;
+        }
+        listing->pages = pages;
+        listing->page_capacity = capacity;
+    }
+
+    ListPage *page = calloc(1, sizeof(ListPage));
+    if (!page) {
+        return NULL;
+    }
+    page->url = arenaStrdup(commandArena(config), url);
+    if (!page->url) {
+        free(page);
+        return NULL;
+    }
+    page->listing = listing;
+    page->number = number;
+    page->req.item = page;
+    page->req.label = page->url;
+    initRetryState(&page->req.retry, config->deadline);
+    listing->pages[listing->page_count++] = page;
+    return page;
+}
+
+// 取出分页地址中的 page 参数，没有时返回 0
+static int linkPageNumber(const char *url) {
+    for (const char *p = strchr(url, '?'); p; p = strchr(p + 1, '&')) {
+        if (strncmp(p + 1, "page=", 5) == 0) {
+            return atoi(p + 6);
+        }
+    }
+    return 0;
+}
+
+// 一页成功后加入后续的页：第 1 页带有 rel="last" 时一次加入全部剩余页并发获取，
+// 否则只能顺着 rel="next" 逐页获取
+static ErrorCode queueFollowingPages(ListExport *listing, ListPage *page, const char *baseUrl,
+                                     const Config *config) {
+    if (page->number == 1 && page->links.last_url) {
+        int lastPage = linkPageNumber(page->links.last_url);
+        if (lastPage > 1) {
+            listing->last_known = 1;
+            for (int n = 2; n <= lastPage; n++) {
+                char *url = arenaPrintf(commandArena(config), "%s&page=%d", baseUrl, n);
+                if (!url || !addListPage(listing, url, n, config)) {
+                    return ERR_MEMORY;
+                }
+            }
+            log_debug("共 %d 页，并发获取剩余的页", lastPage);
+            return ERR_OK;
+        }
+    }
+    if (!listing->last_known && page->links.next_url) {
+        if (!addListPage(listing, page->links.next_url, page->number + 1, config)) {
+            return ERR_MEMORY;
+        }
+    }
+    return ERR_OK;
+}
+
+static ErrorCode startListPage(CURLM *multi, ListPage *page, const Config *config) {
+    if (initJsonSink(&page->sink, exportListElement, page) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    page->seen = 0;
+    freeResponseHeaders(&page->links);
+
+    page->curl = acquireCurlHandle();
+    if (!page->curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    page->headers = setGithubHeaders(commandArena(config), config->token, NULL);
+    if (!page->headers) {
+        fprintf(stderr, "添加header失败\n");
+        return ERR_MEMORY;
+    }
+
+    curl_easy_setopt(page->curl, CURLOPT_URL, page->url);
+    curl_easy_setopt(page->curl, CURLOPT_HTTPHEADER, page->headers);
+    curl_easy_setopt(page->curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(page->curl, CURLOPT_WRITEFUNCTION, JsonSinkWriteCallback);
+    curl_easy_setopt(page->curl, CURLOPT_WRITEDATA, (void *)&page->sink);
+    curl_easy_setopt(page->curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(page->curl, CURLOPT_HEADERDATA, (void *)&page->links);
+    applyRequestDeadline(page->curl, page->req.retry.deadline);
+
+    if (curl_multi_add_handle(multi, page->curl) != CURLM_OK) {
+        fprintf(stderr, "添加传输任务失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    log_debug("获取第 %d 页: %s", page->number, page->url);
+    return ERR_OK;
+}
+
+// 释放一页本次尝试的 curl 句柄和解析器
+static void releaseListAttempt(CURLM *multi, ListPage *page) {
+    if (page->curl) {
+        if (multi) curl_multi_remove_handle(multi, page->curl);
+        releaseCurlHandle(page->curl);
+        page->curl = NULL;
+    }
+    if (page->headers) {
+        curl_slist_free_all(page->headers);
+        page->headers = NULL;
+    }
+    freeJsonSink(&page->sink);
+}
+
+static ErrorCode finishListPage(ListPage *page, CURLcode res) {
+    if (res != CURLE_OK) {
+        if (res == CURLE_WRITE_ERROR && page->sink.error != ERR_OK) {
+            fprintf(stderr, "解析第 %d 页失败\n", page->number);
+            return page->sink.error;
+        }
+        fprintf(stderr, "获取第 %d 页失败: %s\n", page->number, curl_easy_strerror(res));
+        return ERR_CURL_PERFORM;
+    }
+
+    long response_code = 0;
+    curl_easy_getinfo(page->curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        fprintf(stderr, "获取第 %d 页失败，HTTP错误: %ld\n", page->number, response_code);
+        rateLimitObserveBody(response_code, jsonSinkMessage(&page->sink));
+        return ERR_HTTP_ERROR;
+    }
+
+    ErrorCode result = finishJsonSink(&page->sink);
+    if (result != ERR_OK) {
+        fprintf(stderr, "解析第 %d 页失败\n", page->number);
+        return result;
+    }
+    if (page->sink.root) {
+        fprintf(stderr, "第 %d 页的响应不是数组\n", page->number);
+        return ERR_JSON_TYPE;
+    }
+    return ERR_OK;
+}
+
+// runMultiRequests 的回调，ctx 是 ListExport
+static int listPageCount(void *ctx) {
+    return ((ListExport *)ctx)->page_count;
+}
+
+static MultiRequest *listPageRequest(void *ctx, int index) {
+    return &((ListExport *)ctx)->pages[index]->req;
+}
+
+static ErrorCode listPageStart(CURLM *multi, void *item, void *ctx, CURL **out_curl) {
+    ListPage *page = item;
+    ErrorCode result = startListPage(multi, page, ((ListExport *)ctx)->config);
+    *out_curl = page->curl;
+    return result;
+}
+
+static ErrorCode listPageFinish(void *item, CURLcode res, void *ctx) {
+    (void)ctx;
+    return finishListPage(item, res);
+}
+
+static void listPageRelease(CURLM *multi, void *item) {
+    releaseListAttempt(multi, item);
+}
+
+// 成功的页加入后续的页；内存不足时中止，失败的页只计数，其余页继续获取
+static ErrorCode listPageDone(void *item, ErrorCode result, void *ctx) {
+    ListPage *page = item;
+    ListExport *listing = ctx;
+
+    if (result != ERR_OK) {
+        listing->failed++;
+        if (listing->result == ERR_OK) listing->result = result;
+        return ERR_OK;
+    }
+    if (queueFollowingPages(listing, page, listing->base_url, listing->config) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    freeResponseHeaders(&page->links);
+    return ERR_OK;
+}
+
+// 流式导出资产清单：每页的响应边接收边解析，每解析出一个资产立即输出一条记录。
+// --all-releases 时遍历 Release 列表的所有页，第 1 页之后的页并发获取，因此不同页的记录
+// 可能交错输出；失败的页按 planRetry 重试，已输出的记录不会重复
+static ErrorCode exportAssets(const ListOptions *options, const Config *config) {
+    ListExport listing = {0};
+    ErrorCode result;
+    char *baseUrl;
+
+    if (!options->all_releases && validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    listing.writer.format = options->format;
+    listing.writer.all_releases = options->all_releases;
+    listing.writer.out = stdout;
+    listing.releases_mode = options->all_releases;
+    listing.config = config;
+
+    if (options->all_releases) {
+        baseUrl = create_url(commandArena(config), "%s/repos/%s/%s/releases?per_page=%d",
+                             config->api_base, config->owner, config->repo, RELEASES_PER_PAGE);
+    } else {
+        ReleaseCache *cache = config->release_cache;
+        listing.release_id = strtoll(config->release_id, NULL, 10);
+        listing.release_tag = config->tag_name;
+        if (cache && cache->loaded && strcmp(cache->release_id, config->release_id) == 0 && cache->tag_name) {
+            listing.release_tag = cache->tag_name;
+        }
+        baseUrl = create_url(commandArena(config), "%s/repos/%s/%s/releases/%s/assets?per_page=%d",
+                             config->api_base, config->owner, config->repo, config->release_id,
+                             RELEASES_PER_PAGE);
+    }
+    listing.base_url = baseUrl;
+    if (!baseUrl || !addListPage(&listing, baseUrl, 1, config)) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    MultiRequestOps ops = {
+        .ctx = &listing,
+        .concurrency = config->concurrency > 1 ? config->concurrency : LIST_PAGE_CONCURRENCY,
+        .count = listPageCount,
+        .request = listPageRequest,
+        .start = listPageStart,
+        .finish = listPageFinish,
+        .release = listPageRelease,
+        .done = listPageDone,
+    };
+
+    assetWriterBegin(&listing.writer);
+    result = runMultiRequests(&ops);
+    if (result == ERR_OK) {
+        assetWriterEnd(&listing.writer);
+        log_debug("共输出 %ld 条资产记录（%d 页）", listing.writer.records, listing.page_count);
+        if (listing.failed > 0) {
+            fprintf(stderr, "错误：%d 页获取失败，输出的清单不完整\n", listing.failed);
+        }
+        result = listing.result;
+    }
+
+    for (int i = 0; i < listing.page_count; i++) {
+        freeResponseHeaders(&listing.pages[i]->links);
+        free(listing.pages[i]);
+    }
+    free(listing.pages);
+    return result;
+}
+
+// ==================== 批量任务文件（apply） ====================
+
+// 任务文件格式（concurrency 可省略，也可以直接写任务数组）：
+//   {"concurrency": 8,
+//    "jobs": [{"repo": "owner/repo", "tag": "v1.0", "files": ["a.zip", "*.tar.gz"], "replace": true}]}
+// repo 可以只写仓库名，owner 另用 "owner" 字段或沿用 GITHUB_OWNER；省略 tag 时使用最新的 Release；
+// replace 为 true 时先删除同名的旧资产（与 update 相同）。files 的通配符规则与 upload 的文件参数相同
+
+// 一个上传目标：某个仓库的某个 Release。指向同一 Release 的任务共用一个目标，
+// 每个目标有自己的 Config 和 Release 缓存，上传任务通过 task->config 指向它
+typedef struct {
+    Config config;
+    ReleaseCache cache;
+    const char *label;           // "owner/repo@tag"，用于提示信息
+    MultiRequest req;
+    CURL *curl;
+    struct curl_slist *headers;
+    ResponseHeaders links;
+    JsonSink sink;
+    char *url;
+    ErrorCode result;
+    int tagMissing;              // releases/tags 返回 404，需要逐页扫描（草稿 Release）
+    int success;
+    int failed;
+} ApplyTarget;
+
+typedef struct {
+    ApplyTarget **targets;
+    int count;
+    int capacity;
+} ApplyTargetList;
+
+// 任务文件中展开出的一个文件，Release 解析之后才变成上传任务
+typedef struct {
+    char *path;
+    ApplyTarget *target;
+    int replace;
+} ApplyFile;
+
+typedef struct {
+    ApplyFile *items;
+    int count;
+    int capacity;
+} ApplyFileList;
+
+// 解析 "files"：字符串或字符串数组，展开通配符后加入文件列表
+static ErrorCode collectJobFiles(struct json_object *files, ApplyTarget *target, int replace,
+                                 ApplyFileList *list) {
+    int total = json_object_is_type(files, json_type_array) ? (int)json_object_array_length(files) : 1;
+
+    for (int i = 0; i < total; i++) {
+        struct json_object *item = json_object_is_type(files, json_type_array)
+                                   ? json_object_array_get_idx(files, i) : files;
+        if (!json_object_is_type(item, json_type_string)) {
+            fprintf(stderr, "任务文件错误：files 只能包含字符串\n");
+            return ERR_CONFIG;
+        }
+
+        char **matched = NULL;
+        int matchedCount = expandWildcards(json_object_get_string(item), &matched);
+        if (matchedCount < 0) {
+            fprintf(stderr, "内存分配失败\n");
+            return ERR_MEMORY;
+        }
+        if (matchedCount == 0) {
+            fprintf(stderr, "警告：\"%s\" 没有匹配的文件\n", json_object_get_string(item));
+            continue;
+        }
+
+        if (list->count + matchedCount > list->capacity) {
+            int capacity = list->capacity ? list->capacity : 16;
+            while (capacity < list->count + matchedCount) capacity *= 2;
+            ApplyFile *grown = realloc(list->items, capacity * sizeof(ApplyFile));
+            if (!grown) {
+                for (int j = 0; j < matchedCount; j++) {
+                    free(matched[j]);
+                }
+                free(matched);
+                fprintf(stderr, "内存分配失败\n");
+                return ERR_MEMORY;
+            }
+            list->items = grown;
+            list->capacity = capacity;
+        }
+        for (int j = 0; j < matchedCount; j++) {
+            ApplyFile *file = &list->items[list->count++];
+            file->path = matched[j];
+            file->target = target;
+            file->replace = replace;
+        }
+        free(matched);
+    }
+    return ERR_OK;
+}
+
+// 取出任务中的字符串字段，不存在时使用 fallback；类型不对时返回 ERR_CONFIG，
+// 不能当作缺省值处理（tag 为 NULL 表示最新 Release）
+static ErrorCode jobString(struct json_object *job, int index, const char *key,
+                           const char *fallback, const char **out) {
+    struct json_object *value;
+    *out = fallback;
+    if (!json_object_object_get_ex(job, key, &value) || !value) {
+        return ERR_OK;
+    }
+    if (!json_object_is_type(value, json_type_string)) {
+        fprintf(stderr, "任务文件错误：第 %d 个任务的 %s 应为字符串\n", index + 1, key);
+        return ERR_CONFIG;
+    }
+    *out = json_object_get_string(value);
+    return ERR_OK;
+}
+
+static int sameOptionalString(const char *a, const char *b) {
+    return (!a || !b) ? a == b : strcmp(a, b) == 0;
+}
+
+// 找到（必要时创建）owner/repo@tag 对应的目标
+static ApplyTarget* findApplyTarget(ApplyTargetList *list, const Config *base, const char *owner,
+                                    const char *repo, const char *tag) {
+    for (int i = 0; i < list->count; i++) {
+        ApplyTarget *target = list->targets[i];
+        if (strcmp(target->config.owner, owner) == 0 && strcmp(target->config.repo, repo) == 0 &&
+            sameOptionalString(target->config.tag_name, tag)) {
+            return target;
+        }
+    }
+
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        ApplyTarget **grown = realloc(list->targets, capacity * sizeof(ApplyTarget *));
+        if (!grown) return NULL;
+        list->targets = grown;
+        list->capacity = capacity;
+    }
+
+    ApplyTarget *target = calloc(1, sizeof(ApplyTarget));
+    if (!target) return NULL;
+    target->config = *base;
+    target->config.owner = owner;
+    target->config.repo = repo;
+    target->config.tag_name = tag;
+    target->config.release_id = NULL;
+    target->config.release_cache = &target->cache;
+    target->label = arenaPrintf(commandArena(base), "%s/%s@%s", owner, repo, tag ? tag : "latest");
+    if (!target->label) {
+        free(target);
+        return NULL;
+    }
+    target->req.item = target;
+    initRetryState(&target->req.retry, base->deadline);
+    list->targets[list->count++] = target;
+    return target;
+}
+
+// 读取任务文件，建立目标列表和文件列表。目标中的 owner/repo/tag 直接引用 JSON 中的字符串，
+// 调用者在用完目标之后再释放 out_root
+static ErrorCode loadJobFile(const char *path, const Config *config, struct json_object **out_root,
+                             int *out_concurrency, ApplyTargetList *targets, ApplyFileList *files) {
+    struct json_object *root = json_object_from_file(path);
+    struct json_object *jobs = root;
+    struct json_object *value;
+    ErrorCode result = ERR_OK;
+
+    *out_root = root;
+    *out_concurrency = 0;
+    if (!root) {
+        fprintf(stderr, "无法读取任务文件: %s\n", path);
+        return ERR_JSON_PARSE;
+    }
+
+    if (json_object_is_type(root, json_type_object)) {
+        if (json_object_object_get_ex(root, "concurrency", &value)) {
+            int concurrency = json_object_is_type(value, json_type_int) ? json_object_get_int(value) : -1;
+            if (concurrency < 1 || concurrency > MAX_CONCURRENCY) {
+                fprintf(stderr, "任务文件错误：concurrency 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                return ERR_CONFIG;
+            }
+            *out_concurrency = concurrency;
+        }
+        if (!json_object_object_get_ex(root, "jobs", &jobs)) {
+            jobs = NULL;
+        }
+    }
+    if (!jobs || !json_object_is_type(jobs, json_type_array)) {
+        fprintf(stderr, "任务文件错误：需要 jobs 数组\n");
+        return ERR_JSON_TYPE;
+    }
+
+    int jobCount = json_object_array_length(jobs);
+    for (int i = 0; i < jobCount && result == ERR_OK; i++) {
+        struct json_object *job = json_object_array_get_idx(jobs, i);
+        if (!json_object_is_type(job, json_type_object)) {
+            fprintf(stderr, "任务文件错误：第 %d 个任务不是对象\n", i + 1);
+            return ERR_JSON_TYPE;
+        }
+
+        const char *owner, *repo, *tag;
+        if (jobString(job, i, "owner", config->owner, &owner) != ERR_OK ||
+            jobString(job, i, "repo", config->repo, &repo) != ERR_OK ||
+            jobString(job, i, "tag", config->tag_name, &tag) != ERR_OK) {
+            return ERR_CONFIG;
+        }
+
+        // "owner/repo" 写法
+        const char *slash = repo ? strchr(repo, '/') : NULL;
+        if (slash) {
+            owner = arenaPrintf(commandArena(config), "%.*s", (int)(slash - repo), repo);
+            repo = slash + 1;
+        }
+        if (!owner || !*owner || !repo || !*repo) {
+            fprintf(stderr, "任务文件错误：第 %d 个任务缺少 owner 或 repo\n", i + 1);
+            return ERR_CONFIG;
+        }
+
+        int replace = 0;
+        if (json_object_object_get_ex(job, "replace", &value)) {
+            if (!json_object_is_type(value, json_type_boolean)) {
+                fprintf(stderr, "任务文件错误：第 %d 个任务的 replace 应为 true 或 false\n", i + 1);
+                return ERR_CONFIG;
+            }
+            replace = json_object_get_boolean(value);
+        }
+        if (!json_object_object_get_ex(job, "files", &value)) {
+            fprintf(stderr, "任务文件错误：第 %d 个任务缺少 files\n", i + 1);
+            return ERR_CONFIG;
+        }
+
+        ApplyTarget *target = findApplyTarget(targets, config, owner, repo, tag);
+        if (!target) {
+            fprintf(stderr, "内存分配失败\n");
+            return ERR_MEMORY;
+        }
+
+        result = collectJobFiles(value, target, replace, files);
+    }
+    return result;
+}
+
+static ErrorCode startApplyTarget(CURLM *multi, ApplyTarget *target) {
+    const Config *config = &target->config;
+
+    if (!target->url) {
+        if (config->tag_name) {
+            char *escaped = curl_easy_escape(NULL, config->tag_name, 0);
+            if (!escaped) {
+                fprintf(stderr, "内存分配失败\n");
+                return ERR_MEMORY;
+            }
+            target->url = create_url(commandArena(config), "%s/repos/%s/%s/releases/tags/%s",
+                                     config->api_base, config->owner, config->repo, escaped);
+            curl_free(escaped);
+        } else {
+            target->url = create_url(commandArena(config), "%s/repos/%s/%s/releases?per_page=1",
+                                     config->api_base, config->owner, config->repo);
+        }
+        if (!target->url) {
+            fprintf(stderr, "URL 分配失败\n");
+            return ERR_MEMORY;
+        }
+        target->req.label = target->url;
+    }
+
+    if (initJsonSink(&target->sink, NULL, NULL) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    target->curl = acquireCurlHandle();
+    if (!target->curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    target->headers = setGithubHeaders(commandArena(config), config->token, NULL);
+    if (!target->headers) {
+        fprintf(stderr, "添加header失败\n");
+        return ERR_MEMORY;
+    }
+
+    curl_easy_setopt(target->curl, CURLOPT_URL, target->url);
+    curl_easy_setopt(target->curl, CURLOPT_HTTPHEADER, target->headers);
+    curl_easy_setopt(target->curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(target->curl, CURLOPT_WRITEFUNCTION, JsonSinkWriteCallback);
+    curl_easy_setopt(target->curl, CURLOPT_WRITEDATA, (void *)&target->sink);
+    curl_easy_setopt(target->curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(target->curl, CURLOPT_HEADERDATA, (void *)&target->links);
+    applyRequestDeadline(target->curl, target->req.retry.deadline);
+
+    if (curl_multi_add_handle(multi, target->curl) != CURLM_OK) {
+        fprintf(stderr, "添加传输任务失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    log_debug("解析 %s: %s", target->label, target->url);
+    return ERR_OK;
+}
+
+static void releaseApplyAttempt(CURLM *multi, ApplyTarget *target) {
+    if (target->curl) {
+        if (multi) curl_multi_remove_handle(multi, target->curl);
+        releaseCurlHandle(target->curl);
+        target->curl = NULL;
+    }
+    if (target->headers) {
+        curl_slist_free_all(target->headers);
+        target->headers = NULL;
+    }
+    freeResponseHeaders(&target->links);
+    freeJsonSink(&target->sink);
+}
+
+// 用解析出的 Release 对象填充目标的 release_id 和缓存
+static ErrorCode loadApplyRelease(ApplyTarget *target, struct json_object *release) {
+    struct json_object *id_obj;
+    if (!json_object_object_get_ex(release, "id", &id_obj) || !json_object_is_type(id_obj, json_type_int)) {
+        fprintf(stderr, "%s: 无法获取release id\n", target->label);
+        return ERR_JSON_TYPE;
+    }
+
+    char id[32];
+    snprintf(id, sizeof(id), "%lld", (long long)json_object_get_int64(id_obj));
+    target->config.release_id = strdup(id);
+    if (!target->config.release_id) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    return releaseCacheLoadJson(&target->cache, id, release);
+}
+
+static ErrorCode finishApplyTarget(ApplyTarget *target, CURLcode res) {
+    if (res != CURLE_OK) {
+        if (res == CURLE_WRITE_ERROR && target->sink.error != ERR_OK) {
+            fprintf(stderr, "%s: 解析JSON失败\n", target->label);
+            return target->sink.error;
+        }
+        fprintf(stderr, "%s: 获取Release失败: %s\n", target->label, curl_easy_strerror(res));
+        return ERR_CURL_PERFORM;
+    }
+
+    long response_code = 0;
+    curl_easy_getinfo(target->curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code == 404 && target->config.tag_name) {
+        // tags 接口不返回草稿 Release，之后逐页扫描
+        target->tagMissing = 1;
+        return ERR_OK;
+    }
+    if (response_code >= 400) {
+        fprintf(stderr, "%s: 获取Release失败，HTTP错误: %ld\n", target->label, response_code);
+        rateLimitObserveBody(response_code, jsonSinkMessage(&target->sink));
+        return ERR_HTTP_ERROR;
+    }
+
+    ErrorCode result = finishJsonSink(&target->sink);
+    if (result != ERR_OK) {
+        fprintf(stderr, "%s: 解析JSON失败\n", target->label);
+        return result;
+    }
+
+    struct json_object *release = target->sink.root;
+    if (json_object_is_type(release, json_type_array)) {
+        if (json_object_array_length(release) == 0) {
+            fprintf(stderr, "%s: 没有找到任何releases\n", target->label);
+            return ERR_NOT_FOUND;
+        }
+        release = json_object_array_get_idx(release, 0);
+    }
+    return loadApplyRelease(target, release);
+}
+
+// runMultiRequests 的回调，ctx 是 ApplyTargetList
+static int applyTargetCount(void *ctx) {
+    return ((ApplyTargetList *)ctx)->count;
+}
+
+static MultiRequest *applyTargetRequest(void *ctx, int index) {
+    return &((ApplyTargetList *)ctx)->targets[index]->req;
+}
+
+static ErrorCode applyTargetStart(CURLM *multi, void *item, void *ctx, CURL **out_curl) {
+    ApplyTarget *target = item;
+    (void)ctx;
+    ErrorCode result = startApplyTarget(multi, target);
+    *out_curl = target->curl;
+    return result;
+}
+
+static ErrorCode applyTargetFinish(void *item, CURLcode res, void *ctx) {
+    (void)ctx;
+    return finishApplyTarget(item, res);
+}
+
+static void applyTargetRelease(CURLM *multi, void *item) {
+    releaseApplyAttempt(multi, item);
+}
+
+static ErrorCode applyTargetDone(void *item, ErrorCode result, void *ctx) {
+    (void)ctx;
+    ((ApplyTarget *)item)->result = result;
+    return ERR_OK;
+}
+
+// 并发解析所有目标的 Release，结果直接载入各目标的 Release 缓存
+static ErrorCode resolveApplyTargets(ApplyTargetList *list, const Config *config) {
+    MultiRequestOps ops = {
+        .ctx = list,
+        .concurrency = config->concurrency > 1 ? config->concurrency : APPLY_RESOLVE_CONCURRENCY,
+        .count = applyTargetCount,
+        .request = applyTargetRequest,
+        .start = applyTargetStart,
+        .finish = applyTargetFinish,
+        .release = applyTargetRelease,
+        .done = applyTargetDone,
+    };
+    ErrorCode result = runMultiRequests(&ops);
+
+    // 草稿 Release 只能逐页扫描列表找到，这种情况很少，逐个处理
+    for (int i = 0; i < list->count && result == ERR_OK; i++) {
+        ApplyTarget *target = list->targets[i];
+        if (target->result != ERR_OK || !target->tagMissing) continue;
+
+        struct json_object *release = NULL;
+        target->result = findReleaseByScan(&target->config, target->config.tag_name, &release);
+        if (target->result == ERR_OK) {
+            target->result = loadApplyRelease(target, release);
+        } else {
+            fprintf(stderr, "%s: 找不到该 tag 的 Release\n", target->label);
+        }
+        json_object_put(release);
+    }
+    return result;
+}
+
+// manage apply [-j N] [--deadline S] <任务文件>：先并发解析任务涉及的所有 Release，
+// 再把全部文件放进同一个上传引擎，共用连接池和并发上限
+static ErrorCode applyJobFile(int argc, char **argv, const Config *base) {
+    Config config = *base;
+    const char *jobPath = NULL;
+    struct json_object *root = NULL;
+    ApplyTargetList targets = {0};
+    ApplyFileList files = {0};
+    UploadTaskList tasks = {0};
+    int jobsOption = 0;
+    int fileConcurrency = 0;
+    int unresolved = 0;
+    int skipped = 0;
+    ErrorCode result = ERR_OK;
+
+    for (int i = 0; i < argc; i++) {
+        int queueArgs = parseUploadQueueOption(argc, argv, i, &config, NULL);
+        if (queueArgs < 0) {
+            return ERR_CONFIG;
+        }
+        if (queueArgs > 0) {
+            i += queueArgs - 1; // 跳过选项的参数
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+            if (concurrency < 0) {
+                fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                return ERR_CONFIG;
+            }
+            config.concurrency = concurrency;
+            jobsOption = 1;
+            i++; // 跳过下一个参数
+        } else if (strcmp(argv[i], "--deadline") == 0) {
+            double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+            if (deadline < 0) {
+                fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                return ERR_CONFIG;
+            }
+            config.deadline = deadline;
+            i++; // 跳过下一个参数
+        } else if (!jobPath) {
+            jobPath = argv[i];
+        } else {
+            fprintf(stderr, "错误：只能指定一个任务文件\n");
+            return ERR_CONFIG;
+        }
+    }
+    if (!jobPath) {
+        fprintf(stderr, "错误：请提供任务文件。\n");
+        return ERR_CONFIG;
+    }
+
+    // 目标的 Config 从这里复制，--deadline 对所有目标有效
+    result = loadJobFile(jobPath, &config, &root, &fileConcurrency, &targets, &files);
+    if (result != ERR_OK) {
+        goto cleanup;
+    }
+    if (files.count == 0) {
+        fprintf(stderr, "错误：找不到匹配的文件\n");
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
+    // 命令行的 -j 优先于任务文件中的 concurrency
+    if (fileConcurrency > 0 && !jobsOption) {
+        config.concurrency = fileConcurrency;
+    }
+
+    printf("解析 %d 个 Release...\n", targets.count);
+    result = resolveApplyTargets(&targets, &config);
+    if (result != ERR_OK) {
+        goto cleanup;
+    }
+    for (int i = 0; i < targets.count; i++) {
+        ApplyTarget *target = targets.targets[i];
+        if (target->result == ERR_OK) {
+            printf("  %s → Release ID: %s\n", target->label, target->config.release_id);
+        } else {
+            printf("  %s → 解析失败，跳过其中的文件\n", target->label);
+            unresolved++;
+        }
+    }
+    printf("\n");
+
+    // 解析失败的 Release 中的文件不上传；replace 的文件对照缓存找出旧资产，同名资产只删除一次
+    for (int i = 0; i < files.count; i++) {
+        ApplyFile *file = &files.items[i];
+        if (file->target->result != ERR_OK) {
+            file->target->failed++;
+            skipped++;
+            continue;
+        }
+
+        UploadTask *task = appendUploadTask(&tasks, &file->target->config, file->path,
+                                            getFilenameFromPath(file->path));
+        if (!task) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+
+        ReleaseAsset *asset = file->replace ? releaseCacheFind(&file->target->cache, task->fileName) : NULL;
+        if (asset) {
+            int duplicate = 0;
+            for (int j = 0; j < tasks.count - 1 && !duplicate; j++) {
+                duplicate = (tasks.items[j]->config == task->config &&
+                             tasks.items[j]->replaceAssetId == asset->id);
+            }
+            if (!duplicate) {
+                task->replaceAssetId = asset->id;
+            }
+        }
+    }
+
+    if (tasks.count > 0) {
+        result = runUploadTasks(&tasks, NULL, &config, "上传");
+    }
+
+    // 任务按文件顺序创建，跳过的文件没有任务
+    for (int i = 0, t = 0; i < files.count; i++) {
+        ApplyTarget *target = files.items[i].target;
+        if (target->result != ERR_OK) continue;
+        if (tasks.items[t++]->result == ERR_OK) {
+            target->success++;
+        } else {
+            target->failed++;
+        }
+    }
+
+    printf("\n各 Release 的结果:\n");
+    for (int i = 0; i < targets.count; i++) {
+        ApplyTarget *target = targets.targets[i];
+        printf("  %-40s 成功 %d，失败 %d\n", target->label, target->success, target->failed);
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "错误：%d 个 Release 解析失败，其中的 %d 个文件未上传\n", unresolved, skipped);
+        if (result == ERR_OK) result = ERR_NOT_FOUND;
+    }
+
+cleanup:
+    freeUploadTaskList(&tasks);
+    for (int i = 0; i < files.count; i++) {
+        free(files.items[i].path);
+    }
+    free(files.items);
+    for (int i = 0; i < targets.count; i++) {
+        releaseCacheClear(&targets.targets[i]->cache);
+        free(targets.targets[i]->config.release_id);
+        free(targets.targets[i]);
+    }
+    free(targets.targets);
+    if (root) json_object_put(root);
+    return result;
+}
+
+// ==================== 守护进程（serve） ====================
+
+// 客户端发给守护进程的请求头。随后是 length 字节的字符串，各以 '\0' 结尾：
+// 工作目录、argc 个命令参数、envc 个 "名称=值" 形式的环境变量。客户端的 stdout 和
+// stderr 通过 SCM_RIGHTS 随请求头一起传递，命令直接输出到客户端；执行完后守护进程
+// 回复一个 int32 退出码
+typedef struct {
+    uint32_t magic;
+    uint32_t argc;
+    uint32_t envc;
+    uint32_t length;
+} ServeRequest;
+
+// 转发给守护进程的环境变量，客户端设置时覆盖守护进程启动时的值。
+// token 和 API 地址始终使用守护进程自己的配置
+static const char *const SERVE_FORWARDED_ENV[] = {
+    "GITHUB_OWNER", "GITHUB_REPO", "GITHUB_TAG", "MANAGE_CONCURRENCY", "MANAGE_DEADLINE", "MANAGE_LIMIT_RATE",
+    "MANAGE_SPEED_LIMIT", "MANAGE_SPEED_TIME"
+};
+#define SERVE_FORWARDED_ENV_COUNT (sizeof(SERVE_FORWARDED_ENV) / sizeof(SERVE_FORWARDED_ENV[0]))
+
+// 守护进程在任务之间保留的状态。连接池和 Release 缓存在 Config 中；
+// 最近一次解析的 owner/repo@tag 在 cache_ttl 秒内直接沿用，不再请求 API
+typedef struct {
+    char *warm_key;
+    char *warm_release;
+    double warm_at;
+    double cache_ttl;
+    int saved_stdout;
+    int saved_stderr;
+    int saved_cwd;
+} ServeState;
+
+static volatile sig_atomic_t serve_stopping = 0;
+
+static void serveSignalHandler(int sig) {
+    (void)sig;
+    serve_stopping = 1;
+}
+
+static ErrorCode readFully(int fd, void *data, size_t len) {
+    char *p = (char *)data;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return ERR_FILE_IO;
+        p += n;
+        len -= (size_t)n;
+    }
+    return ERR_OK;
+}
+
+static ErrorCode writeFully(int fd, const void *data, size_t len) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return ERR_FILE_IO;
+        p += n;
+        len -= (size_t)n;
+    }
+    return ERR_OK;
+}
+
+static int fillUnixAddress(struct sockaddr_un *addr, const char *path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "错误：socket 路径过长: %s\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+// 把命令（argv[0] 为命令名）交给守护进程执行并等待退出码。
+// 连接不上守护进程时返回 ERR_NOT_FOUND，调用者可以改为在本进程中执行
+static ErrorCode forwardToDaemon(const char *socketPath, int argc, char **argv, int *exitCode) {
+    struct sockaddr_un addr;
+    ErrorCode result = ERR_OK;
+    char *payload = NULL;
+    char *cwd = NULL;
+    int fd = -1;
+
+    if (fillUnixAddress(&addr, socketPath) != 0) {
+        return ERR_CONFIG;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return ERR_NOT_FOUND;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return ERR_NOT_FOUND;
+    }
+
+    cwd = getcwd(NULL, 0);
+    if (!cwd) {
+        fprintf(stderr, "错误：无法获取当前目录: %s\n", strerror(errno));
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
+
+    size_t length = strlen(cwd) + 1;
+    uint32_t envc = 0;
+    for (int i = 0; i < argc; i++) {
+        length += strlen(argv[i]) + 1;
+    }
+    for (size_t i = 0; i < SERVE_FORWARDED_ENV_COUNT; i++) {
+        const char *value = getenv(SERVE_FORWARDED_ENV[i]);
+        if (value) {
+            length += strlen(SERVE_FORWARDED_ENV[i]) + strlen(value) + 2;
+            envc++;
+        }
+    }
+    if (length > SERVE_MAX_REQUEST || argc > SERVE_MAX_ARGS) {
+        fprintf(stderr, "错误：命令参数过多，无法交给守护进程\n");
+        result = ERR_CONFIG;
+        goto cleanup;
+    }
+
+    payload = malloc(length);
+    if (!payload) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+    char *p = payload;
+    p += sprintf(p, "%s", cwd) + 1;
+    for (int i = 0; i < argc; i++) {
+        p += sprintf(p, "%s", argv[i]) + 1;
+    }
+    for (size_t i = 0; i < SERVE_FORWARDED_ENV_COUNT; i++) {
+        const char *value = getenv(SERVE_FORWARDED_ENV[i]);
+        if (value) {
+            p += sprintf(p, "%s=%s", SERVE_FORWARDED_ENV[i], value) + 1;
+        }
+    }
+
+    // 请求头和 stdout/stderr 一起发送
+    ServeRequest request = { SERVE_MAGIC, (uint32_t)argc, envc, (uint32_t)length };
+    int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+    char control[CMSG_SPACE(sizeof(fds))];
+    struct iovec iov = { &request, sizeof(request) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &msg, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != (ssize_t)sizeof(request) || writeFully(fd, payload, length) != ERR_OK) {
+        fprintf(stderr, "错误：向守护进程发送命令失败: %s\n", strerror(errno));
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
+
+    int32_t status = 1;
+    if (readFully(fd, &status, sizeof(status)) != ERR_OK) {
+        fprintf(stderr, "错误：守护进程没有返回结果（连接中断）\n");
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
+    *exitCode = status;
+
+cleanup:
+    free(payload);
+    free(cwd);
+    close(fd);
+    return result;
+}
+
+// 创建监听 socket（权限 0600）。路径上已有 socket 时先试着连接：
+// 能连上说明已有守护进程在运行，否则是上次异常退出遗留的文件，删除后重建
+static int openServeSocket(const char *path) {
+    struct sockaddr_un addr;
+    if (fillUnixAddress(&addr, path) != 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "错误：%s 已存在且不是 socket\n", path);
+            return -1;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            close(probe);
+            fprintf(stderr, "错误：%s 上已有守护进程在运行\n", path);
+            return -1;
+        }
+        if (probe >= 0) close(probe);
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "错误：创建 socket 失败: %s\n", strerror(errno));
+        return -1;
+    }
+    mode_t oldMask = umask(077);
+    int bound = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(oldMask);
+    if (bound != 0 || listen(fd, SERVE_BACKLOG) != 0) {
+        fprintf(stderr, "错误：无法监听 %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 读取一个请求：请求头、随附的两个文件描述符和字符串。成功时 outFds 为客户端的 stdout/stderr
+static ErrorCode receiveServeRequest(int conn, ServeRequest *request, int outFds[2], char **outPayload) {
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    struct iovec iov = { request, sizeof(*request) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(conn, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return ERR_FILE_IO;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int))) {
+            memcpy(outFds, CMSG_DATA(cmsg), 2 * sizeof(int));
+        }
+    }
+    if ((size_t)n < sizeof(*request) &&
+        readFully(conn, (char *)request + n, sizeof(*request) - (size_t)n) != ERR_OK) {
+        return ERR_FILE_IO;
+    }
+
+    if (request->magic != SERVE_MAGIC || outFds[0] < 0 || outFds[1] < 0 ||
+        request->argc < 1 || request->argc > SERVE_MAX_ARGS || request->length > SERVE_MAX_REQUEST) {
+        return ERR_CONFIG;
+    }
+
+    char *payload = malloc((size_t)request->length + 1);
+    if (!payload) {
+        return ERR_MEMORY;
+    }
+    if (readFully(conn, payload, request->length) != ERR_OK) {
+        free(payload);
+        return ERR_FILE_IO;
+    }
+    payload[request->length] = '\0';
+
+    // 字符串个数必须与请求头一致
+    uint32_t strings = 0;
+    for (uint32_t i = 0; i < request->length; i++) {
+        if (payload[i] == '\0') strings++;
+    }
+    if (request->length == 0 || payload[request->length - 1] != '\0' ||
+        strings != 1 + request->argc + request->envc) {
+        free(payload);
+        return ERR_CONFIG;
+    }
+
+    *outPayload = payload;
+    return ERR_OK;
+}
+
+static void clearWarmRelease(ServeState *state, const Config *base) {
+    free(state->warm_key);
+    free(state->warm_release);
+    state->warm_key = NULL;
+    state->warm_release = NULL;
+    releaseCacheClear(base->release_cache);
+}
+
+// 执行一个任务：输出重定向到客户端，在客户端的工作目录中运行命令，完成后恢复
+static void handleServeJob(int conn, const Config *base, ServeState *state) {
+    ServeRequest request;
+    int fds[2] = { -1, -1 };
+    char *payload = NULL;
+    char **argv = NULL;
+    char *resolved = NULL;
+    char *key = NULL;
+    int32_t status = 1;
+    double started = monotonicSeconds();
+
+    struct timeval timeout = { SERVE_RECV_TIMEOUT, 0 };
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    ErrorCode received = receiveServeRequest(conn, &request, fds, &payload);
+    if (received != ERR_OK) {
+        log_warn("忽略无效的请求");
+        goto reply;
+    }
+
+    argv = calloc((size_t)request.argc + 2, sizeof(char *));
+    if (!argv) {
+        log_error("内存分配失败");
+        goto reply;
+    }
+
+    // 任务配置从守护进程的配置复制，客户端转发的环境变量覆盖对应的值
+    Config job = *base;
+    job.release_id = NULL;
+    const char *cwd = payload;
+    char *p = payload + strlen(payload) + 1;
+    argv[0] = "manage";
+    for (uint32_t i = 0; i < request.argc; i++) {
+        argv[i + 1] = p;
+        p += strlen(p) + 1;
+    }
+    for (uint32_t i = 0; i < request.envc; i++) {
+        char *name = p;
+        char *value = strchr(name, '=');
+        p += strlen(p) + 1;
+        if (!value) continue;
+        *value++ = '\0';
+        if (strcmp(name, "GITHUB_OWNER") == 0) {
+            job.owner = value;
+        } else if (strcmp(name, "GITHUB_REPO") == 0) {
+            job.repo = value;
+        } else if (strcmp(name, "GITHUB_TAG") == 0) {
+            job.tag_name = value;
+        } else if (strcmp(name, "MANAGE_CONCURRENCY") == 0) {
+            int concurrency = parseConcurrency(value);
+            if (concurrency > 0) job.concurrency = concurrency;
+        } else if (strcmp(name, "MANAGE_DEADLINE") == 0) {
+            double deadline = parseDeadline(value);
+            if (deadline >= 0) job.deadline = deadline;
+        } else if (strcmp(name, "MANAGE_LIMIT_RATE") == 0) {
+            long long rate = parseByteSize(value);
+            if (rate >= 0) job.limit_rate = (curl_off_t)rate;
+        } else if (strcmp(name, "MANAGE_SPEED_LIMIT") == 0) {
+            long long speed = parseByteSize(value);
+            if (speed >= 0) job.speed_limit = (curl_off_t)speed;
+        } else if (strcmp(name, "MANAGE_SPEED_TIME") == 0) {
+            long seconds = parseSpeedTime(value);
+            if (seconds > 0) job.speed_time = seconds;
+        }
+    }
+
+    // 命令执行时会重置命令 arena，key 需要自己的副本
+    char *arenaKey = arenaPrintf(commandArena(base), "%s/%s@%s", job.owner, job.repo,
+                                 job.tag_name ? job.tag_name : "");
+    key = arenaKey ? strdup(arenaKey) : NULL;
+    ReleaseCache *cache = base->release_cache;
+    if (key && state->warm_key && strcmp(state->warm_key, key) == 0 &&
+        monotonicSeconds() - state->warm_at < state->cache_ttl &&
+        cache->loaded && strcmp(cache->release_id, state->warm_release) == 0) {
+        job.release_id = state->warm_release;
+    }
+
+    // 命令的输出直接写到客户端的 stdout/stderr
+    fflush(stdout);
+    fflush(stderr);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+
+    ErrorCode result;
+    if (chdir(cwd) != 0) {
+        fprintf(stderr, "错误：守护进程无法进入工作目录 %s: %s\n", cwd, strerror(errno));
+        result = ERR_FILE_IO;
+    } else {
+        result = runCommand((int)request.argc + 1, argv, &job, &resolved);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(state->saved_stdout, STDOUT_FILENO);
+    dup2(state->saved_stderr, STDERR_FILENO);
+    if (fchdir(state->saved_cwd) != 0) {
+        log_warn("无法回到守护进程的工作目录: %s", strerror(errno));
+    }
+
+    // 失败可能是缓存的资产索引已经过时，create-release 会改变最新的 Release，两种情况都丢弃缓存
+    if (result != ERR_OK || strcmp(argv[1], "create-release") == 0) {
+        clearWarmRelease(state, base);
+    } else if (resolved && key) {
+        free(state->warm_key);
+        free(state->warm_release);
+        state->warm_key = key;
+        state->warm_release = resolved;
+        state->warm_at = monotonicSeconds();
+        key = NULL;
+        resolved = NULL;
+    }
+
+    status = (result == ERR_OK) ? 0 : 1;
+    log_info("%s 完成，退出码 %d，耗时 %.3f 秒", argv[1], status, monotonicSeconds() - started);
+
+reply:
+    if (writeFully(conn, &status, sizeof(status)) != ERR_OK) {
+        log_warn("客户端已断开，无法返回退出码");
+    }
+    resetCommandScratch(base->scratch);
+    free(key);
+    free(resolved);
+    free(argv);
+    free(payload);
+    if (fds[0] >= 0) close(fds[0]);
+    if (fds[1] >= 0) close(fds[1]);
+}
+
+// manage serve：在 Unix socket 上逐个执行客户端转交的命令，进程内保持配置、
+// 连接池（TCP/TLS 连接）和最近解析的 Release 及资产索引，收到 SIGINT/SIGTERM 时退出
+static ErrorCode serveJobs(int argc, char **argv, const Config *base) {
+    const char *socketPath = getenv("MANAGE_SOCKET");
+    ServeState state = { NULL, NULL, 0, SERVE_CACHE_TTL, -1, -1, -1 };
+    ErrorCode result = ERR_OK;
+    int listenFd = -1;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--cache-ttl") == 0) {
+            double ttl = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+            if (ttl < 0) {
+                fprintf(stderr, "错误：--cache-ttl 需要一个非负的秒数\n");
+                return ERR_CONFIG;
+            }
+            state.cache_ttl = ttl;
+            i++;
+        } else {
+            fprintf(stderr, "错误：未知的 serve 参数 \"%s\"\n", argv[i]);
+            return ERR_CONFIG;
+        }
+    }
+    if (!socketPath || !*socketPath) {
+        fprintf(stderr, "错误：请用 --socket 或 MANAGE_SOCKET 指定 socket 路径\n");
+        return ERR_CONFIG;
+    }
+
+    listenFd = openServeSocket(socketPath);
+    if (listenFd < 0) {
+        return ERR_CONFIG;
+    }
+
+    state.saved_stdout = dup(STDOUT_FILENO);
+    state.saved_stderr = dup(STDERR_FILENO);
+    state.saved_cwd = open(".", O_RDONLY);
+    if (state.saved_stdout < 0 || state.saved_stderr < 0 || state.saved_cwd < 0) {
+        fprintf(stderr, "错误：无法保存标准输出或工作目录: %s\n", strerror(errno));
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
+
+    // 不设置 SA_RESTART，accept 会被信号打断，从而检查退出标记；
+    // 客户端提前退出时写它的 stdout 会得到 EPIPE，不能因此终止守护进程
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = serveSignalHandler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    log_info("守护进程已启动，监听 %s（Release 缓存 %.0f 秒）", socketPath, state.cache_ttl);
+
+    while (!serve_stopping) {
+        int conn = accept(listenFd, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "错误：accept 失败: %s\n", strerror(errno));
+            result = ERR_FILE_IO;
+            break;
+        }
+        handleServeJob(conn, base, &state);
+        close(conn);
+    }
+
+    log_info("守护进程退出");
+
+cleanup:
+    close(listenFd);
+    unlink(socketPath);
+    if (state.saved_stdout >= 0) close(state.saved_stdout);
+    if (state.saved_stderr >= 0) close(state.saved_stderr);
+    if (state.saved_cwd >= 0) close(state.saved_cwd);
+    free(state.warm_key);
+    free(state.warm_release);
+    return result;
+}
+
+// ==================== 按模式批量删除 ====================
+
+static int assetPatternMatches(const AssetPattern *pattern, const char *name) {
+    if (pattern->is_regex) {
+        return regexec(&pattern->regex, name, 0, NULL, 0) == 0;
+    }
+    return fnmatch(pattern->text, name, 0) == 0;
+}
+
+// runMultiRequests 的回调，ctx 是 DeleteBatch
+typedef struct {
+    UploadTask *tasks;
+    int count;
+    int completed;
+    int success;
+    int failed;
+} DeleteBatch;
+
+static int deleteTaskCount(void *ctx) {
+    return ((DeleteBatch *)ctx)->count;
+}
+
+static MultiRequest *deleteTaskRequest(void *ctx, int index) {
+    return &((DeleteBatch *)ctx)->tasks[index].req;
+}
+
+static ErrorCode deleteTaskStart(CURLM *multi, void *item, void *ctx, CURL **out_curl) {
+    UploadTask *task = item;
+    (void)ctx;
+    ErrorCode result = startDeleteTask(multi, task);
+    *out_curl = task->curl;
+    return result;
+}
+
+static ErrorCode deleteTaskFinish(void *item, CURLcode res, void *ctx) {
+    (void)ctx;
+    return finishDeleteTask(item, res);
+}
+
+static void deleteTaskRelease(CURLM *multi, void *item) {
+    releaseUploadAttempt(multi, item);
+}
+
+static ErrorCode deleteTaskDone(void *item, ErrorCode result, void *ctx) {
+    UploadTask *task = item;
+    DeleteBatch *batch = ctx;
+
+    task->state = UPLOAD_DONE;
+    task->result = result;
+    batch->completed++;
+    if (result == ERR_OK) {
+        batch->success++;
+        printf("[%d/%d] ✅ 文件 \"%s\" 删除成功\n", batch->completed, batch->count, task->fileName);
+    } else {
+        batch->failed++;
+        printf("[%d/%d] ❌ 文件 \"%s\" 删除失败\n", batch->completed, batch->count, task->fileName);
+    }
+    return ERR_OK;
+}
+
+// 并发删除一组资产，同时最多 config->concurrency 个请求，失败时按 planRetry 重试
+static ErrorCode deleteAssetsConcurrent(int count, ReleaseAsset **assets, const Config *config) {
+    DeleteBatch batch = {0};
+    int concurrency = config->concurrency < count ? config->concurrency : count;
+    ErrorCode result = ERR_OK;
+
+    if (concurrency < 1) concurrency = 1;
+    printf("准备批量删除 %d 个文件（并发数: %d）...\n\n", count, concurrency);
+
+    batch.tasks = calloc(count, sizeof(UploadTask));
+    if (!batch.tasks) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    batch.count = count;
+
+    // 删除成功后缓存中的资产会被释放，任务需要自己的名字副本
+    for (int i = 0; i < count; i++) {
+        UploadTask *task = &batch.tasks[i];
+        task->fileName = arenaStrdup(commandArena(config), assets[i]->name);
+        task->config = config;
+        task->replaceAssetId = assets[i]->id;
+        task->state = UPLOAD_PENDING;
+        task->source.fd = -1;
+        task->req.item = task;
+        task->req.label = task->fileName;
+        if (!task->fileName) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    MultiRequestOps ops = {
+        .ctx = &batch,
+        .concurrency = concurrency,
+        .count = deleteTaskCount,
+        .request = deleteTaskRequest,
+        .start = deleteTaskStart,
+        .finish = deleteTaskFinish,
+        .release = deleteTaskRelease,
+        .done = deleteTaskDone,
+    };
+    result = runMultiRequests(&ops);
+    if (result != ERR_OK) goto cleanup;
+
+    printf("\n===================================\n");
+    printf("批量删除完成:\n");
+    printf("  成功: %d\n", batch.success);
+    printf("  失败: %d\n", batch.failed);
+    printf("===================================\n");
+
+    result = (batch.failed == 0) ? ERR_OK : ERR_CURL_PERFORM;
+
+cleanup:
+    for (int i = 0; i < count; i++) {
+        freeUploadTask(NULL, &batch.tasks[i]);
+    }
+    free(batch.tasks);
+    return result;
+}
+
+// 按资产名和通配符/正则从 Release 资产索引中选出要删除的资产，只获取一次资产列表。
+// names 为精确的资产名（不存在时报错），patterns 匹配不到任何资产时报错；dryRun 只打印列表
+static ErrorCode deleteMatchingAssets(int nameCount, char **names, int patternCount, AssetPattern *patterns,
+                                      int dryRun, const Config *config) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    ReleaseAsset **selected = calloc(cache->asset_count + (size_t)nameCount + 1, sizeof(ReleaseAsset *));
+    int selectedCount = 0;
+    if (!selected) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+
+    for (int i = 0; i < nameCount; i++) {
+        ReleaseAsset *asset = releaseCacheFind(cache, names[i]);
+        if (!asset) {
+            fprintf(stderr, "错误：Release 中没有文件 \"%s\"\n", names[i]);
+            result = ERR_NOT_FOUND;
+            goto cleanup;
+        }
+        int duplicate = 0;
+        for (int j = 0; j < selectedCount && !duplicate; j++) {
+            duplicate = (selected[j] == asset);
+        }
+        if (!duplicate) {
+            selected[selectedCount++] = asset;
+        }
+    }
+
+    // 按 API 返回的顺序遍历一次资产列表，已按名字选中的资产不会重复加入
+    if (patternCount > 0) {
+        int matched = 0;
+        for (ReleaseAsset *asset = cache->head; asset; asset = asset->next) {
+            int hit = 0;
+            for (int p = 0; p < patternCount && !hit; p++) {
+                hit = assetPatternMatches(&patterns[p], asset->name);
+            }
+            if (!hit) continue;
+            matched++;
+
+            int duplicate = 0;
+            for (int j = 0; j < nameCount && !duplicate; j++) {
+                duplicate = (selected[j] == asset);
+            }
+            if (!duplicate) {
+                selected[selectedCount++] = asset;
+            }
+        }
+        if (matched == 0) {
+            fprintf(stderr, "错误：Release 中没有与给定模式匹配的文件\n");
+            result = ERR_NOT_FOUND;
+            goto cleanup;
+        }
+    }
+
+    if (dryRun) {
+        long long totalSize = 0;
+        printf("将删除 %d 个文件（未执行，--dry-run）:\n", selectedCount);
+        for (int i = 0; i < selectedCount; i++) {
+            printf("  %-40s %12lld 字节  (ID: %lld)\n", selected[i]->name, selected[i]->size, selected[i]->id);
+            totalSize += selected[i]->size;
+        }
+        printf("共 %lld 字节\n", totalSize);
+        result = ERR_OK;
+        goto cleanup;
+    }
+
+    result = deleteAssetsConcurrent(selectedCount, selected, config);
+
+cleanup:
+    free(selected);
+    return result;
+}
+
+// ==================== 增量同步（sync） ====================
+
+// 从 "sha256:<hex>" 形式的字符串中取出十六进制部分，不是 SHA-256 时返回 NULL
+static const char* parseSha256Tag(const char *value) {
+    if (!value || strncasecmp(value, "sha256:", 7) != 0) {
+        return NULL;
+    }
+    value += 7;
+    if (strlen(value) != SHA256_HEX_SIZE - 1) {
+        return NULL;
+    }
+    for (const char *p = value; *p; p++) {
+        if (!isxdigit((unsigned char)*p)) return NULL;
+    }
+    return value;
+}
+
+// 读取同步清单：{"version":1,"releases":{"<release_id>":{"<资产名>":{"id":..,"size":..,"sha256":".."}}}}
+// 清单不存在时返回一个空清单
+static ErrorCode loadSyncManifest(const char *path, struct json_object **out_root) {
+    *out_root = NULL;
+
+    struct json_object *root = NULL;
+    if (access(path, F_OK) == 0) {
+        root = json_object_from_file(path);
+        if (!root || !json_object_is_type(root, json_type_object)) {
+            fprintf(stderr, "同步清单格式错误: %s\n", path);
+            if (root) json_object_put(root);
+            return ERR_JSON_PARSE;
+        }
+    } else {
+        root = json_object_new_object();
+        if (!root) return ERR_MEMORY;
+        json_object_object_add(root, "version", json_object_new_int(1));
+    }
+
+    *out_root = root;
+    return ERR_OK;
+}
+
+// 取出（必要时创建）清单中某个 release 的资产表
+static struct json_object* syncManifestRelease(struct json_object *root, const char *release_id, int create) {
+    struct json_object *releases, *release;
+
+    if (!json_object_object_get_ex(root, "releases", &releases) ||
+        !json_object_is_type(releases, json_type_object)) {
+        if (!create) return NULL;
+        releases = json_object_new_object();
+        if (!releases) return NULL;
+        json_object_object_add(root, "releases", releases);
+    }
+
+    if (!json_object_object_get_ex(releases, release_id, &release) ||
+        !json_object_is_type(release, json_type_object)) {
+        if (!create) return NULL;
+        release = json_object_new_object();
+        if (!release) return NULL;
+        json_object_object_add(releases, release_id, release);
+    }
+
+    return release;
+}
+
+// 清单中记录的哈希只有在资产 ID 和大小都与远端一致时才可信
+static const char* syncManifestLookup(struct json_object *release, const ReleaseAsset *asset) {
+    struct json_object *entry, *sha;
+    if (!release || !json_object_object_get_ex(release, asset->name, &entry)) {
+        return NULL;
+    }
+    if (getJsonInt64(entry, "id") != asset->id || getJsonInt64(entry, "size") != asset->size) {
+        return NULL;
+    }
+    if (!json_object_object_get_ex(entry, "sha256", &sha) || !json_object_is_type(sha, json_type_string)) {
+        return NULL;
+    }
+    return json_object_get_string(sha);
+}
+
+static void syncManifestRecord(struct json_object *release, const ReleaseAsset *asset, const char *sha256) {
+    struct json_object *entry = json_object_new_object();
+    if (!entry) return;
+    json_object_object_add(entry, "id", json_object_new_int64(asset->id));
+    json_object_object_add(entry, "size", json_object_new_int64(asset->size));
+    json_object_object_add(entry, "sha256", json_object_new_string(sha256));
+    json_object_object_add(release, asset->name, entry);
+}
+
+// 先写临时文件再 rename，中途失败不会留下半个文件
+static ErrorCode saveJsonFileAtomic(const char *path, struct json_object *root) {
+    size_t len = strlen(path) + 8;
+    char *tmp_path = malloc(len);
+    if (!tmp_path) return ERR_MEMORY;
+    snprintf(tmp_path, len, "%s.tmp", path);
+
+    ErrorCode result = ERR_OK;
+    if (json_object_to_file_ext(tmp_path, root, JSON_C_TO_STRING_PRETTY) != 0) {
+        fprintf(stderr, "写入文件失败: %s\n", tmp_path);
+        result = ERR_FILE_IO;
+    } else if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "更新文件失败: %s (%s)\n", path, strerror(errno));
+        unlink(tmp_path);
+        result = ERR_FILE_IO;
+    }
+
+    free(tmp_path);
+    return result;
+}
+
+typedef enum {
+    SYNC_SKIP = 0,     // 内容一致，无需传输
+    SYNC_UPLOAD,       // 远端不存在
+    SYNC_REPLACE,      // 远端存在但内容不同（或无法确认相同）
+    SYNC_DELETE,       // 本地已不存在（--delete）
+    SYNC_KEEP          // 本地已不存在，但未指定 --delete
+} SyncAction;
+
+typedef struct {
+    const char *filePath;      // 本地路径（删除/保留项为 NULL）
+    const char *name;          // 资产名
+    char *ownedName;           // 远端资产名的副本（删除后缓存中的名字会被释放）
+    SyncAction action;
+    const char *reason;
+    long long size;
+    char sha256[SHA256_HEX_SIZE];
+    UploadTask *task;          // 本次的上传任务（上传/替换项），结果在 task->result
+} SyncEntry;
+
+static int compareSyncEntryName(const void *a, const void *b) {
+    const SyncEntry *ea = a, *eb = b;
+    return strcmp(ea->name, eb->name);
+}
+
+// 根据远端资产决定本地文件的同步动作
+static void planSyncEntry(SyncEntry *entry, const ReleaseAsset *asset, struct json_object *manifest_release) {
+    if (!asset) {
+        entry->action = SYNC_UPLOAD;
+        entry->reason = "新文件";
+        return;
+    }
+    if (strcmp(asset->state, "uploaded") != 0) {
+        entry->action = SYNC_REPLACE;
+        entry->reason = "远端上传未完成";
+        return;
+    }
+    if (asset->size != entry->size) {
+        entry->action = SYNC_REPLACE;
+        entry->reason = "大小不同";
+        return;
+    }
+
+    // 依次使用 GitHub 提供的 digest、资产标签、本地清单中的哈希
+    const char *remote = parseSha256Tag(asset->digest);
+    if (!remote) remote = parseSha256Tag(asset->label);
+    if (!remote) remote = syncManifestLookup(manifest_release, asset);
+
+    if (!remote) {
+        entry->action = SYNC_REPLACE;
+        entry->reason = "远端没有可比对的哈希";
+    } else if (strcasecmp(remote, entry->sha256) != 0) {
+        entry->action = SYNC_REPLACE;
+        entry->reason = "内容不同";
+    } else {
+        entry->action = SYNC_SKIP;
+        entry->reason = "未变化";
+    }
+}
+
+// 按大小和内容哈希比较本地文件与 Release 资产，只传输新增或变化的文件
+static ErrorCode syncFiles(int fileCount, char **filePaths, const Config *config,
+                           int deleteOrphans, int dryRun, const char *manifestPath) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    struct json_object *manifest = NULL;
+    result = loadSyncManifest(manifestPath, &manifest);
+    if (result != ERR_OK) {
+        return result;
+    }
+    struct json_object *manifest_release = syncManifestRelease(manifest, config->release_id, 0);
+
+    // 本地文件 + 远端多出来的资产
+    size_t capacity = (size_t)fileCount + cache->asset_count;
+    SyncEntry *entries = calloc(capacity ? capacity : 1, sizeof(SyncEntry));
+    ReleaseAsset **orphans = calloc(capacity ? capacity : 1, sizeof(ReleaseAsset *));
+    UploadTaskList tasks = {0};
+    int entryCount = 0;
+    int counts[SYNC_KEEP + 1] = {0};
+
+    if (!entries || !orphans) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    printf("正在比较 %d 个本地文件...\n", fileCount);
+    for (int i = 0; i < fileCount; i++) {
+        SyncEntry *entry = &entries[entryCount];
+        struct stat st;
+
+        if (!is_safe_path(filePaths[i]) || stat(filePaths[i], &st) != 0 || !S_ISREG(st.st_mode)) {
+            fprintf(stderr, "错误：无法读取文件 %s\n", filePaths[i]);
+            result = ERR_FILE_IO;
+            goto cleanup;
+        }
+
+        entry->filePath = filePaths[i];
+        entry->name = getFilenameFromPath(filePaths[i]);
+        entry->size = (long long)st.st_size;
+        result = hashFileSha256(filePaths[i], entry->sha256);
+        if (result != ERR_OK) {
+            goto cleanup;
+        }
+        entryCount++;
+    }
+
+    // 资产名必须唯一，不同目录下的同名文件会互相覆盖
+    qsort(entries, entryCount, sizeof(SyncEntry), compareSyncEntryName);
+    for (int i = 1; i < entryCount; i++) {
+        if (strcmp(entries[i - 1].name, entries[i].name) == 0) {
+            fprintf(stderr, "错误：%s 和 %s 对应同一个资产名 \"%s\"\n",
+                    entries[i - 1].filePath, entries[i].filePath, entries[i].name);
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+    }
+
+    for (int i = 0; i < entryCount; i++) {
+        planSyncEntry(&entries[i], releaseCacheFind(cache, entries[i].name), manifest_release);
+    }
+
+    // 远端存在但本地没有的资产
+    int totalEntries = entryCount;
+    for (ReleaseAsset *asset = cache->head; asset; asset = asset->next) {
+        SyncEntry key = {.name = asset->name};
+        if (bsearch(&key, entries, entryCount, sizeof(SyncEntry), compareSyncEntryName)) {
+            continue;
+        }
+        SyncEntry *orphan = &entries[totalEntries++];
+        orphan->ownedName = strdup(asset->name);
+        if (!orphan->ownedName) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+        orphan->name = orphan->ownedName;
+        orphan->size = asset->size;
+        orphan->action = deleteOrphans ? SYNC_DELETE : SYNC_KEEP;
+        orphan->reason = deleteOrphans ? "本地不存在" : "本地不存在，使用 --delete 删除";
+    }
+    for (int i = 0; i < totalEntries; i++) {
+        counts[entries[i].action]++;
+    }
+
+    static const char *action_names[] = {"跳过", "上传", "替换", "删除", "保留"};
+    printf("\n同步计划 (Release ID: %s):\n", config->release_id);
+    printf("--------------------------------------------------------------------------\n");
+    for (int i = 0; i < totalEntries; i++) {
+        printf("  %s  %-40s %15lld  (%s)\n", action_names[entries[i].action],
+               entries[i].name, entries[i].size, entries[i].reason);
+    }
+    printf("--------------------------------------------------------------------------\n");
+    printf("上传 %d，替换 %d，删除 %d，跳过 %d，保留 %d\n",
+           counts[SYNC_UPLOAD], counts[SYNC_REPLACE], counts[SYNC_DELETE],
+           counts[SYNC_SKIP], counts[SYNC_KEEP]);
+
+    if (dryRun) {
+        printf("\n--dry-run：未做任何修改\n");
+        result = ERR_OK;
+        goto cleanup;
+    }
+
+    if (counts[SYNC_UPLOAD] + counts[SYNC_REPLACE] + counts[SYNC_DELETE] == 0) {
+        printf("\n所有文件均已是最新\n");
+    }
+
+    // 新增和替换的文件交给上传引擎：替换项的旧资产在上传前一刻删除，与其他文件的上传
+    // 流水线进行；多余的资产在上传结束后并发删除
+    int failed = 0;
+    for (int i = 0; i < entryCount; i++) {
+        SyncEntry *entry = &entries[i];
+        if (entry->action != SYNC_UPLOAD && entry->action != SYNC_REPLACE) {
+            continue;
+        }
+        entry->task = appendUploadTask(&tasks, config, entry->filePath, entry->name);
+        if (!entry->task) {
+            fprintf(stderr, "内存分配失败\n");
+            result = ERR_MEMORY;
+            goto cleanup;
+        }
+        if (entry->action == SYNC_REPLACE) {
+            markReplacedAsset(&tasks, cache, entry->task);
+        }
+    }
+
+    ErrorCode uploadResult = ERR_OK;
+    if (tasks.count > 0) {
+        printf("\n");
+        uploadResult = runUploadTasks(&tasks, NULL, config, "上传");
+        for (int i = 0; i < tasks.count; i++) {
+            if (tasks.items[i]->result != ERR_OK) failed++;
+        }
+    }
+
+    int orphanCount = 0;
+    for (int i = entryCount; i < totalEntries; i++) {
+        ReleaseAsset *asset = entries[i].action == SYNC_DELETE ? releaseCacheFind(cache, entries[i].name) : NULL;
+        if (asset) orphans[orphanCount++] = asset;
+    }
+    ErrorCode deleteResult = ERR_OK;
+    if (orphanCount > 0) {
+        printf("\n");
+        deleteResult = deleteAssetsConcurrent(orphanCount, orphans, config);
+        // 删除成功的资产已从缓存中移除
+        for (int i = entryCount; i < totalEntries; i++) {
+            if (entries[i].action == SYNC_DELETE && releaseCacheFind(cache, entries[i].name)) failed++;
+        }
+    }
+
+    // 记录远端现有资产的哈希，下次同步时无需重新上传。只记录确认一致的文件和本次
+    // 上传成功的文件：替换失败时远端的旧资产内容并不是本地文件，不能记到它名下
+    struct json_object *release = syncManifestRelease(manifest, config->release_id, 1);
+    if (release) {
+        for (int i = 0; i < totalEntries; i++) {
+            ReleaseAsset *asset = releaseCacheFind(cache, entries[i].name);
+            int uploaded = entries[i].task && entries[i].task->result == ERR_OK;
+            if (!asset) {
+                json_object_object_del(release, entries[i].name);
+            } else if (entries[i].action == SYNC_SKIP || uploaded) {
+                syncManifestRecord(release, asset, entries[i].sha256);
+            }
         }
-    } else if (strcmp(command, "delete") == 0) {
-        if (argc < 3) {
-            fprintf(stderr, "错误：请提供文件名。\n");
-            showUsage();
-            return 1;
+        saveJsonFileAtomic(manifestPath, manifest);
+    }
+
+    printf("\n===================================\n");
+    printf("同步完成:\n");
+    printf("  上传: %d\n", tasks.count);
+    printf("  删除: %d\n", counts[SYNC_DELETE]);
+    printf("  跳过: %d\n", counts[SYNC_SKIP]);
+    printf("  失败: %d\n", failed);
+    printf("===================================\n");
+
+    // 引擎本身的错误（内存不足等）优先于逐个文件的失败
+    if (uploadResult != ERR_OK && uploadResult != ERR_CURL_PERFORM) {
+        result = uploadResult;
+    } else if (deleteResult != ERR_OK && deleteResult != ERR_CURL_PERFORM) {
+        result = deleteResult;
+    } else {
+        result = (failed == 0) ? ERR_OK : ERR_CURL_PERFORM;
+    }
+
+cleanup:
+    freeUploadTaskList(&tasks);
+    if (entries) {
+        for (int i = entryCount; i < (int)capacity; i++) {
+            free(entries[i].ownedName);
+        }
+    }
+    free(orphans);
+    free(entries);
+    json_object_put(manifest);
+    return result;
+}
+
+// ==================== 断点续传（上传日志） ====================
+
+// 上传日志：{"version":1,"release_id":"..","files":{"<资产名>":{"path":..,"size":..,"mtime":..,
+// "existing_id":..,"state":"pending|done","id":..}}}
+// 每个文件上传成功后立即原子地重写，进程中断后用 --resume 只上传剩余的文件
+struct UploadJournal {
+    char *path;
+    struct json_object *root;
+    struct json_object *files;    // 资产名 → 记录
+};
+
+static void freeUploadJournal(UploadJournal *journal) {
+    if (!journal) return;
+    free(journal->path);
+    if (journal->root) json_object_put(journal->root);
+    free(journal);
+}
+
+// 打开 release 对应的上传日志；resume 为 0 时丢弃旧日志重新开始
+static ErrorCode openUploadJournal(const char *release_id, int resume, UploadJournal **out_journal) {
+    *out_journal = NULL;
+
+    UploadJournal *journal = calloc(1, sizeof(UploadJournal));
+    if (!journal) return ERR_MEMORY;
+
+    size_t len = strlen(UPLOAD_JOURNAL_FORMAT) + strlen(release_id) + 1;
+    journal->path = malloc(len);
+    if (!journal->path) {
+        freeUploadJournal(journal);
+        return ERR_MEMORY;
+    }
+    snprintf(journal->path, len, UPLOAD_JOURNAL_FORMAT, release_id);
+
+    if (resume) {
+        if (access(journal->path, F_OK) == 0) {
+            journal->root = json_object_from_file(journal->path);
+            if (!journal->root || !json_object_is_type(journal->root, json_type_object) ||
+                !json_object_object_get_ex(journal->root, "files", &journal->files) ||
+                !json_object_is_type(journal->files, json_type_object)) {
+                fprintf(stderr, "上传日志格式错误: %s\n", journal->path);
+                freeUploadJournal(journal);
+                return ERR_JSON_PARSE;
+            }
+            printf("从上传日志继续: %s\n", journal->path);
+        } else {
+            log_warn("没有找到上传日志 %s，将上传全部文件", journal->path);
+        }
+    }
+
+    if (!journal->root) {
+        journal->root = json_object_new_object();
+        journal->files = json_object_new_object();
+        if (!journal->root || !journal->files) {
+            if (journal->files) json_object_put(journal->files);
+            freeUploadJournal(journal);
+            return ERR_MEMORY;
+        }
+        json_object_object_add(journal->root, "version", json_object_new_int(1));
+        json_object_object_add(journal->root, "release_id", json_object_new_string(release_id));
+        json_object_object_add(journal->root, "files", journal->files);
+    }
+
+    *out_journal = journal;
+    return ERR_OK;
+}
+
+static struct json_object* uploadJournalEntry(UploadJournal *journal, const char *name) {
+    struct json_object *entry;
+    if (!json_object_object_get_ex(journal->files, name, &entry) ||
+        !json_object_is_type(entry, json_type_object)) {
+        return NULL;
+    }
+    return entry;
+}
+
+static int uploadJournalEntryDone(struct json_object *entry) {
+    struct json_object *state;
+    return json_object_object_get_ex(entry, "state", &state) &&
+           json_object_is_type(state, json_type_string) &&
+           strcmp(json_object_get_string(state), "done") == 0;
+}
+
+// 日志记录的本地文件与现在的文件一致（大小和修改时间都没变）
+static int uploadJournalEntryMatches(struct json_object *entry, const struct stat *st) {
+    return getJsonInt64(entry, "size") == (long long)st->st_size &&
+           getJsonInt64(entry, "mtime") == (long long)st->st_mtime;
+}
+
+// 把文件记为待上传；existingId 为加入日志时远端已有的同名资产，续传时不会把它当成自己上传的
+static void uploadJournalAdd(UploadJournal *journal, const char *name, const char *filePath,
+                             const struct stat *st, long long existingId) {
+    struct json_object *entry = json_object_new_object();
+    if (!entry) return;
+    json_object_object_add(entry, "path", json_object_new_string(filePath));
+    json_object_object_add(entry, "size", json_object_new_int64((int64_t)st->st_size));
+    json_object_object_add(entry, "mtime", json_object_new_int64((int64_t)st->st_mtime));
+    json_object_object_add(entry, "existing_id", json_object_new_int64(existingId));
+    json_object_object_add(entry, "state", json_object_new_string("pending"));
+    json_object_object_add(journal->files, name, entry);
+}
+
+static int uploadJournalMarkDone(UploadJournal *journal, const char *name, long long assetId) {
+    struct json_object *entry = uploadJournalEntry(journal, name);
+    if (!entry) return 0;
+    json_object_object_add(entry, "state", json_object_new_string("done"));
+    json_object_object_add(entry, "id", json_object_new_int64(assetId));
+    return 1;
+}
+
+// 文件上传成功后立即落盘，journal 为 NULL 时不记录
+static void uploadJournalComplete(UploadJournal *journal, const char *name, long long assetId) {
+    if (!journal || !uploadJournalMarkDone(journal, name, assetId)) return;
+
+    if (saveJsonFileAtomic(journal->path, journal->root) != ERR_OK) {
+        log_warn("无法更新上传日志 %s", journal->path);
+    }
+}
+
+// 续传时判断远端同名资产能否算作上次已完成的上传。
+// compressed 非 0 时远端是压缩后的内容，大小和摘要无法与本地文件比较，只认日志中记录的完成状态
+static int uploadJournalAssetComplete(struct json_object *entry, const ReleaseAsset *asset,
+                                      const char *filePath, const struct stat *st, int compressed) {
+    if (!entry || !asset || strcmp(asset->state, "uploaded") != 0 ||
+        (!compressed && asset->size != (long long)st->st_size) || !uploadJournalEntryMatches(entry, st)) {
+        return 0;
+    }
+    if (uploadJournalEntryDone(entry)) {
+        return getJsonInt64(entry, "id") == asset->id;
+    }
+    if (compressed) {
+        return 0;
+    }
+
+    // 上传请求已经完成但没来得及写日志：只有远端摘要与本地内容一致时才能确认
+    const char *remote = parseSha256Tag(asset->digest);
+    char local[SHA256_HEX_SIZE];
+    return asset->id != getJsonInt64(entry, "existing_id") && remote &&
+           hashFileSha256(filePath, local) == ERR_OK && strcasecmp(remote, local) == 0;
+}
+
+// 带上传日志的批量上传（upload --journal / --resume）。resume 非 0 时跳过上次已完成的文件，
+// 并删除上次中断留下的半成品资产（state 不是 uploaded，或上传了但无法确认内容）
+static ErrorCode uploadFilesResumable(int fileCount, char **filePaths, const Config *config, int resume) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
+
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    UploadJournal *journal = NULL;
+    result = openUploadJournal(config->release_id, resume, &journal);
+    if (result != ERR_OK) {
+        return result;
+    }
+
+    char **pending = calloc(fileCount, sizeof(char *));
+    int pendingCount = 0;
+    int skipped = 0;
+    int failed = 0;
+    if (!pending) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+
+    for (int i = 0; i < fileCount; i++) {
+        const char *name = uploadAssetName(config, getFilenameFromPath(filePaths[i]));
+        struct json_object *entry = uploadJournalEntry(journal, name);
+        ReleaseAsset *asset = releaseCacheFind(cache, name);
+        struct stat st;
+
+        if (stat(filePaths[i], &st) != 0) {
+            // 交给上传流程报告具体错误
+            pending[pendingCount++] = filePaths[i];
+            continue;
+        }
+
+        if (resume && uploadJournalAssetComplete(entry, asset, filePaths[i], &st, config->compression != NULL)) {
+            printf("跳过已完成的文件: %s\n", name);
+            uploadJournalMarkDone(journal, name, asset->id);
+            skipped++;
+            continue;
+        }
+
+        if (resume && asset && (strcmp(asset->state, "uploaded") != 0 ||
+                                (entry && asset->id != getJsonInt64(entry, "existing_id")))) {
+            printf("清理上次中断留下的资产: %s (状态: %s)\n", name, asset->state);
+            if (deleteFileWithRetry(name, config, MAX_RETRIES) != ERR_OK) {
+                fprintf(stderr, "文件 \"%s\" 的残留资产删除失败\n", filePaths[i]);
+                failed++;
+                continue;
+            }
+            asset = NULL;
+        }
+
+        uploadJournalAdd(journal, name, filePaths[i], &st, asset ? asset->id : 0);
+        pending[pendingCount++] = filePaths[i];
+    }
+
+    if (saveJsonFileAtomic(journal->path, journal->root) != ERR_OK) {
+        log_warn("无法写入上传日志 %s，本次上传不能续传", journal->path);
+    }
+
+    if (pendingCount > 0) {
+        Config journal_config = *config;
+        journal_config.journal = journal;
+        result = uploadMultipleFiles(pendingCount, pending, &journal_config);
+    } else {
+        printf("所有文件都已上传，无需继续\n");
+        result = ERR_OK;
+    }
+    if (skipped > 0) {
+        printf("续传跳过了 %d 个已完成的文件\n", skipped);
+    }
+    if (result == ERR_OK && failed > 0) {
+        result = ERR_CURL_PERFORM;
+    }
+
+    if (result == ERR_OK) {
+        // 全部完成后日志不再需要
+        unlink(journal->path);
+    } else {
+        printf("已完成的文件记录在 %s，可以使用 --resume 继续上传剩余文件\n", journal->path);
+    }
+
+cleanup:
+    free(pending);
+    freeUploadJournal(journal);
+    return result;
+}
+
+// ==================== 上传校验和 ====================
+
+// 后台哈希线程处理的数据块（从 curl 上传缓冲区复制而来）
+typedef struct ChecksumChunk {
+    struct ChecksumChunk *next;
+    UploadHasher *hasher;
+    size_t len;
+    unsigned char data[];
+} ChecksumChunk;
+
+// 单个文件的哈希状态
+struct UploadHasher {
+    int algorithms;
+    EVP_MD_CTX *sha256;
+    EVP_MD_CTX *blake2b;
+    curl_off_t hashed;    // 已送去哈希的字节数；重传时这之前的数据不再重复计算，-1 表示数据不连续
+    int pending;          // 还在队列中的数据块数
+};
+
+// 所有上传共用一个哈希线程：读回调只复制数据，计算在网络传输的同时进行
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;       // 有新数据块或需要退出
+    pthread_cond_t drained;    // 有数据块处理完毕
+    pthread_t thread;
+    int started;
+    int stopping;
+    ChecksumChunk *head;
+    ChecksumChunk *tail;
+    ChecksumChunk *free_list;
+    int allocated;
+} ChecksumWorker = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .drained = PTHREAD_COND_INITIALIZER,
+};
+
+static void* checksumWorkerMain(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&ChecksumWorker.lock);
+    for (;;) {
+        while (!ChecksumWorker.head && !ChecksumWorker.stopping) {
+            pthread_cond_wait(&ChecksumWorker.wake, &ChecksumWorker.lock);
+        }
+        ChecksumChunk *chunk = ChecksumWorker.head;
+        if (!chunk) {
+            break;
+        }
+        ChecksumWorker.head = chunk->next;
+        if (!ChecksumWorker.head) ChecksumWorker.tail = NULL;
+        pthread_mutex_unlock(&ChecksumWorker.lock);
+
+        UploadHasher *hasher = chunk->hasher;
+        if (hasher->sha256) EVP_DigestUpdate(hasher->sha256, chunk->data, chunk->len);
+        if (hasher->blake2b) EVP_DigestUpdate(hasher->blake2b, chunk->data, chunk->len);
+
+        pthread_mutex_lock(&ChecksumWorker.lock);
+        hasher->pending--;
+        chunk->next = ChecksumWorker.free_list;
+        ChecksumWorker.free_list = chunk;
+        pthread_cond_broadcast(&ChecksumWorker.drained);
+    }
+    pthread_mutex_unlock(&ChecksumWorker.lock);
+    return NULL;
+}
+
+// 停止哈希线程并释放数据块（命令结束时调用）
+static void stopChecksumWorker(void) {
+    pthread_mutex_lock(&ChecksumWorker.lock);
+    int started = ChecksumWorker.started;
+    ChecksumWorker.stopping = 1;
+    pthread_cond_broadcast(&ChecksumWorker.wake);
+    pthread_mutex_unlock(&ChecksumWorker.lock);
+
+    if (started) {
+        pthread_join(ChecksumWorker.thread, NULL);
+    }
+
+    ChecksumChunk *chunk = ChecksumWorker.free_list;
+    while (chunk) {
+        ChecksumChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    ChecksumWorker.free_list = NULL;
+    ChecksumWorker.allocated = 0;
+    ChecksumWorker.started = 0;
+    ChecksumWorker.stopping = 0;
+}
+
+// 把一段数据交给哈希线程；队列满时阻塞，内存占用不超过 CHECKSUM_QUEUE_DEPTH 个缓冲区
+static int checksumSubmit(UploadHasher *hasher, const void *data, size_t len) {
+    while (len > 0) {
+        size_t n = len < UPLOAD_BUFFER_SIZE ? len : UPLOAD_BUFFER_SIZE;
+        ChecksumChunk *chunk = NULL;
+
+        pthread_mutex_lock(&ChecksumWorker.lock);
+        if (!ChecksumWorker.started) {
+            if (pthread_create(&ChecksumWorker.thread, NULL, checksumWorkerMain, NULL) != 0) {
+                pthread_mutex_unlock(&ChecksumWorker.lock);
+                return -1;
+            }
+            ChecksumWorker.started = 1;
+        }
+        while (!ChecksumWorker.free_list && ChecksumWorker.allocated >= CHECKSUM_QUEUE_DEPTH) {
+            pthread_cond_wait(&ChecksumWorker.drained, &ChecksumWorker.lock);
+        }
+        if (ChecksumWorker.free_list) {
+            chunk = ChecksumWorker.free_list;
+            ChecksumWorker.free_list = chunk->next;
+        } else {
+            ChecksumWorker.allocated++;
+        }
+        pthread_mutex_unlock(&ChecksumWorker.lock);
+
+        if (!chunk) {
+            chunk = malloc(sizeof(ChecksumChunk) + UPLOAD_BUFFER_SIZE);
+            if (!chunk) {
+                pthread_mutex_lock(&ChecksumWorker.lock);
+                ChecksumWorker.allocated--;
+                pthread_mutex_unlock(&ChecksumWorker.lock);
+                return -1;
+            }
+        }
+
+        memcpy(chunk->data, data, n);
+        chunk->len = n;
+        chunk->hasher = hasher;
+        chunk->next = NULL;
+
+        pthread_mutex_lock(&ChecksumWorker.lock);
+        if (ChecksumWorker.tail) ChecksumWorker.tail->next = chunk;
+        else ChecksumWorker.head = chunk;
+        ChecksumWorker.tail = chunk;
+        hasher->pending++;
+        pthread_cond_signal(&ChecksumWorker.wake);
+        pthread_mutex_unlock(&ChecksumWorker.lock);
+
+        data = (const unsigned char *)data + n;
+        len -= n;
+    }
+    return 0;
+}
+
+// 等待该文件已提交的数据全部哈希完毕
+static void checksumWait(UploadHasher *hasher) {
+    pthread_mutex_lock(&ChecksumWorker.lock);
+    while (hasher->pending > 0) {
+        pthread_cond_wait(&ChecksumWorker.drained, &ChecksumWorker.lock);
+    }
+    pthread_mutex_unlock(&ChecksumWorker.lock);
+}
+
+static UploadHasher* createUploadHasher(int algorithms) {
+    UploadHasher *hasher = calloc(1, sizeof(UploadHasher));
+    if (!hasher) return NULL;
+    hasher->algorithms = algorithms;
+
+    // EVP 会自动选用 CPU 提供的 SHA 扩展指令（x86 SHA-NI、ARMv8 Crypto 等）
+    if (algorithms & CHECKSUM_SHA256) {
+        hasher->sha256 = EVP_MD_CTX_new();
+        if (!hasher->sha256 || EVP_DigestInit_ex(hasher->sha256, EVP_sha256(), NULL) != 1) {
+            freeUploadHasher(hasher);
+            return NULL;
+        }
+    }
+    if (algorithms & CHECKSUM_BLAKE2B) {
+        hasher->blake2b = EVP_MD_CTX_new();
+        if (!hasher->blake2b || EVP_DigestInit_ex(hasher->blake2b, EVP_blake2b512(), NULL) != 1) {
+            freeUploadHasher(hasher);
+            return NULL;
+        }
+    }
+    return hasher;
+}
+
+static void freeUploadHasher(UploadHasher *hasher) {
+    if (!hasher) return;
+    checksumWait(hasher);
+    if (hasher->sha256) EVP_MD_CTX_free(hasher->sha256);
+    if (hasher->blake2b) EVP_MD_CTX_free(hasher->blake2b);
+    free(hasher);
+}
+
+// 读回调中调用：只哈希第一次读到的数据，curl 回退重传的部分直接跳过
+static void uploadHasherFeed(UploadHasher *hasher, const void *data, size_t len, curl_off_t offset) {
+    if (hasher->hashed < 0) {
+        return;
+    }
+    if (offset > hasher->hashed) {
+        // 出现空洞（一般不会发生），上传结束后改为重新读取文件计算
+        hasher->hashed = -1;
+        return;
+    }
+
+    curl_off_t end = offset + (curl_off_t)len;
+    if (end <= hasher->hashed) {
+        return;
+    }
+
+    size_t skip = (size_t)(hasher->hashed - offset);
+    if (checksumSubmit(hasher, (const unsigned char *)data + skip, len - skip) != 0) {
+        hasher->hashed = -1;
+        return;
+    }
+    hasher->hashed = end;
+}
+
+static void formatDigest(EVP_MD_CTX *ctx, char *out_hex, size_t out_size) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+
+    EVP_DigestFinal_ex(ctx, digest, &digest_len);
+    for (unsigned int i = 0; i < digest_len && i * 2 + 2 < out_size; i++) {
+        snprintf(out_hex + i * 2, 3, "%02x", digest[i]);
+    }
+}
+
+// 同步读取文件计算哈希（hasher 必须是新建的）。length 小于 0 时读到文件末尾，
+// 否则只读取 [offset, offset + length) 这一段（分片）
+static ErrorCode uploadHasherFeedFile(UploadHasher *hasher, const char *filePath,
+                                      curl_off_t offset, curl_off_t length) {
+    ErrorCode result = ERR_OK;
+
+    int fd = open(filePath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "无法打开文件: %s (%s)\n", filePath, strerror(errno));
+        return ERR_FILE_IO;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    unsigned char *buffer = malloc(UPLOAD_BUFFER_SIZE);
+    if (!buffer) {
+        close(fd);
+        return ERR_MEMORY;
+    }
+
+    curl_off_t position = offset;
+    for (;;) {
+        size_t want = UPLOAD_BUFFER_SIZE;
+        if (length >= 0 && (curl_off_t)want > offset + length - position) {
+            want = (size_t)(offset + length - position);
+        }
+        if (want == 0) break;
+
+        ssize_t n = pread(fd, buffer, want, (off_t)position);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "读取文件失败: %s (%s)\n", filePath, strerror(errno));
+            result = ERR_FILE_IO;
+            break;
+        }
+        if (n == 0) break;
+        position += n;
+        if (hasher->sha256) EVP_DigestUpdate(hasher->sha256, buffer, (size_t)n);
+        if (hasher->blake2b) EVP_DigestUpdate(hasher->blake2b, buffer, (size_t)n);
+        hasher->hashed += n;
+    }
+
+    free(buffer);
+    close(fd);
+    return result;
+}
+
+// 计算文件内容的 SHA-256，输出 64 位小写十六进制字符串
+static ErrorCode hashFileSha256(const char *filePath, char out_hex[SHA256_HEX_SIZE]) {
+    UploadHasher *hasher = createUploadHasher(CHECKSUM_SHA256);
+    if (!hasher) {
+        fprintf(stderr, "初始化 SHA-256 失败\n");
+        return ERR_MEMORY;
+    }
+
+    ErrorCode result = uploadHasherFeedFile(hasher, filePath, 0, -1);
+    if (result == ERR_OK) {
+        formatDigest(hasher->sha256, out_hex, SHA256_HEX_SIZE);
+    }
+    freeUploadHasher(hasher);
+    return result;
+}
+
+// 解析 --checksums[=sha256,blake2b]，无效时返回 -1
+static int parseChecksumAlgorithms(const char *value) {
+    if (!value || !*value) {
+        return CHECKSUM_SHA256;
+    }
+
+    int algorithms = 0;
+    const char *p = value;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        if (len == 6 && strncasecmp(p, "sha256", len) == 0) {
+            algorithms |= CHECKSUM_SHA256;
+        } else if (len == 7 && strncasecmp(p, "blake2b", len) == 0) {
+            algorithms |= CHECKSUM_BLAKE2B;
+        } else {
+            return -1;
+        }
+        p += len;
+        if (*p == ',') p++;
+    }
+    return algorithms ? algorithms : -1;
+}
+
+static void initChecksumSet(ChecksumSet *set, int algorithms) {
+    memset(set, 0, sizeof(*set));
+    set->algorithms = algorithms;
+    pthread_mutex_init(&set->lock, NULL);
+}
+
+static void freeChecksumSet(ChecksumSet *set) {
+    for (size_t i = 0; i < set->count; i++) {
+        free(set->entries[i].name);
+    }
+    free(set->entries);
+    pthread_mutex_destroy(&set->lock);
+    memset(set, 0, sizeof(*set));
+}
+
+// 为上传数据源挂上哈希器（未启用 --checksums 时什么也不做）
+static void attachUploadHasher(const Config *config, UploadSource *source) {
+    if (!config->checksums || source->hasher) {
+        return;
+    }
+    source->hasher = createUploadHasher(config->checksums->algorithms);
+    if (!source->hasher) {
+        log_warn("无法初始化校验和计算，上传完成后将重新读取文件");
+    }
+}
+
+// 上传成功后取出哈希结果并记录；流式哈希不完整时退回到重新读取文件
+static ErrorCode recordUploadChecksum(const Config *config, UploadSource *source,
+                                      const char *filePath, const char *fileName) {
+    ChecksumSet *set = config->checksums;
+    if (!set) {
+        return ERR_OK;
+    }
+
+    UploadHasher *hasher = source->hasher;
+    source->hasher = NULL;
+    if (hasher) {
+        checksumWait(hasher);
+    }
+    if (!hasher || hasher->hashed != source->size) {
+        log_debug("%s 的流式哈希不完整，重新读取文件计算", fileName);
+        freeUploadHasher(hasher);
+        hasher = createUploadHasher(set->algorithms);
+        if (!hasher) {
+            return ERR_MEMORY;
+        }
+        ErrorCode ret = uploadHasherFeedFile(hasher, filePath, source->base, source->data ? -1 : source->size);
+        if (ret != ERR_OK) {
+            freeUploadHasher(hasher);
+            return ret;
+        }
+    }
+
+    ChecksumEntry entry = {0};
+    if (hasher->sha256) formatDigest(hasher->sha256, entry.sha256, sizeof(entry.sha256));
+    if (hasher->blake2b) formatDigest(hasher->blake2b, entry.blake2b, sizeof(entry.blake2b));
+    freeUploadHasher(hasher);
+
+    return storeChecksumEntry(set, fileName, &entry);
+}
+
+// 记录一个文件的校验和；同名文件（例如重新上传）以最后一次为准
+static ErrorCode storeChecksumEntry(ChecksumSet *set, const char *fileName, const ChecksumEntry *digests) {
+    ChecksumEntry entry = *digests;
+    ErrorCode result = ERR_OK;
+    pthread_mutex_lock(&set->lock);
+
+    ChecksumEntry *slot = NULL;
+    for (size_t i = 0; i < set->count; i++) {
+        if (strcmp(set->entries[i].name, fileName) == 0) {
+            slot = &set->entries[i];
+            break;
+        }
+    }
+    if (!slot) {
+        if (set->count == set->capacity) {
+            size_t capacity = set->capacity ? set->capacity * 2 : 16;
+            ChecksumEntry *entries = realloc(set->entries, capacity * sizeof(ChecksumEntry));
+            if (!entries) {
+                result = ERR_MEMORY;
+                goto unlock;
+            }
+            set->entries = entries;
+            set->capacity = capacity;
+        }
+        entry.name = strdup(fileName);
+        if (!entry.name) {
+            result = ERR_MEMORY;
+            goto unlock;
         }
+        set->entries[set->count++] = entry;
+    } else {
+        memcpy(slot->sha256, entry.sha256, sizeof(entry.sha256));
+        memcpy(slot->blake2b, entry.blake2b, sizeof(entry.blake2b));
+    }
+
+unlock:
+    pthread_mutex_unlock(&set->lock);
+    return result;
+}
+
+static int compareChecksumEntryName(const void *a, const void *b) {
+    const ChecksumEntry *ea = a, *eb = b;
+    return strcmp(ea->name, eb->name);
+}
+
+// 以 sha256sum/b2sum 的格式写出校验和文件
+static ErrorCode writeChecksumFile(const char *path, const ChecksumSet *set, const ReleaseCache *cache,
+                                   int algorithm) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "无法创建文件: %s (%s)\n", path, strerror(errno));
+        return ERR_FILE_IO;
+    }
 
-        // 收集所有要删除的文件
-        int totalFiles = argc - 2;
-        result = deleteMultipleFiles(totalFiles, &argv[2], &config);
-    } else if (strcmp(command, "update") == 0) {
-        if (argc < 3) {
-            fprintf(stderr, "错误：请提供文件路径。\n");
-            showUsage();
-            return 1;
+    for (size_t i = 0; i < set->count; i++) {
+        const ChecksumEntry *entry = &set->entries[i];
+        fprintf(fp, "%s  %s\n", algorithm == CHECKSUM_SHA256 ? entry->sha256 : entry->blake2b, entry->name);
+    }
+
+    // 本次没有上传的资产，如果 GitHub 提供了 SHA-256 摘要也一并写入
+    if (algorithm == CHECKSUM_SHA256 && cache) {
+        for (ReleaseAsset *asset = cache->head; asset; asset = asset->next) {
+            const char *hex = parseSha256Tag(asset->digest);
+            ChecksumEntry key = {.name = asset->name};
+            if (!hex || strcmp(asset->name, SHA256SUMS_NAME) == 0 || strcmp(asset->name, B2SUMS_NAME) == 0 ||
+                bsearch(&key, set->entries, set->count, sizeof(ChecksumEntry), compareChecksumEntryName)) {
+                continue;
+            }
+            fprintf(fp, "%s  %s\n", hex, asset->name);
         }
+    }
 
-        // 处理批量更新
-        int totalFiles = 0;
-        char **allFiles = NULL;
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "写入文件失败: %s\n", path);
+        return ERR_FILE_IO;
+    }
+    return ERR_OK;
+}
 
-        for (int i = 2; i < argc; i++) {
-            char **matchedFiles = NULL;
-            int fileCount = expandWildcards(argv[i], &matchedFiles);
+// 生成 SHA256SUMS（以及 B2SUMS）并上传到当前 Release，已存在的同名文件会被替换
+static ErrorCode publishChecksums(const Config *config) {
+    ChecksumSet *set = config->checksums;
+    if (!set || set->count == 0) {
+        return ERR_OK;
+    }
 
-            if (fileCount > 0) {
-                char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
-                if (!newAllFiles) {
-                    fprintf(stderr, "内存分配失败\n");
-                    result = ERR_MEMORY;
-                    // 释放已分配的文件名
-                    if (allFiles) {
-                        for (int j = 0; j < totalFiles; j++) {
-                            free(allFiles[j]);
-                        }
-                        free(allFiles);
-                    }
-                    for (int j = 0; j < fileCount; j++) {
-                        free(matchedFiles[j]);
-                    }
-                    free(matchedFiles);
-                    goto cleanup;
-                }
-                allFiles = newAllFiles;
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
+    }
 
-                for (int j = 0; j < fileCount; j++) {
-                    allFiles[totalFiles++] = matchedFiles[j];
-                }
-                free(matchedFiles);
-            }
+    qsort(set->entries, set->count, sizeof(ChecksumEntry), compareChecksumEntryName);
+
+    // 上传路径不允许是绝对路径，临时目录建在当前目录下
+    char *dir = arenaStrdup(commandArena(config), ".manage-sums-XXXXXX");
+    if (!dir || !mkdtemp(dir)) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return ERR_FILE_IO;
+    }
+
+    // 校验和文件本身不参与哈希，也不压缩（其中列出的是压缩后资产的校验和）
+    Config sums_config = *config;
+    sums_config.checksums = NULL;
+    sums_config.compression = NULL;
+
+    static const struct {
+        int algorithm;
+        const char *name;
+    } outputs[] = {
+        {CHECKSUM_SHA256, SHA256SUMS_NAME},
+        {CHECKSUM_BLAKE2B, B2SUMS_NAME},
+    };
+
+    for (size_t i = 0; i < sizeof(outputs) / sizeof(outputs[0]); i++) {
+        if (!(set->algorithms & outputs[i].algorithm)) {
+            continue;
         }
 
-        if (totalFiles == 0) {
-            fprintf(stderr, "错误：找不到匹配的文件\n");
-            result = ERR_FILE_IO;
-        } else {
-            result = updateMultipleFiles(totalFiles, allFiles, &config);
+        char *path = arenaPrintf(commandArena(config), "%s/%s", dir, outputs[i].name);
+        if (!path) {
+            result = ERR_MEMORY;
+            break;
         }
 
-        // 清理文件列表
-        if (allFiles) {
-            for (int i = 0; i < totalFiles; i++) {
-                free(allFiles[i]);
+        ErrorCode ret = writeChecksumFile(path, set, cache, outputs[i].algorithm);
+        if (ret == ERR_OK) {
+            printf("\n正在上传校验和文件 %s（%zu 个文件）...\n", outputs[i].name, set->count);
+            if (releaseCacheFind(cache, outputs[i].name)) {
+                ret = deleteFileWithRetry(outputs[i].name, &sums_config, MAX_RETRIES);
+            }
+            if (ret == ERR_OK) {
+                ret = uploadFileWithRetry(path, &sums_config, MAX_RETRIES);
             }
-            free(allFiles);
         }
-    } else if (strcmp(command, "list") == 0) {
-        result = listFiles(&config);
-    } else if (strcmp(command, "create-release") == 0) {
-        if (argc < 3) {
-            fprintf(stderr, "错误：请提供 tag_name。\n");
-            showUsage();
-            return 1;
+        if (ret != ERR_OK) {
+            fprintf(stderr, "校验和文件 %s 上传失败\n", outputs[i].name);
+            result = ret;
         }
+        unlink(path);
+    }
 
-        // 创建新的 Release ID 用于接收函数返回值
-        char *new_release_id = NULL;
+    rmdir(dir);
+    return result;
+}
 
-        // 解析命令行参数
-        const char *tag_name = argv[2];
-        const char *release_name = NULL;
-        const char *description = NULL;
-        int is_prerelease = 0;
+// ==================== 分片上传与下载 ====================
 
-        // 解析可选参数和文件参数
-        int file_argv_start = 3;
-        for (int i = 3; i < argc; i++) {
-            if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--name") == 0) {
-                if (i + 1 < argc) {
-                    release_name = argv[i + 1];
-                    i++; // 跳过下一个参数
-                } else {
-                    fprintf(stderr, "错误：-n 或 --name 需要一个参数\n");
-                    showUsage();
-                    return 1;
-                }
-            } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--description") == 0) {
-                if (i + 1 < argc) {
-                    description = argv[i + 1];
-                    i++; // 跳过下一个参数
-                } else {
-                    fprintf(stderr, "错误：-d 或 --description 需要一个参数\n");
-                    showUsage();
-                    return 1;
-                }
-            } else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--prerelease") == 0) {
-                is_prerelease = 1;
-            } else {
-                // 其余参数都是文件路径
-                file_argv_start = i;
-                break;
-            }
-        }
+// 解析 --split 的分片大小：向下取整到 SPLIT_ALIGN 的整数倍，不能小于 SPLIT_MIN_SIZE，
+// 也不能达到 GitHub 的单个资产上限。无效时返回 -1
+static long long parseSplitSize(const char *value) {
+    long long size = parseByteSize(value);
+    if (size < 0) {
+        return -1;
+    }
+    size -= size % SPLIT_ALIGN;
+    if (size < SPLIT_MIN_SIZE || size >= MAX_ASSET_SIZE) {
+        return -1;
+    }
+    return size;
+}
 
-        // 创建 Release
-        result = createRelease(tag_name, release_name, description, is_prerelease, &config, &new_release_id);
+// 切分上传的一个文件，它的分片在任务列表中连续排列
+typedef struct {
+    const char *fileName;
+    curl_off_t size;
+    int firstTask;
+    int partCount;
+} SplitFile;
+
+static const ChecksumEntry* findChecksumEntry(const ChecksumSet *set, const char *name) {
+    for (size_t i = 0; i < set->count; i++) {
+        if (strcmp(set->entries[i].name, name) == 0) {
+            return &set->entries[i];
+        }
+    }
+    return NULL;
+}
 
-        // 如果创建成功且有文件需要上传
-        if (result == ERR_OK && new_release_id && file_argv_start < argc) {
-            printf("\n准备上传文件到新创建的 Release...\n");
+// 生成分片清单：原文件名和大小，以及每个分片的资产名、在文件中的位置、大小和 SHA-256
+static struct json_object* buildSplitManifest(const SplitFile *split, const UploadTaskList *list,
+                                              const ChecksumSet *sums) {
+    struct json_object *root = json_object_new_object();
+    struct json_object *parts = json_object_new_array();
+    if (!root || !parts) {
+        json_object_put(root);
+        json_object_put(parts);
+        return NULL;
+    }
+    json_object_object_add(root, "name", json_object_new_string(split->fileName));
+    json_object_object_add(root, "size", json_object_new_int64(split->size));
+    json_object_object_add(root, "part_size", json_object_new_int64(list->items[split->firstTask]->partSize));
+    json_object_object_add(root, "parts", parts);
+
+    for (int k = 0; k < split->partCount; k++) {
+        const UploadTask *task = list->items[split->firstTask + k];
+        const ChecksumEntry *entry = findChecksumEntry(sums, task->fileName);
+        struct json_object *part = json_object_new_object();
+        if (!entry || !entry->sha256[0] || !part) {
+            json_object_put(part);
+            json_object_put(root);
+            return NULL;
+        }
+        json_object_object_add(part, "name", json_object_new_string(task->fileName));
+        json_object_object_add(part, "offset", json_object_new_int64(task->partOffset));
+        json_object_object_add(part, "size", json_object_new_int64(task->partSize));
+        json_object_object_add(part, "sha256", json_object_new_string(entry->sha256));
+        json_object_array_add(parts, part);
+    }
+    return root;
+}
 
-            // 创建一个临时的配置对象，使用新的 release_id
-            Config upload_config = config;
-            upload_config.release_id = new_release_id;
+// 文件的分片全部上传成功后上传分片清单。有分片失败时不上传清单，
+// download 不会把不完整的文件当成可用的
+static ErrorCode publishSplitManifest(const SplitFile *split, const UploadTaskList *list,
+                                      const ChecksumSet *sums, const Config *config, int replaceExisting) {
+    for (int k = 0; k < split->partCount; k++) {
+        if (list->items[split->firstTask + k]->result != ERR_OK) {
+            fprintf(stderr, "文件 \"%s\" 有分片上传失败，未上传分片清单\n", split->fileName);
+            return ERR_CURL_PERFORM;
+        }
+    }
 
-            // 处理所有文件模式
-            int totalFiles = 0;
-            char **allFiles = NULL;
+    struct json_object *manifest = buildSplitManifest(split, list, sums);
+    if (!manifest) {
+        fprintf(stderr, "生成 \"%s\" 的分片清单失败\n", split->fileName);
+        return ERR_MEMORY;
+    }
 
-            for (int i = file_argv_start; i < argc; i++) {
-                char **matchedFiles = NULL;
-                int fileCount = expandWildcards(argv[i], &matchedFiles);
+    ErrorCode result = ERR_OK;
+    char *path = NULL;
+    const char *manifestName = NULL;
+    ReleaseCache *cache = NULL;
+    Config manifestConfig = *config;
+    manifestConfig.compression = NULL;
+
+    // 上传路径不允许是绝对路径，临时目录建在当前目录下
+    char *dir = arenaStrdup(commandArena(config), ".manage-split-XXXXXX");
+    if (!dir || !mkdtemp(dir)) {
+        fprintf(stderr, "无法创建临时目录\n");
+        json_object_put(manifest);
+        return ERR_FILE_IO;
+    }
+
+    path = arenaPrintf(commandArena(config), "%s/%s" SPLIT_MANIFEST_SUFFIX, dir, split->fileName);
+    if (!path) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
+    }
+    if (json_object_to_file_ext(path, manifest, JSON_C_TO_STRING_PRETTY) != 0) {
+        fprintf(stderr, "无法写入文件: %s\n", path);
+        result = ERR_FILE_IO;
+        goto cleanup;
+    }
 
-                if (fileCount > 0) {
-                    char **newAllFiles = realloc(allFiles, (totalFiles + fileCount) * sizeof(char *));
-                    if (!newAllFiles) {
-                        fprintf(stderr, "内存分配失败\n");
-                        result = ERR_MEMORY;
-                        // 清理已分配的文件名
-                        if (allFiles) {
-                            for (int j = 0; j < totalFiles; j++) {
-                                free(allFiles[j]);
-                            }
-                            free(allFiles);
-                        }
-                        for (int j = 0; j < fileCount; j++) {
-                            free(matchedFiles[j]);
-                        }
-                        free(matchedFiles);
-                        free(new_release_id);
-                        goto cleanup;
-                    }
-                    allFiles = newAllFiles;
+    manifestName = getFilenameFromPath(path);
+    printf("\n正在上传分片清单 %s（%d 个分片）...\n", manifestName, split->partCount);
+    if (replaceExisting && ensureReleaseCache(config, &cache) == ERR_OK && releaseCacheFind(cache, manifestName)) {
+        result = deleteFileWithRetry(manifestName, &manifestConfig, MAX_RETRIES);
+    }
+    if (result == ERR_OK) {
+        result = uploadFileWithRetry(path, &manifestConfig, MAX_RETRIES);
+    }
+    if (result != ERR_OK) {
+        fprintf(stderr, "分片清单 %s 上传失败\n", manifestName);
+    }
 
-                    for (int j = 0; j < fileCount; j++) {
-                        allFiles[totalFiles++] = matchedFiles[j];
-                    }
-                    free(matchedFiles);
-                }
-            }
+cleanup:
+    if (path) unlink(path);
+    rmdir(dir);
+    json_object_put(manifest);
+    return result;
+}
 
-            if (totalFiles == 0) {
-                fprintf(stderr, "错误：找不到匹配的文件\n");
-                result = ERR_FILE_IO;
-            } else {
-                result = uploadMultipleFiles(totalFiles, allFiles, &upload_config);
-            }
+// 上传文件，大于 splitSize 的文件切成多个分片（<文件名>.part000、.part001 …），与其他文件
+// 一起进入上传引擎并发上传。分片直接按在文件中的位置读取，不生成临时文件；
+// 一个文件的分片全部成功后再上传分片清单 <文件名>.parts.json，download 据此下载并拼接。
+// replaceExisting 非 0 时（update）先删除同名的旧分片和旧清单
+static ErrorCode uploadSplitFiles(int fileCount, char **filePaths, const Config *config,
+                                  long long splitSize, int replaceExisting) {
+    if (validate_config(config) != ERR_OK) {
+        return ERR_CONFIG;
+    }
 
-            // 清理文件列表
-            if (allFiles) {
-                for (int i = 0; i < totalFiles; i++) {
-                    free(allFiles[i]);
-                }
-                free(allFiles);
-            }
+    UploadTaskList list = {0};
+    SplitFile *splits = NULL;
+    int splitCount = 0;
+    const char *uploadUrlTemplate = NULL;
+    ReleaseCache *cache = NULL;
+    ErrorCode result;
 
-            free(new_release_id);
-        } else if (new_release_id) {
-            free(new_release_id);
-        }
-    } else {
-        fprintf(stderr, "错误：未知命令 \"%s\"。\n", command);
-        showUsage();
-        return 1;
+    // 上传地址和资产索引对整批文件相同，开始前获取一次
+    result = getUploadUrlTemplate(config, &uploadUrlTemplate);
+    if (result != ERR_OK) {
+        return result;
+    }
+    result = ensureReleaseCache(config, &cache);
+    if (result != ERR_OK) {
+        return result;
     }
 
-cleanup:
+    // 清单中要记录每个分片的 SHA-256，所以分片总是计算校验和；
+    // 同时启用了 --checksums 时，分片最后也列入 SHA256SUMS/B2SUMS
+    ChecksumSet partSums;
+    initChecksumSet(&partSums, CHECKSUM_SHA256 | (config->checksums ? config->checksums->algorithms : 0));
+    Config partConfig = *config;
+    partConfig.checksums = &partSums;
 
-    // 清理 release_id
-    if (config.release_id) {
-        free(config.release_id);
-        config.release_id = NULL;
+    splits = calloc(fileCount, sizeof(SplitFile));
+    if (!splits) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
+        goto cleanup;
     }
 
-    // 清理字符串配置（使用标记位判断）
-    if (config.owner_allocated && config.owner) {
-        free((void *)config.owner);
-        config.owner = NULL;
+    for (int i = 0; i < fileCount; i++) {
+        const char *fileName = getFilenameFromPath(filePaths[i]);
+        struct stat st;
+        // 无法读取或不是普通文件时按普通文件排队，由上传时报告错误
+        int split = (stat(filePaths[i], &st) == 0 && S_ISREG(st.st_mode) && st.st_size > splitSize);
+        int parts = split ? (int)((st.st_size + splitSize - 1) / splitSize) : 1;
+
+        if (split) {
+            splits[splitCount].fileName = fileName;
+            splits[splitCount].size = (curl_off_t)st.st_size;
+            splits[splitCount].firstTask = list.count;
+            splits[splitCount].partCount = parts;
+            splitCount++;
+            printf("%s: %lld 字节，切分为 %d 个分片\n", fileName, (long long)st.st_size, parts);
+        }
+
+        for (int k = 0; k < parts; k++) {
+            const char *name = split ? arenaPrintf(commandArena(config), SPLIT_PART_FORMAT, fileName, k) : fileName;
+            UploadTask *task = name ? appendUploadTask(&list, split ? &partConfig : config, filePaths[i], name) : NULL;
+            if (!task) {
+                fprintf(stderr, "内存分配失败\n");
+                result = ERR_MEMORY;
+                goto cleanup;
+            }
+            if (split) {
+                task->partOffset = (curl_off_t)k * splitSize;
+                task->partSize = (curl_off_t)st.st_size - task->partOffset;
+                if (task->partSize > splitSize) task->partSize = splitSize;
+            }
+            if (replaceExisting) {
+                markReplacedAsset(&list, cache, task);
+            }
+        }
     }
-    if (config.repo_allocated && config.repo) {
-        free((void *)config.repo);
-        config.repo = NULL;
+    if (splitCount > 0) {
+        printf("\n");
     }
-    if (config.token_allocated && config.token) {
-        free((void *)config.token);
-        config.token = NULL;
+
+    result = runUploadTasks(&list, NULL, config, replaceExisting ? "更新" : "上传");
+
+    for (int i = 0; i < splitCount; i++) {
+        ErrorCode manifestResult = publishSplitManifest(&splits[i], &list, &partSums, config, replaceExisting);
+        if (result == ERR_OK) result = manifestResult;
     }
 
-    curl_global_cleanup();
+    if (config->checksums) {
+        for (size_t i = 0; i < partSums.count; i++) {
+            if (storeChecksumEntry(config->checksums, partSums.entries[i].name, &partSums.entries[i]) != ERR_OK) {
+                log_warn("无法记录 %s 的校验和", partSums.entries[i].name);
+            }
+        }
+    }
 
-    // 将 ErrorCode 转换为 main 的返回值
-    return (result == ERR_OK) ? 0 : 1;
+cleanup:
+    freeUploadTaskList(&list);
+    free(splits);
+    freeChecksumSet(&partSums);
+    return result;
 }
 
-// ==================== 重试机制实现 ====================
+// 下载的目标文件。各分片并发下载，按清单中的位置 pwrite 到预先分配好大小的临时文件，
+// 全部完成并校验后才改名为正式文件名，中途失败不会留下不完整的文件
+typedef struct {
+    const char *name;          // 请求的资产名（分片上传时为原文件名）
+    char *path;                // 输出路径
+    char *tempPath;            // 下载过程中写入的临时文件
+    int fd;
+    curl_off_t size;
+    int parts;
+    int failed;                // 失败的分片数
+    struct json_object *manifest;  // 分片清单，NULL 表示普通资产
+} DownloadFile;
+
+// 一个下载请求：一个分片、一个普通资产或一个分片清单
+typedef struct {
+    const char *name;
+    long long assetId;
+    DownloadFile *file;        // NULL 时下载到 buffer（分片清单）
+    curl_off_t offset;         // 在目标文件中的起始位置
+    curl_off_t size;           // Release 中记录的大小，收到的数据必须与之一致
+    char sha256[SHA256_HEX_SIZE];  // 预期的 SHA-256，空字符串表示不校验
+    curl_off_t received;
+    ErrorCode writeError;      // 写回调中的本地错误（写文件失败、数据超长），不再重试
+    UploadHasher *hasher;
+    ResponseBuffer buffer;
+    MultiRequest req;
+    CURL *curl;
+    struct curl_slist *headers;
+    TransferProgress progress;
+    ErrorCode result;
+} DownloadPart;
+
+// curl 写回调：数据直接 pwrite 到目标文件中这一段的位置，同时交给哈希线程计算 SHA-256
+static size_t DownloadWriteCallback(char *data, size_t size, size_t nmemb, void *userp) {
+    DownloadPart *part = (DownloadPart *)userp;
+    size_t len = size * nmemb;
+
+    // 错误响应的内容（JSON 说明）不写入文件，由 finishDownloadPart 按状态码处理
+    long response_code = 0;
+    curl_easy_getinfo(part->curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        return len;
+    }
 
-// 判断哪些错误需要重试
-static int shouldRetryError(ErrorCode error) {
-    switch (error) {
-        case ERR_CURL_PERFORM:
-            // 网络错误，可能临时失败
-            return 1;
-        case ERR_HTTP_ERROR:
-            // HTTP错误可能需要重试（如500, 502, 503, 504）
-            return 1;
-        case ERR_MEMORY:
-            // 内存错误可能由临时资源限制导致
-            return 1;
-        default:
-            // 其他错误（配置错误、文件IO错误等）不需要重试
+    if (part->received + (curl_off_t)len > part->size) {
+        fprintf(stderr, "\"%s\" 的数据超过了 Release 中记录的大小\n", part->name);
+        part->writeError = ERR_FILE_IO;
+        return 0;
+    }
+
+    if (!part->file) {
+        if (WriteMemoryCallback(data, 1, len, &part->buffer) != len) {
+            part->writeError = ERR_MEMORY;
             return 0;
+        }
+    } else {
+        size_t written = 0;
+        while (written < len) {
+            ssize_t n = pwrite(part->file->fd, data + written, len - written,
+                               (off_t)(part->offset + part->received + (curl_off_t)written));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                fprintf(stderr, "写入文件失败: %s (%s)\n", part->file->tempPath, strerror(errno));
+                part->writeError = ERR_FILE_IO;
+                return 0;
+            }
+            written += (size_t)n;
+        }
+    }
+
+    if (part->hasher) {
+        uploadHasherFeed(part->hasher, data, len, part->received);
     }
+    part->received += (curl_off_t)len;
+    return len;
 }
 
-// 核心重试逻辑
-static ErrorCode performWithRetry(ErrorCode (*operation)(const void *), const void *param,
-                                  int maxRetries, const char *opName) {
-    ErrorCode lastError = ERR_OK;
-    int retryCount = 0;
+static void releaseDownloadAttempt(CURLM *multi, DownloadPart *part) {
+    progressDetach(&part->progress);
+    if (part->curl) {
+        curl_multi_remove_handle(multi, part->curl);
+        releaseCurlHandle(part->curl);
+        part->curl = NULL;
+    }
+    if (part->headers) {
+        curl_slist_free_all(part->headers);
+        part->headers = NULL;
+    }
+    if (part->hasher) {
+        freeUploadHasher(part->hasher);
+        part->hasher = NULL;
+    }
+}
 
-    while (retryCount <= maxRetries) {
-        log_debug("尝试 %s (尝试 %d/%d)", opName, retryCount + 1, maxRetries + 1);
+// 发起一次下载。资产的 API 地址在 Accept 为 application/octet-stream 时重定向到文件内容，
+// 私有仓库同样适用；curl 跟随重定向到其他主机时不会带上 Authorization 头
+static ErrorCode startDownloadPart(CURLM *multi, DownloadPart *part, const Config *config) {
+    char *url = create_url(commandArena(config), "%s/repos/%s/%s/releases/assets/%lld",
+                           config->api_base, config->owner, config->repo, part->assetId);
+    char *auth = arenaPrintf(commandArena(config), "Authorization: Bearer %s", config->token);
+    if (!url || !auth) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
 
-        lastError = operation(param);
+    // 每次尝试都从头写这一段
+    part->received = 0;
+    part->writeError = ERR_OK;
+    responseBufferReset(&part->buffer);
+    if (!part->file && responseBufferReserve(&part->buffer, 0) != ERR_OK) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    if (part->sha256[0]) {
+        // 创建失败时不影响下载，完成后从文件中重新读取这一段校验
+        part->hasher = createUploadHasher(CHECKSUM_SHA256);
+    }
 
-        if (lastError == ERR_OK) {
-            // 操作成功
-            if (retryCount > 0) {
-                log_info("%s 在第 %d 次尝试后成功", opName, retryCount + 1);
-            }
-            return ERR_OK;
+    part->curl = acquireCurlHandle();
+    if (!part->curl) {
+        fprintf(stderr, "初始化 CURL 失败\n");
+        return ERR_CURL_INIT;
+    }
+
+    const char *lines[] = { "Accept: application/octet-stream", "X-GitHub-Api-Version: 2022-11-28", auth };
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        struct curl_slist *headers = curl_slist_append(part->headers, lines[i]);
+        if (!headers) {
+            fprintf(stderr, "添加header失败\n");
+            return ERR_MEMORY;
         }
+        part->headers = headers;
+    }
 
-        retryCount++;
+    curl_easy_setopt(part->curl, CURLOPT_URL, url);
+    curl_easy_setopt(part->curl, CURLOPT_HTTPHEADER, part->headers);
+    curl_easy_setopt(part->curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(part->curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(part->curl, CURLOPT_WRITEFUNCTION, DownloadWriteCallback);
+    curl_easy_setopt(part->curl, CURLOPT_WRITEDATA, (void *)part);
+    progressAttach(part->curl, &part->progress, part->name, part->size);
+    if (config->deadline > 0 && part->req.retry.deadline == 0) {
+        part->req.retry.deadline = monotonicSeconds() + config->deadline;
+    }
+    applyRequestDeadline(part->curl, part->req.retry.deadline);
 
-        // 检查是否需要重试
-        if (retryCount > maxRetries || !shouldRetryError(lastError)) {
-            break;
-        }
+    if (curl_multi_add_handle(multi, part->curl) != CURLM_OK) {
+        fprintf(stderr, "添加传输任务失败\n");
+        return ERR_CURL_INIT;
+    }
 
-        // 计算指数退避延迟：延迟 = base * 2^retryCount * (1 + 随机值/10)
-        int baseDelay = 1; // 基础延迟：1秒
-        int delay = baseDelay * (1 << (retryCount - 1)); // 指数增长
+    log_debug("开始下载 %s (%" CURL_FORMAT_CURL_OFF_T " bytes，第 %d 次尝试)", part->name,
+              part->size, part->req.retry.attempts + 1);
+    return ERR_OK;
+}
 
-        // 添加随机抖动（避免所有客户端同时重试）
-        int jitter = rand() % (delay / 10 + 1);
-        delay += jitter;
+// 检查已完成的下载：大小必须与 Release 中记录的一致，有预期的 SHA-256 时还要校验内容。
+// 不一致时标记为瞬时故障（part->req.status 已由调用者记录），重新下载
+static ErrorCode finishDownloadPart(DownloadPart *part, CURLcode res) {
+    if (part->writeError != ERR_OK) {
+        return part->writeError;
+    }
+    if (res != CURLE_OK) {
+        fprintf(stderr, "下载 \"%s\" 失败: %s\n", part->name, curl_easy_strerror(res));
+        return ERR_CURL_PERFORM;
+    }
 
-        // 限制最大延迟
-        delay = delay > 30 ? 30 : delay;
+    long response_code = 0;
+    curl_easy_getinfo(part->curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response_code >= 400) {
+        fprintf(stderr, "下载 \"%s\" 失败，HTTP错误: %ld\n", part->name, response_code);
+        return ERR_HTTP_ERROR;
+    }
+    if (part->received != part->size) {
+        fprintf(stderr, "下载 \"%s\" 的大小不符: 收到 %" CURL_FORMAT_CURL_OFF_T " 字节，应为 %"
+                CURL_FORMAT_CURL_OFF_T " 字节\n", part->name, part->received, part->size);
+        part->req.status.transient = 1;
+        return ERR_CURL_PERFORM;
+    }
+    if (!part->sha256[0]) {
+        return ERR_OK;
+    }
+
+    UploadHasher *hasher = part->hasher;
+    part->hasher = NULL;
+    if (hasher) {
+        checksumWait(hasher);
+    }
+    if (!hasher || hasher->hashed != part->size) {
+        log_debug("%s 的流式哈希不完整，从文件中重新读取计算", part->name);
+        freeUploadHasher(hasher);
+        hasher = createUploadHasher(CHECKSUM_SHA256);
+        if (!hasher) {
+            return ERR_MEMORY;
+        }
+        ErrorCode ret = uploadHasherFeedFile(hasher, part->file->tempPath, part->offset, part->size);
+        if (ret != ERR_OK) {
+            freeUploadHasher(hasher);
+            return ret;
+        }
+    }
 
-        log_warn("%s 失败: %d，%d 秒后重试...", opName, lastError, delay);
-        sleep(delay);
+    char actual[SHA256_HEX_SIZE] = {0};
+    formatDigest(hasher->sha256, actual, sizeof(actual));
+    freeUploadHasher(hasher);
+    if (strcasecmp(actual, part->sha256) != 0) {
+        // 按瞬时故障处理：传输中损坏的数据重新下载通常就能恢复
+        fprintf(stderr, "\"%s\" 的 SHA-256 不一致（应为 %s，实际为 %s）\n", part->name, part->sha256, actual);
+        part->req.status.transient = 1;
+        return ERR_CURL_PERFORM;
     }
+    return ERR_OK;
+}
+
+// runMultiRequests 的回调，ctx 是 DownloadBatch
+typedef struct {
+    DownloadPart *parts;
+    int count;
+    const Config *config;
+    int completed;
+    int failed;
+} DownloadBatch;
 
-    log_error("%s 在 %d 次尝试后仍然失败", opName, maxRetries + 1);
-    return ERR_RETRY_EXHAUSTED;
+static int downloadPartCount(void *ctx) {
+    return ((DownloadBatch *)ctx)->count;
 }
 
-// 带重试的操作包装器
-static ErrorCode retryableOperationWrapper(const void *param) {
-    const RetryWrapperParam *wrapperParam = (const RetryWrapperParam *)param;
-    return wrapperParam->operation(wrapperParam->param1, wrapperParam->config);
+static MultiRequest *downloadPartRequest(void *ctx, int index) {
+    return &((DownloadBatch *)ctx)->parts[index].req;
 }
 
-// 重试包装函数：上传文件
-static ErrorCode uploadFileWithRetry(const char *filePath, const Config *config, int maxRetries) {
-    RetryWrapperParam param = {
-        .operation = uploadFile,
-        .param1 = filePath,
-        .config = config,
-        .opName = "文件上传"
-    };
-    const char *fileName = getFilenameFromPath(filePath);
-    log_info("开始上传文件: %s (最多重试 %d 次)", fileName, maxRetries);
-    return performWithRetry(retryableOperationWrapper, &param, maxRetries, fileName);
+static ErrorCode downloadPartStart(CURLM *multi, void *item, void *ctx, CURL **out_curl) {
+    DownloadPart *part = item;
+    ErrorCode result = startDownloadPart(multi, part, ((DownloadBatch *)ctx)->config);
+    *out_curl = part->curl;
+    return result;
 }
 
-// 重试包装函数：删除文件
-static ErrorCode deleteFileWithRetry(const char *fileName, const Config *config, int maxRetries) {
-    RetryWrapperParam param = {
-        .operation = deleteFile,
-        .param1 = fileName,
-        .config = config,
-        .opName = "文件删除"
-    };
-    log_info("开始删除文件: %s (最多重试 %d 次)", fileName, maxRetries);
-    return performWithRetry(retryableOperationWrapper, &param, maxRetries, fileName);
+// 先清除进度行再输出错误信息
+static ErrorCode downloadPartFinish(void *item, CURLcode res, void *ctx) {
+    (void)ctx;
+    progressClear();
+    return finishDownloadPart(item, res);
 }
 
-// 重试包装函数：更新文件
-static ErrorCode updateFileWithRetry(const char *filePath, const Config *config, int maxRetries) {
-    RetryWrapperParam param = {
-        .operation = updateFile,
-        .param1 = filePath,
-        .config = config,
-        .opName = "文件更新"
-    };
-    const char *fileName = getFilenameFromPath(filePath);
-    log_info("开始更新文件: %s (最多重试 %d 次)", fileName, maxRetries);
-    return performWithRetry(retryableOperationWrapper, &param, maxRetries, fileName);
+static void downloadPartRelease(CURLM *multi, void *item) {
+    releaseDownloadAttempt(multi, item);
 }
 
-// 创建新的 GitHub Release，返回新创建的 release_id（动态分配）
-static ErrorCode createRelease(const char *tag_name, const char *release_name, const char *description,
-                               int is_prerelease, const Config *config, char **out_release_id) {
-    // 验证配置（跳过 release_id 检查，因为创建 release 时 release_id 还未生成）
-    if (!config) {
-        log_error("配置为空");
-        return ERR_CONFIG;
-    }
+static ErrorCode downloadPartDone(void *item, ErrorCode result, void *ctx) {
+    DownloadPart *part = item;
+    DownloadBatch *batch = ctx;
+
+    progressFileDone(&part->progress, result == ERR_OK);
+    progressClear();
+    part->result = result;
+    batch->completed++;
+    if (result == ERR_OK) {
+        printf("[%d/%d] ✅ \"%s\" 下载完成 (%" CURL_FORMAT_CURL_OFF_T " bytes)\n",
+               batch->completed, batch->count, part->name, part->size);
+        return ERR_OK;
+    }
+    if (part->file) part->file->failed++;
+    batch->failed++;
+    printf("[%d/%d] ❌ \"%s\" 下载失败\n", batch->completed, batch->count, part->name);
+    return ERR_OK;
+}
 
-    if (!config->token) {
-        log_error("未设置 token");
-        return ERR_CONFIG;
-    }
+// 下载引擎：用 runMultiRequests 执行下载请求，同时最多 config->concurrency 个，
+// 失败的请求按照 planRetry 的重试策略重新排队；写文件失败等本地错误不重试
+static ErrorCode runDownloadParts(DownloadPart *parts, int count, const Config *config) {
+    DownloadBatch batch = { .parts = parts, .count = count, .config = config };
+    int concurrency = config->concurrency < count ? config->concurrency : count;
+
+    MultiRequestOps ops = {
+        .ctx = &batch,
+        .concurrency = concurrency,
+        .count = downloadPartCount,
+        .request = downloadPartRequest,
+        .start = downloadPartStart,
+        .finish = downloadPartFinish,
+        .release = downloadPartRelease,
+        .done = downloadPartDone,
+    };
 
-    if (!config->owner) {
-        log_error("未设置 owner");
-        return ERR_CONFIG;
+    // --limit-rate 只限制上传，下载不参与令牌分配
+    progressBegin(config, 0);
+    for (int i = 0; i < count; i++) {
+        parts[i].req.item = &parts[i];
+        parts[i].req.label = parts[i].name;
+        progressPlan(&parts[i].progress, parts[i].size);
     }
 
-    if (!config->repo) {
-        log_error("未设置 repo");
-        return ERR_CONFIG;
+    ErrorCode result = runMultiRequests(&ops);
+    progressEnd();
+    if (result != ERR_OK) {
+        return result;
     }
+    return (batch.failed == 0) ? ERR_OK : ERR_CURL_PERFORM;
+}
 
-    if (!tag_name) {
-        log_error("tag_name 不能为空");
-        return ERR_CONFIG;
+// 读取并检查下载到的分片清单：每个分片都要在 Release 中存在且大小一致，
+// 分片依次首尾相接，合起来正好是原文件的大小
+static ErrorCode loadSplitManifest(DownloadFile *file, const DownloadPart *manifestPart, const ReleaseCache *cache) {
+    struct json_object *root = json_tokener_parse(manifestPart->buffer.data ? manifestPart->buffer.data : "");
+    struct json_object *sizeObj = NULL;
+    struct json_object *parts = NULL;
+    if (!root || !json_object_object_get_ex(root, "size", &sizeObj) ||
+        !json_object_object_get_ex(root, "parts", &parts) || !json_object_is_type(parts, json_type_array)) {
+        fprintf(stderr, "分片清单 %s 格式无效\n", manifestPart->name);
+        json_object_put(root);
+        return ERR_JSON_PARSE;
+    }
+
+    curl_off_t size = (curl_off_t)json_object_get_int64(sizeObj);
+    curl_off_t expectedOffset = 0;
+    size_t count = json_object_array_length(parts);
+    for (size_t k = 0; k < count; k++) {
+        struct json_object *part = json_object_array_get_idx(parts, k);
+        struct json_object *field = NULL;
+        const char *name = json_object_object_get_ex(part, "name", &field) ? json_object_get_string(field) : NULL;
+        curl_off_t offset = json_object_object_get_ex(part, "offset", &field) ? json_object_get_int64(field) : -1;
+        curl_off_t partSize = json_object_object_get_ex(part, "size", &field) ? json_object_get_int64(field) : -1;
+        const char *sha256 = json_object_object_get_ex(part, "sha256", &field) ? json_object_get_string(field) : NULL;
+        ReleaseAsset *asset = name ? releaseCacheFind(cache, name) : NULL;
+
+        if (!name || !sha256 || strlen(sha256) != SHA256_HEX_SIZE - 1 || offset != expectedOffset || partSize <= 0) {
+            fprintf(stderr, "分片清单 %s 中第 %zu 个分片的信息无效\n", manifestPart->name, k);
+            json_object_put(root);
+            return ERR_JSON_TYPE;
+        }
+        if (!asset || asset->size != partSize) {
+            fprintf(stderr, "Release 中缺少分片 \"%s\" 或大小与清单不符\n", name);
+            json_object_put(root);
+            return ERR_NOT_FOUND;
+        }
+        expectedOffset += partSize;
     }
-
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    struct MemoryStruct chunk = {NULL, 0};
-    struct json_object *json_request = NULL;
-    char *url = NULL;
-    char *post_data = NULL;
-    ErrorCode result = ERR_OK;
-
-    // 构建请求体
-    json_request = json_object_new_object();
-    if (!json_request) {
-        log_error("创建 JSON 对象失败");
-        result = ERR_MEMORY;
-        goto cleanup;
+    if (count == 0 || expectedOffset != size) {
+        fprintf(stderr, "分片清单 %s 中分片的总大小与文件大小不符\n", manifestPart->name);
+        json_object_put(root);
+        return ERR_JSON_TYPE;
     }
 
-    json_object_object_add(json_request, "tag_name", json_object_new_string(tag_name));
+    file->manifest = root;
+    file->size = size;
+    file->parts = (int)count;
+    return ERR_OK;
+}
 
-    // 如果提供了 release_name，则使用它，否则使用 tag_name
-    if (release_name && strlen(release_name) > 0) {
-        json_object_object_add(json_request, "name", json_object_new_string(release_name));
-    } else {
-        json_object_object_add(json_request, "name", json_object_new_string(tag_name));
+// 创建下载用的临时文件并预先分配空间，各分片的数据写入各自的位置
+static ErrorCode openDownloadFile(DownloadFile *file) {
+    file->fd = open(file->tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0) {
+        fprintf(stderr, "无法创建文件: %s (%s)\n", file->tempPath, strerror(errno));
+        return ERR_FILE_IO;
     }
-
-    // 添加描述
-    if (description && strlen(description) > 0) {
-        json_object_object_add(json_request, "body", json_object_new_string(description));
-    } else {
-        json_object_object_add(json_request, "body", json_object_new_string("Release created by manage tool"));
+    if (file->size == 0) {
+        return ERR_OK;
     }
 
-    // 是否为预发布
-    json_object_object_add(json_request, "prerelease", json_object_new_boolean(is_prerelease));
+    int err = posix_fallocate(file->fd, 0, (off_t)file->size);
+    if (err == EINVAL || err == EOPNOTSUPP) {
+        // 文件系统不支持预分配时退回到设置文件大小
+        err = (ftruncate(file->fd, (off_t)file->size) == 0) ? 0 : errno;
+    }
+    if (err != 0) {
+        fprintf(stderr, "无法为 %s 分配 %" CURL_FORMAT_CURL_OFF_T " 字节: %s\n",
+                file->tempPath, file->size, strerror(err));
+        return ERR_FILE_IO;
+    }
+    return ERR_OK;
+}
 
-    // 设置为公开或私有（默认公开）
-    json_object_object_add(json_request, "draft", json_object_new_boolean(0));
+// download：从 Release 并发下载文件。用 --split 上传的文件（存在 <文件名>.parts.json）
+// 先下载清单，再并发下载全部分片写入同一个文件，每个分片按清单中的 SHA-256 校验；
+// 普通资产在 GitHub 提供了 digest 时同样校验
+static ErrorCode downloadAssets(int argc, char **argv, const Config *base) {
+    Config config = *base;
+    const char *outputDir = ".";
+    const char **names = NULL;
+    int nameCount = 0;
+    DownloadFile *files = NULL;
+    DownloadPart *manifests = NULL;
+    int manifestCount = 0;
+    DownloadPart *parts = NULL;
+    int partCount = 0;
+    int succeeded = 0;
+    ReleaseCache *cache = NULL;
+    ErrorCode result = ERR_OK;
 
-    // 获取 JSON 字符串
-    const char *json_str = json_object_to_json_string(json_request);
-    if (!json_str) {
-        log_error("生成 JSON 字符串失败");
-        result = ERR_JSON_PARSE;
+    names = calloc(argc > 0 ? argc : 1, sizeof(const char *));
+    if (!names) {
+        fprintf(stderr, "内存分配失败\n");
+        return ERR_MEMORY;
+    }
+    for (int i = 0; i < argc; i++) {
+        int transferArgs = parseTransferOption(argc, argv, i, &config);
+        if (transferArgs < 0) {
+            result = ERR_CONFIG;
+            goto cleanup;
+        }
+        if (transferArgs > 0) {
+            i += transferArgs - 1; // 跳过选项的参数
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            int concurrency = (i + 1 < argc) ? parseConcurrency(argv[i + 1]) : -1;
+            if (concurrency < 0) {
+                fprintf(stderr, "错误：-j 或 --jobs 需要一个 1-%d 之间的整数\n", MAX_CONCURRENCY);
+                result = ERR_CONFIG;
+                goto cleanup;
+            }
+            config.concurrency = concurrency;
+            i++; // 跳过下一个参数
+        } else if (strcmp(argv[i], "--deadline") == 0) {
+            double deadline = (i + 1 < argc) ? parseDeadline(argv[i + 1]) : -1;
+            if (deadline < 0) {
+                fprintf(stderr, "错误：--deadline 需要一个非负的秒数\n");
+                result = ERR_CONFIG;
+                goto cleanup;
+            }
+            config.deadline = deadline;
+            i++; // 跳过下一个参数
+        } else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误：-o 或 --output 需要一个目录\n");
+                result = ERR_CONFIG;
+                goto cleanup;
+            }
+            outputDir = argv[++i];
+        } else if (strchr(argv[i], '/')) {
+            fprintf(stderr, "错误：\"%s\" 不是有效的文件名\n", argv[i]);
+            result = ERR_INVALID_PATH;
+            goto cleanup;
+        } else {
+            names[nameCount++] = argv[i];
+        }
+    }
+    if (nameCount == 0) {
+        fprintf(stderr, "错误：请提供要下载的文件名。\n");
+        result = ERR_CONFIG;
         goto cleanup;
     }
 
-    // 复制 JSON 字符串以便 curl 使用
-    post_data = strdup(json_str);
-    if (!post_data) {
-        log_error("内存分配失败");
-        result = ERR_MEMORY;
+    if (validate_config(&config) != ERR_OK) {
+        result = ERR_CONFIG;
         goto cleanup;
     }
-
-    // 创建 URL
-    url = create_url("https://api.github.com/repos/%s/%s/releases", config->owner, config->repo);
-    if (!url) {
-        log_error("URL 分配失败");
-        result = ERR_MEMORY;
+    result = ensureReleaseCache(&config, &cache);
+    if (result != ERR_OK) {
         goto cleanup;
     }
 
-    curl = curl_easy_init();
-    if (!curl) {
-        log_error("初始化 CURL 失败");
-        result = ERR_CURL_INIT;
+    files = calloc(nameCount, sizeof(DownloadFile));
+    manifests = calloc(nameCount, sizeof(DownloadPart));
+    if (!files || !manifests) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
         goto cleanup;
     }
 
-    headers = setGithubHeaders(config->token, "application/json");
-
-    // 设置 POST 数据
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(post_data));
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-    printf("正在创建新的 Release，标签: %s...\n", tag_name);
+    // 确定每个文件是分片上传的还是普通资产，开始传输前就报告找不到的文件
+    for (int i = 0; i < nameCount; i++) {
+        DownloadFile *file = &files[i];
+        file->name = names[i];
+        file->fd = -1;
+        file->parts = 1;
+
+        const char *manifestName = arenaPrintf(commandArena(&config), "%s" SPLIT_MANIFEST_SUFFIX, file->name);
+        ReleaseAsset *manifestAsset = manifestName ? releaseCacheFind(cache, manifestName) : NULL;
+        if (manifestAsset) {
+            DownloadPart *manifest = &manifests[manifestCount++];
+            manifest->name = manifestAsset->name;
+            manifest->assetId = manifestAsset->id;
+            manifest->size = (curl_off_t)manifestAsset->size;
+            // 标记该文件需要按清单下载，清单在 manifests 中的位置
+            file->parts = -manifestCount;
+            continue;
+        }
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "创建 Release 失败: %s\n", curl_easy_strerror(res));
-        result = ERR_CURL_PERFORM;
-        goto cleanup;
+        ReleaseAsset *asset = releaseCacheFind(cache, file->name);
+        if (!asset) {
+            fprintf(stderr, "错误：Release 中找不到文件 \"%s\"\n", file->name);
+            result = ERR_NOT_FOUND;
+            goto cleanup;
+        }
+        file->size = (curl_off_t)asset->size;
     }
 
-    // 检查 HTTP 响应码
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    if (response_code >= 400) {
-        log_error("创建 Release 失败，HTTP错误: %ld", response_code);
-        log_error("响应内容: %s", chunk.memory);
-        result = ERR_HTTP_ERROR;
-        goto cleanup;
+    if (manifestCount > 0) {
+        printf("下载 %d 个分片清单...\n", manifestCount);
+        result = runDownloadParts(manifests, manifestCount, &config);
+        if (result != ERR_OK) {
+            goto cleanup;
+        }
+        for (int i = 0; i < nameCount; i++) {
+            if (files[i].parts >= 0) continue;
+            result = loadSplitManifest(&files[i], &manifests[-files[i].parts - 1], cache);
+            if (result != ERR_OK) {
+                goto cleanup;
+            }
+        }
+        printf("\n");
     }
 
-    // 解析响应以获取新创建的 Release 信息
-    struct json_object *response = json_tokener_parse(chunk.memory);
-    if (!response) {
-        log_error("解析创建 Release 的响应失败");
-        result = ERR_JSON_PARSE;
-        goto cleanup;
+    for (int i = 0; i < nameCount; i++) {
+        partCount += files[i].parts;
     }
-
-    struct json_object *id_obj;
-    if (!json_object_object_get_ex(response, "id", &id_obj) ||
-        !json_object_is_type(id_obj, json_type_int)) {
-        log_error("无法从响应中获取 release id");
-        result = ERR_JSON_TYPE;
+    parts = calloc(partCount, sizeof(DownloadPart));
+    if (!parts) {
+        fprintf(stderr, "内存分配失败\n");
+        result = ERR_MEMORY;
         goto cleanup;
     }
 
-    int id_value = json_object_get_int(id_obj);
-    struct json_object *tag_obj;
-    const char *created_tag = tag_name;
-    if (json_object_object_get_ex(response, "tag_name", &tag_obj) &&
-        json_object_is_type(tag_obj, json_type_string)) {
-        created_tag = json_object_get_string(tag_obj);
-    }
-
-    // 将 release_id 返回给调用者
-    if (out_release_id) {
-        char temp_id[32];
-        snprintf(temp_id, sizeof(temp_id), "%d", id_value);
-        *out_release_id = strdup(temp_id);
-        if (!*out_release_id) {
-            log_error("内存分配失败");
+    partCount = 0;
+    for (int i = 0; i < nameCount; i++) {
+        DownloadFile *file = &files[i];
+        file->path = arenaPrintf(commandArena(&config), "%s/%s", outputDir, file->name);
+        file->tempPath = arenaPrintf(commandArena(&config), "%s/%s" DOWNLOAD_TEMP_SUFFIX, outputDir, file->name);
+        if (!file->path || !file->tempPath) {
+            fprintf(stderr, "内存分配失败\n");
             result = ERR_MEMORY;
             goto cleanup;
         }
+        result = openDownloadFile(file);
+        if (result != ERR_OK) {
+            goto cleanup;
+        }
+
+        if (!file->manifest) {
+            ReleaseAsset *asset = releaseCacheFind(cache, file->name);
+            const char *sha256 = parseSha256Tag(asset->digest);
+            DownloadPart *part = &parts[partCount++];
+            part->name = asset->name;
+            part->assetId = asset->id;
+            part->file = file;
+            part->size = file->size;
+            if (sha256) memcpy(part->sha256, sha256, SHA256_HEX_SIZE);
+            continue;
+        }
+
+        printf("%s: %" CURL_FORMAT_CURL_OFF_T " 字节，%d 个分片\n", file->name, file->size, file->parts);
+        struct json_object *list = NULL;
+        json_object_object_get_ex(file->manifest, "parts", &list);
+        for (int k = 0; k < file->parts; k++) {
+            struct json_object *entry = json_object_array_get_idx(list, k);
+            struct json_object *field = NULL;
+            DownloadPart *part = &parts[partCount++];
+            json_object_object_get_ex(entry, "name", &field);
+            ReleaseAsset *asset = releaseCacheFind(cache, json_object_get_string(field));
+            part->name = asset->name;
+            part->assetId = asset->id;
+            part->file = file;
+            part->size = (curl_off_t)asset->size;
+            json_object_object_get_ex(entry, "offset", &field);
+            part->offset = (curl_off_t)json_object_get_int64(field);
+            json_object_object_get_ex(entry, "sha256", &field);
+            snprintf(part->sha256, sizeof(part->sha256), "%s", json_object_get_string(field));
+        }
     }
 
-    printf("✅ Release 创建成功!\n");
-    printf("   - 标签: %s\n", created_tag);
-    printf("   - ID: %d\n", id_value);
+    printf("开始下载 %d 个文件（%d 个请求，并发 %d）...\n", nameCount, partCount, config.concurrency);
+    result = runDownloadParts(parts, partCount, &config);
 
-cleanup:
-    if (response) json_object_put(response);
-    if (post_data) free(post_data);
-    if (json_request) json_object_put(json_request);
-    if (chunk.memory) free(chunk.memory);
-    if (headers) curl_slist_free_all(headers);
-    if (curl) curl_easy_cleanup(curl);
-    if (url) free(url);
+    // 全部分片成功的文件改为正式文件名，其余删除临时文件
+    for (int i = 0; i < nameCount; i++) {
+        DownloadFile *file = &files[i];
+        if (close(file->fd) != 0 && file->failed == 0) {
+            fprintf(stderr, "写入文件失败: %s (%s)\n", file->tempPath, strerror(errno));
+            file->failed++;
+        }
+        file->fd = -1;
+        if (file->failed == 0 && rename(file->tempPath, file->path) != 0) {
+            fprintf(stderr, "无法重命名 %s: %s\n", file->tempPath, strerror(errno));
+            file->failed++;
+        }
+        if (file->failed == 0) {
+            succeeded++;
+        } else {
+            unlink(file->tempPath);
+            if (result == ERR_OK) result = ERR_FILE_IO;
+        }
+    }
+    printf("\n下载完成: %d 个成功, %d 个失败\n", succeeded, nameCount - succeeded);
 
+cleanup:
+    if (files) {
+        for (int i = 0; i < nameCount; i++) {
+            if (files[i].fd >= 0) {
+                close(files[i].fd);
+                unlink(files[i].tempPath);
+            }
+            json_object_put(files[i].manifest);
+        }
+    }
+    if (manifests) {
+        for (int i = 0; i < manifestCount; i++) {
+            responseBufferFree(&manifests[i].buffer);
+        }
+    }
+    for (int i = 0; i < partCount && parts; i++) {
+        responseBufferFree(&parts[i].buffer);
+    }
+    free(parts);
+    free(manifests);
+    free(files);
+    free(names);
     return result;
 }